@@ -0,0 +1,319 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Замеры масштабируемости.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Benchmark.h"
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+#include <Common/Arena.h>
+#include <Common/Grouping.h>
+#include <Common/Islands.h>
+#include <Common/ObjReader.h>
+#include <Common/ObjWriter.h>
+#include <Common/Platform.h>
+#include <Common/ThreadPool.h>
+#include <Common/Topology.h>
+
+namespace
+{
+    /// Приблизительный объем памяти на один полигон (текст, меш, разбиение, результат)
+    const double ESTIMATED_BYTES_PER_FACE = 400.0;
+
+    /**
+     * Этап обработки
+     */
+    enum Stage
+    {
+        // Чтение полигонов из текста
+        eParse,
+        // Разбиение на группы
+        eGroup,
+        // Формирование результирующих файлов
+        eExport,
+        // Раскраска графа смежности островов (смежность полигонов, граф, раскраска)
+        eColor,
+        // Кол-во этапов
+        eStageCount
+    };
+
+    /// Имена этапов
+    const char* const STAGE_NAMES[eStageCount] = {"parse", "group", "export", "color"};
+
+    /**
+     * \brief Результат замера одного этапа в одной конфигурации
+     */
+    struct Measurement
+    {
+        double seconds = 0.0;
+        double bytes = 0.0;
+        size_t peakRss = 0;
+    };
+
+    /**
+     * \brief Результаты всех этапов в одной конфигурации
+     */
+    struct Configuration
+    {
+        unsigned faces = 0;
+        unsigned threads = 0;
+        Measurement stages[eStageCount];
+        /// Кол-во островов и цветов их раскраски
+        unsigned islands = 0;
+        unsigned colors = 0;
+    };
+
+    /**
+     * \brief Сгенерировать меш и его текст в формате .obj
+     */
+    std::string MakeObjText(unsigned faceCount, ThreadPool& pool, unsigned& actualFaces)
+    {
+        std::mt19937 rng(faceCount);
+        MeshGeneratorSettings meshSettings;
+        meshSettings.kind = eGridIslands;
+        meshSettings.faceCount = faceCount;
+        const Mesh mesh = GenerateMesh(rng, meshSettings);
+        actualFaces = mesh.faceCount();
+
+        unsigned posCount = 0, uvCount = 0;
+        for(const auto& v : mesh.vertices){
+            posCount = std::max(posCount, v.posIdx);
+            uvCount = std::max(uvCount, v.uvIdx);
+        }
+
+        // Основные данные (содержимое строк не важно, важен их объем)
+        TextLines baseData;
+        baseData.reserve(posCount + uvCount + 8);
+        for(unsigned i = 0; i < posCount; i++) baseData.emplace_back("v " + std::to_string(i % 1000) + ".250000 -1.500000 0.750000");
+        for(unsigned i = 0; i < uvCount; i++) baseData.emplace_back("vt 0." + std::to_string(i % 1000) + " 0.500000");
+        for(unsigned i = 0; i < 8; i++) baseData.emplace_back("vn 0.000000 1.000000 0.000000");
+
+        // Все полигоны в одной группе
+        GroupMembers members;
+        members.offsets = {0, mesh.faceCount()};
+        members.polygons.resize(mesh.faceCount());
+        std::iota(members.polygons.begin(), members.polygons.end(), 0u);
+
+        return std::string(FormatObjText("bench.mtl", baseData, mesh, members, pool));
+    }
+
+    /**
+     * \brief Замерить все этапы в одной конфигурации
+     */
+    Configuration Measure(const std::string& text, unsigned faces, unsigned threads, const BenchmarkSettings& settings)
+    {
+        const GroupingEngine& engine = *FindGroupingEngine(settings.engine);
+        ThreadPool pool(threads);
+
+        // Арена переиспользуется всеми повторами (как при обработке нескольких файлов подряд)
+        Arena arena(settings.hugePages);
+
+        Configuration config;
+        config.faces = faces;
+        config.threads = threads;
+
+        for(unsigned r = 0; r < std::max(1u, settings.repeat); r++)
+        {
+            // Данные предыдущего повтора уже уничтожены, их память освобождается разом
+            arena.release();
+
+            Mesh mesh(&arena);
+            Partition partition(&arena);
+            GroupMembers members(&arena);
+            std::pmr::string objText(&arena);
+            std::string mtlText;
+
+            for(unsigned s = 0; s < eStageCount; s++)
+            {
+                ResetPeakResidentMemory();
+                const auto start = std::chrono::steady_clock::now();
+
+                double bytes = 0.0;
+                switch(s)
+                {
+                    case eParse:
+                    {
+                        // Как при обработке файла: предварительный проход, затем чтение по его итогам
+                        const ObjScan scan = ScanObjFile(text.data(), text.size(), pool);
+                        ReadPolygons(text.data(), text.size(), scan, mesh, pool);
+                        bytes = static_cast<double>(text.size());
+                        break;
+                    }
+                    case eGroup:
+                        partition = engine.divide(mesh, pool);
+                        members = CollectGroupMembers(partition);
+                        bytes = static_cast<double>(mesh.vertices.size() * sizeof(Vertex) + mesh.faceOffsets.size() * sizeof(unsigned));
+                        break;
+                    case eExport:
+                        objText = FormatObjText("bench.mtl", {}, mesh, members, pool);
+                        mtlText = FormatMtlText(members.groupCount());
+                        bytes = static_cast<double>(objText.size() + mtlText.size());
+                        break;
+                    default:
+                    {
+                        MeshTopology<unsigned> topology(mesh, pool);
+                        const IslandGraph graph = BuildIslandGraph(mesh, members, topology, pool);
+                        const IslandColoring coloring = ColorIslands(members, graph, 0.0f, Coordinates(), {}, pool);
+                        config.islands = members.groupCount();
+                        config.colors = coloring.colorCount;
+                        bytes = static_cast<double>(mesh.vertices.size() * sizeof(Vertex) + graph.neighbours.size() * sizeof(unsigned) * 2);
+                        break;
+                    }
+                }
+
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                Measurement& m = config.stages[s];
+                m.seconds = r == 0 ? seconds : std::min(m.seconds, seconds);
+                m.bytes = bytes;
+                m.peakRss = std::max(m.peakRss, PeakResidentMemory());
+            }
+        }
+
+        return config;
+    }
+
+    /**
+     * \brief Хватит ли памяти на конфигурацию
+     */
+    bool FitsInMemory(unsigned faces)
+    {
+        const double physical = static_cast<double>(PhysicalMemory());
+        return physical <= 0.0 || static_cast<double>(faces) * ESTIMATED_BYTES_PER_FACE < physical * 0.75;
+    }
+
+    /**
+     * \brief Записать строки результатов (в .csv и в сводную таблицу)
+     * \param scaling Вид масштабируемости ("strong" либо "weak")
+     * \param configs Конфигурации (первая - базовая, с наименьшим кол-вом потоков)
+     */
+    void Report(const char* scaling, const std::vector<Configuration>& configs, std::ofstream& csv)
+    {
+        if(configs.empty()) return;
+        const Configuration& base = configs.front();
+
+        for(unsigned s = 0; s < eStageCount; s++)
+        {
+            for(const auto& config : configs)
+            {
+                const Measurement& m = config.stages[s];
+                const Measurement& b = base.stages[s];
+                const double facesPerSecond = m.seconds > 0.0 ? config.faces / m.seconds : 0.0;
+                const double mbPerSecond = m.seconds > 0.0 ? m.bytes / m.seconds / (1024.0 * 1024.0) : 0.0;
+                const double baseFacesPerSecond = b.seconds > 0.0 ? base.faces / b.seconds : 0.0;
+
+                // Ускорение - отношение пропускной способности к базовой, эффективность - ускорение на поток
+                const double speedup = baseFacesPerSecond > 0.0 ? facesPerSecond / baseFacesPerSecond : 0.0;
+                const double threadRatio = static_cast<double>(config.threads) / base.threads;
+                const double efficiency = speedup / threadRatio;
+                const double peakMb = static_cast<double>(m.peakRss) / (1024.0 * 1024.0);
+
+                csv << scaling << "," << STAGE_NAMES[s] << "," << config.faces << "," << config.threads << ","
+                    << m.seconds << "," << facesPerSecond << "," << mbPerSecond << "," << speedup << ","
+                    << efficiency << "," << peakMb << "\n";
+
+                std::cout << std::left << std::setw(8) << scaling << std::setw(8) << STAGE_NAMES[s] << std::right
+                          << std::setw(12) << config.faces << std::setw(9) << config.threads
+                          << std::fixed << std::setprecision(2)
+                          << std::setw(12) << m.seconds * 1000.0
+                          << std::setw(11) << facesPerSecond / 1e6
+                          << std::setw(10) << std::setprecision(1) << mbPerSecond
+                          << std::setw(9) << std::setprecision(2) << speedup
+                          << std::setw(8) << std::setprecision(0) << efficiency * 100.0 << "%"
+                          << std::setw(11) << std::setprecision(1) << peakMb << std::endl;
+            }
+        }
+    }
+}
+
+int RunBenchmark(const BenchmarkSettings& settings)
+{
+    if(!FindGroupingEngine(settings.engine)){
+        std::cout << "Unknown engine \"" << settings.engine << "\"." << std::endl;
+        return 1;
+    }
+
+    // Кол-ва потоков (всегда включая один поток - база для расчета эффективности)
+    std::vector<unsigned> threadCounts = settings.threadCounts;
+    if(threadCounts.empty()){
+        for(unsigned t = 1; t <= ThreadPool::hardwareThreads(); t++) threadCounts.push_back(t);
+    }
+    threadCounts.push_back(1);
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+    threadCounts.erase(std::remove(threadCounts.begin(), threadCounts.end(), 0u), threadCounts.end());
+
+    // Размеры мешей
+    std::vector<unsigned> sizes;
+    for(unsigned long long faces = std::max(1u, settings.minFaces); faces <= settings.maxFaces; faces *= 10){
+        sizes.push_back(static_cast<unsigned>(faces));
+    }
+
+    std::ofstream csv(settings.csvPath, std::ios::out | std::ios::trunc);
+    if(csv.fail()){
+        std::cout << "Can't open file \"" << settings.csvPath << "\" for writing." << std::endl;
+        return 1;
+    }
+    csv << "scaling,stage,faces,threads,seconds,faces_per_s,mb_per_s,speedup,efficiency,peak_rss_mb\n";
+
+    const bool peakResettable = ResetPeakResidentMemory();
+    std::cout << "Engine \"" << settings.engine << "\", best of " << std::max(1u, settings.repeat) << " runs, "
+              << ThreadPool::hardwareThreads() << " hardware threads" << std::endl;
+    if(!peakResettable) std::cout << "Note: peak RSS can't be reset on this platform, values are process-wide maximums" << std::endl;
+    std::cout << std::endl << std::left << std::setw(8) << "scaling" << std::setw(8) << "stage" << std::right
+              << std::setw(12) << "faces" << std::setw(9) << "threads" << std::setw(12) << "time, ms"
+              << std::setw(11) << "Mfaces/s" << std::setw(10) << "MB/s" << std::setw(9) << "speedup"
+              << std::setw(9) << "eff." << std::setw(11) << "peak, MB" << std::endl;
+
+    ThreadPool generatorPool;
+
+    // Сильная масштабируемость - фиксированный размер, растет кол-во потоков
+    for(unsigned faces : sizes)
+    {
+        if(!FitsInMemory(faces)){
+            std::cout << "strong  skipped " << faces << " faces (not enough physical memory)" << std::endl;
+            continue;
+        }
+
+        unsigned actualFaces = 0;
+        const std::string text = MakeObjText(faces, generatorPool, actualFaces);
+
+        std::vector<Configuration> configs;
+        for(unsigned threads : threadCounts) configs.push_back(Measure(text, actualFaces, threads, settings));
+        Report("strong", configs, csv);
+        std::cout << "color   " << actualFaces << " faces: " << configs.front().islands << " islands, "
+                  << configs.front().colors << " colors" << std::endl;
+    }
+
+    // Слабая масштабируемость - размер растет вместе с кол-вом потоков
+    if(settings.weakFacesPerThread > 0)
+    {
+        std::vector<Configuration> configs;
+        for(unsigned threads : threadCounts)
+        {
+            const unsigned long long faces = static_cast<unsigned long long>(settings.weakFacesPerThread) * threads;
+            if(faces > 0xffffffffull){
+                std::cout << "weak    skipped " << faces << " faces (more than 2^32 - 1 faces)" << std::endl;
+                break;
+            }
+            if(!FitsInMemory(static_cast<unsigned>(faces))){
+                std::cout << "weak    skipped " << faces << " faces (not enough physical memory)" << std::endl;
+                break;
+            }
+
+            unsigned actualFaces = 0;
+            const std::string text = MakeObjText(static_cast<unsigned>(faces), generatorPool, actualFaces);
+            configs.push_back(Measure(text, actualFaces, threads, settings));
+        }
+        Report("weak", configs, csv);
+    }
+
+    std::cout << std::endl << "Results written to \"" << settings.csvPath << "\"" << std::endl;
+    return 0;
+}
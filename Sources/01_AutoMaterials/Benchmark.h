@@ -0,0 +1,45 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Замеры масштабируемости.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * \brief Параметры замеров
+ */
+struct BenchmarkSettings
+{
+    /// Кол-ва потоков (пусто - от 1 до кол-ва аппаратных потоков)
+    std::vector<unsigned> threadCounts;
+    /// Наименьший размер меша (полигонов), размеры растут в 10 раз
+    unsigned minFaces = 10000;
+    /// Наибольший размер меша (полигонов)
+    unsigned maxFaces = 100000000;
+    /// Размер меша на один поток для замеров слабой масштабируемости (0 - не замерять)
+    unsigned weakFacesPerThread = 1000000;
+    /// Кол-во повторов каждого замера (берется лучшее время)
+    unsigned repeat = 3;
+    /// Алгоритм разбиения на группы
+    std::string engine = "parallel";
+    /// Выделять арену данных на огромных страницах
+    bool hugePages = false;
+    /// Путь к .csv файлу с результатами
+    std::string csvPath = "bench.csv";
+};
+
+/**
+ * \brief Замерить масштабируемость этапов чтения, разбиения на группы и формирования результата
+ *
+ * \details Сильная масштабируемость - каждый размер меша при каждом кол-ве потоков, слабая - размер меша растет
+ * пропорционально кол-ву потоков. Для каждой конфигурации записывается время, пропускная способность
+ * (полигонов/с, МБ/с), эффективность и пиковый объем резидентной памяти этапа. Результаты пишутся в .csv файл,
+ * сводная таблица выводится в консоль
+ *
+ * \param settings Параметры замеров
+ * \return Код выполнения
+ */
+int RunBenchmark(const BenchmarkSettings& settings);
@@ -3,277 +3,908 @@
  * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
  */
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <iostream>
 #include <fstream>
+#include <limits>
 #include <string>
-#include <sstream>
 #include <vector>
-#include <unordered_set>
-#include <algorithm>
+
+#include <Common/Arena.h>
+#include <Common/Cpu.h>
+#include <Common/ExternalMemory.h>
+#include <Common/Geometry.h>
+#include <Common/Mesh.h>
+#include <Common/Grouping.h>
+#include <Common/Islands.h>
+#include <Common/NormalSplit.h>
+#include <Common/ObjReader.h>
+#include <Common/ObjWriter.h>
+#include <Common/Objects.h>
+#include <Common/Overlap.h>
+#include <Common/VertexCache.h>
+#include <Common/Platform.h>
+#include <Common/Stats.h>
+#include <Common/ThreadPool.h>
+#include <Common/Topology.h>
+#include <Common/Welding.h>
+
+#include "Benchmark.h"
+#include "Verify.h"
 
 /**
- * \brief Структура описывающая вершину
- *
- * \details Основной критений сравнения вершин - положение и текстурные координаты. Не обязательно хранить сами данные,
- * достаточно значть что индексы положения и текстурных координат совпадают
+ * \brief Параметры запуска
  */
-struct Vertex
+struct Options
 {
-    unsigned posIdx = 0;
-    unsigned uvIdx = 0;
-    unsigned normalIdx = 0;
-
-    bool operator==(const Vertex& v) const{
-        return this->posIdx == v.posIdx && this->uvIdx == v.uvIdx;
-    }
-
-    struct Hash
-    {
-        size_t operator()(const Vertex& v) const{
-            return std::hash<std::string>()(std::to_string(v.posIdx) + std::to_string(v.uvIdx));
-        }
-    };
+    /// Путь к исходному файлу
+    std::string inputFile;
+    /// Имя выходного файла (без расширения)
+    std::string outputFilename = "output";
+    /// Алгоритм разбиения на группы
+    std::string engine = "parallel";
+    /// Правило связности полигонов группы ("vertex" - общая вершина, "edge" - общее ребро)
+    std::string connectivity = "vertex";
+    /// Разбивать на группы отдельно внутри каждого объекта ("o"/"g")
+    bool perObject = false;
+    /// Наибольший угол между нормалями полигонов группы, градусов (0 - не проверять)
+    unsigned maxNormalAngle = 0;
+    /// Присоединять к соседям острова не больше заданного кол-ва полигонов (0 - не присоединять)
+    unsigned mergeMaxFaces = 0;
+    /// Присоединять к соседям острова с площадью развертки меньше заданной, доля текстуры (0 - не присоединять)
+    float mergeMaxUvArea = 0.0f;
+    /// Поиск островов с одинаковой разверткой ("report" - вывести, "share" - объединить в общие материалы, пусто - нет)
+    std::string duplicateIslands;
+    /// Экспериментальный режим: несмежные острова делят материалы (раскраска графа смежности островов)
+    bool shareMaterials = false;
+    /// Наибольшее кол-во материалов (0 - не ограничено)
+    unsigned maxMaterials = 0;
+    /// Допуск слияния совпадающих положений вершин при разбиении (отрицательный - не сливать, 0 - только точные копии)
+    float weldPositions = -1.0f;
+    /// Допуск слияния совпадающих текстурных координат при разбиении (отрицательный - не сливать)
+    float weldUv = -1.0f;
+    /// Вывести пары групп, накладывающихся друг на друга в развертке
+    bool uvOverlaps = false;
+    /// Упорядочить полигоны внутри групп для кеша вершин
+    bool vertexCache = false;
+    /// Вывести сведения о ребрах меша (граничные, неманифолдные, швы развертки)
+    bool topology = false;
+    /// Кол-во потоков (0 - по кол-ву аппаратных потоков)
+    unsigned threads = 0;
+    /// Вывести статистику этапов обработки
+    bool stats = false;
+    /// Выделять арену данных файла на огромных страницах
+    bool hugePages = false;
+    /// Набор инструкций для векторных ядер (пусто - наиболее широкий поддерживаемый)
+    std::string forceIsa;
+    /// Ограничение памяти, МБ (0 - 3/4 физической памяти). Файлы, не помещающиеся в него, обрабатываются во внешней памяти
+    unsigned memoryLimit = 0;
+    /// Режим сверки алгоритмов разбиения с эталоном
+    bool verify = false;
+    /// Параметры сверки
+    VerifySettings verifySettings;
+    /// Режим замеров масштабируемости
+    bool benchmark = false;
+    /// Параметры замеров
+    BenchmarkSettings benchmarkSettings;
 };
 
 /**
- * \brief Группа вершин
- *
- * \details Полигоны в группе объединены общими вершиными
+ * \brief Разбор аргументов командной строки
+ * \param argc Кол-во аргументов
+ * \param argv Аргументы
+ * \param options Параметры запуска
+ * \return Удалось ли разобрать аргументы
  */
-struct Group
+bool ParseOptions(int argc, char* argv[], Options& options)
 {
-    std::vector<unsigned> polygons;
-    std::unordered_set<Vertex, Vertex::Hash> vertices;
+    unsigned positional = 0;
 
-    [[nodiscard]] bool polygonBelongs(const std::vector<Vertex>& polygonVertices) const
+    for(int i = 1; i < argc; i++)
     {
-        return std::any_of(polygonVertices.begin(),polygonVertices.end(),[&](const Vertex& v){
-            return vertices.count(v);
-        });
+        const std::string arg = argv[i];
+
+        // Аргумент, требующий значения
+        auto value = [&](std::string& out){
+            if(i + 1 >= argc){
+                std::cout << "Option \"" << arg << "\" requires a value." << std::endl;
+                return false;
+            }
+            out = argv[++i];
+            return true;
+        };
+        // Целое без знака и лишних символов, не больше maxValue (знак "-" не допускается, а не переводится в огромное число)
+        auto parseNumber = [](const std::string& str, unsigned maxValue, unsigned& out){
+            unsigned long long parsed = 0;
+            const auto result = std::from_chars(str.data(), str.data() + str.size(), parsed);
+            if(result.ec != std::errc() || result.ptr != str.data() + str.size() || parsed > maxValue) return false;
+            out = static_cast<unsigned>(parsed);
+            return true;
+        };
+        auto number = [&](unsigned& out, unsigned maxValue = std::numeric_limits<unsigned>::max()){
+            std::string str;
+            if(!value(str)) return false;
+            if(!parseNumber(str, maxValue, out)){
+                std::cout << "Option \"" << arg << "\" requires a number from 0 to " << maxValue << "." << std::endl;
+                return false;
+            }
+            return true;
+        };
+        // Неотрицательное число без лишних символов. Число должно начинаться с цифры или точки, поэтому знак "-",
+        // nan и inf не допускаются (проверка по тексту, так как с -ffast-math std::isfinite всегда истинна)
+        auto decimal = [&](float& out){
+            std::string str;
+            if(!value(str)) return false;
+            float parsed = 0.0f;
+            const auto result = std::from_chars(str.data(), str.data() + str.size(), parsed);
+            const bool digitFirst = !str.empty() && (std::isdigit(static_cast<unsigned char>(str[0])) || str[0] == '.');
+            if(!digitFirst || result.ec != std::errc() || result.ptr != str.data() + str.size()){
+                std::cout << "Option \"" << arg << "\" requires a non-negative number." << std::endl;
+                return false;
+            }
+            out = parsed;
+            return true;
+        };
+
+        auto numberList = [&](std::vector<unsigned>& out){
+            std::string str;
+            if(!value(str)) return false;
+            out.clear();
+            for(size_t pos = 0; pos < str.size();){
+                size_t comma = str.find(',', pos);
+                if(comma == std::string::npos) comma = str.size();
+                unsigned item = 0;
+                if(!parseNumber(str.substr(pos, comma - pos), std::numeric_limits<unsigned>::max(), item)){
+                    std::cout << "Option \"" << arg << "\" requires a comma separated list of numbers." << std::endl;
+                    return false;
+                }
+                out.push_back(item);
+                pos = comma + 1;
+            }
+            return true;
+        };
+
+        if(arg == "--engine"){
+            if(!value(options.engine)) return false;
+        }else if(arg == "--connectivity"){
+            if(!value(options.connectivity)) return false;
+        }else if(arg == "--per-object"){
+            options.perObject = true;
+        }else if(arg == "--max-normal-angle"){
+            if(!number(options.maxNormalAngle, 180)) return false;
+        }else if(arg == "--merge-max-faces"){
+            if(!number(options.mergeMaxFaces)) return false;
+        }else if(arg == "--merge-max-uv-area"){
+            if(!decimal(options.mergeMaxUvArea)) return false;
+        }else if(arg == "--duplicate-islands"){
+            if(!value(options.duplicateIslands)) return false;
+        }else if(arg == "--share-materials"){
+            options.shareMaterials = true;
+        }else if(arg == "--max-materials"){
+            if(!number(options.maxMaterials)) return false;
+        }else if(arg == "--weld-positions"){
+            if(!decimal(options.weldPositions)) return false;
+        }else if(arg == "--weld-uv"){
+            if(!decimal(options.weldUv)) return false;
+        }else if(arg == "--uv-overlaps"){
+            options.uvOverlaps = true;
+        }else if(arg == "--vertex-cache"){
+            options.vertexCache = true;
+        }else if(arg == "--topology"){
+            options.topology = true;
+        }else if(arg == "--threads"){
+            if(!number(options.threads)) return false;
+        }else if(arg == "--stats"){
+            options.stats = true;
+        }else if(arg == "--huge-pages"){
+            options.hugePages = true;
+        }else if(arg == "--force-isa"){
+            if(!value(options.forceIsa)) return false;
+        }else if(arg == "--memory-limit"){
+            if(!number(options.memoryLimit)) return false;
+        }else if(arg == "--verify"){
+            options.verify = true;
+        }else if(arg == "--iterations"){
+            if(!number(options.verifySettings.iterations)) return false;
+        }else if(arg == "--seed"){
+            if(!number(options.verifySettings.seed)) return false;
+        }else if(arg == "--max-faces"){
+            if(!number(options.verifySettings.maxFaces)) return false;
+        }else if(arg == "--bench"){
+            options.benchmark = true;
+        }else if(arg == "--bench-threads"){
+            if(!numberList(options.benchmarkSettings.threadCounts)) return false;
+        }else if(arg == "--bench-min-faces"){
+            if(!number(options.benchmarkSettings.minFaces)) return false;
+        }else if(arg == "--bench-max-faces"){
+            if(!number(options.benchmarkSettings.maxFaces)) return false;
+        }else if(arg == "--bench-weak-faces"){
+            if(!number(options.benchmarkSettings.weakFacesPerThread)) return false;
+        }else if(arg == "--bench-repeat"){
+            if(!number(options.benchmarkSettings.repeat)) return false;
+        }else if(arg == "--bench-csv"){
+            if(!value(options.benchmarkSettings.csvPath)) return false;
+        }else if(!arg.compare(0, 2, "--")){
+            std::cout << "Unknown option \"" << arg << "\"." << std::endl;
+            return false;
+        }else{
+            // Позиционные аргументы - исходный файл и имя выходного файла
+            if(positional == 0) options.inputFile = arg;
+            else if(positional == 1) options.outputFilename = arg;
+            positional++;
+        }
     }
 
-    void addPolygon(const unsigned polygonIdx, const std::vector<Vertex>& polygonVertices)
-    {
-        polygons.push_back(polygonIdx);
+    if(!FindGroupingEngine(options.engine)){
+        std::cout << "Unknown engine \"" << options.engine << "\". Available:";
+        for(const auto& engine : GetGroupingEngines()) std::cout << " " << engine.name;
+        std::cout << std::endl;
+        return false;
+    }
+
+    if(options.connectivity != "vertex" && options.connectivity != "edge"){
+        std::cout << "Unknown connectivity \"" << options.connectivity << "\". Available: vertex edge" << std::endl;
+        return false;
+    }
 
-        for(const auto& v : polygonVertices){
-            vertices.insert(v);
+    if(!options.duplicateIslands.empty() && options.duplicateIslands != "report" && options.duplicateIslands != "share"){
+        std::cout << "Unknown duplicate islands mode \"" << options.duplicateIslands << "\". Available: report share" << std::endl;
+        return false;
+    }
+
+    // Набор инструкций выбирается до любой обработки
+    if(!options.forceIsa.empty()){
+        InstructionSet isa;
+        if(!FindInstructionSet(options.forceIsa, isa)){
+            std::cout << "Unknown instruction set \"" << options.forceIsa << "\". Available:";
+            for(int i = 0; i < eIsaCount; i++) std::cout << " " << InstructionSetName(static_cast<InstructionSet>(i));
+            std::cout << std::endl;
+            return false;
+        }
+        if(!ForceInstructionSet(isa)){
+            std::cout << "Instruction set \"" << options.forceIsa << "\" is not supported by this CPU (up to \""
+                      << InstructionSetName(DetectInstructionSet()) << "\")." << std::endl;
+            return false;
         }
     }
 
-    void joinGroup(Group& group)
+    options.verifySettings.threads = options.threads;
+    options.benchmarkSettings.engine = options.engine;
+    options.benchmarkSettings.hugePages = options.hugePages;
+    return true;
+}
+
+/**
+ * \brief Слить совпадающие координаты одного вида и заменить их индексы в копии меша для разбиения
+ * \tparam Index Тип индексов вершин
+ * \param mesh Меш
+ * \param weldedMesh Копия меша с каноническими индексами (создается при первом слиянии)
+ * \param coordinates Координаты
+ * \param type Вид координат (eLinePosition либо eLineTexCoord)
+ * \param tolerance Допуск
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void WeldIndices(const BasicMesh<Index>& mesh, BasicMesh<Index>& weldedMesh, const Coordinates& coordinates, LineType type,
+                 float tolerance, ThreadPool& pool)
+{
+    WeldMap map;
     {
-        polygons.insert(polygons.end(),group.polygons.begin(),group.polygons.end());
-        vertices.merge(group.vertices);
+        StatsPhase phase("weld");
+        map = WeldCoordinates(coordinates, type == eLinePosition ? 3 : 2, tolerance, pool);
+        if(map.weldedCount > 0){
+            if(weldedMesh.faceCount() == 0) weldedMesh = mesh;
+            RemapIndices(weldedMesh, map, type, pool);
+        }
     }
+    std::cout << map.weldedCount << " of " << coordinates.count() << (type == eLinePosition ? " positions" : " texture coordinates")
+              << " welded (tolerance " << tolerance << ")" << std::endl;
+}
+
+/**
+ * \brief Разделить группы, нормали полигонов которых расходятся больше допустимого угла, и вывести каждое разделение
+ * \tparam Index Тип индексов вершин
+ * \param options Параметры запуска
+ * \param mesh Меш
+ * \param faceNormals Нормали полигонов
+ * \param groups Группы (заменяются результатом)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет), номера групп обновляются
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void SplitByNormals(const Options& options, const BasicMesh<Index>& mesh, const Coordinates& faceNormals, GroupMembers& groups,
+                    ObjectMaterials* materials, ThreadPool& pool)
+{
+    StatsPhase phase("split");
+    NormalSplit split = SplitGroupsByNormals(mesh, groups, faceNormals, static_cast<float>(options.maxNormalAngle), pool);
 
-    void cleanGroup()
+    // Каждое разделение (по имени материала исходной группы)
+    unsigned splitGroups = 0;
+    std::string name;
+    for(unsigned g = 0; g < groups.groupCount(); g++)
     {
-        polygons.clear();
-        vertices.clear();
+        if(split.partCount(g) < 2) continue;
+        name.clear();
+        AppendMaterialName(name, g, materials);
+        std::cout << name << " (" << groups.offsets[g + 1] - groups.offsets[g] << " polygons) split into "
+                  << split.partCount(g) << " groups by normals" << std::endl;
+        splitGroups++;
     }
-};
+    if(splitGroups > split.uncheckedGroups){
+        std::cout << splitGroups - split.uncheckedGroups << " groups with normals more than " << options.maxNormalAngle
+                  << " degrees apart split" << std::endl;
+    }
+    if(split.uncheckedGroups > 0){
+        std::cout << split.uncheckedGroups << " groups with too many distinct normals for an exact check split by normal cones" << std::endl;
+    }
+    if(splitGroups > 0){
+        std::cout << "Normal rule: " << groups.groupCount() << " -> " << split.groups.groupCount() << " groups" << std::endl;
+    }
+
+    if(materials){
+        for(auto& first : materials->firstGroup) first = split.firstPart[first];
+    }
+    groups = std::move(split.groups);
+}
 
 /**
- * \brief Точка входа
- * \param argc Кол-во аргументов
- * \param argv Аргументы
- * \return Код выполнения
+ * \brief Объект каждой группы (острова присоединяются и делят материалы только внутри своего объекта)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет)
+ * \param groupCount Кол-во групп
+ * \return Объекты групп (пусто, если разбиения по объектам нет)
  */
-int main(int argc, char* argv[])
+std::vector<unsigned> ObjectOfGroups(const ObjectMaterials* materials, unsigned groupCount)
 {
-    // Если кол-во аргументов менее двух (первый агрумент - путь к исполняемому файлу)
-    if(argc < 2){
-        std::cout << "No file provided." << std::endl;
-        return 1;
+    std::vector<unsigned> objectOf;
+    if(materials){
+        objectOf.resize(groupCount);
+        for(unsigned o = 0; o + 1 < materials->firstGroup.size(); o++)
+        {
+            std::fill(objectOf.begin() + materials->firstGroup[o], objectOf.begin() + materials->firstGroup[o + 1], o);
+        }
     }
+    return objectOf;
+}
 
-    /** Ч Т Е Н И Е **/
+/**
+ * \brief Наибольший угол между нормалями полигонов при объединении островов в общий материал
+ * \param options Параметры запуска
+ * \return Угол, градусов (заданный "--max-normal-angle", иначе - предел Serious Modeller)
+ */
+float UnionNormalAngle(const Options& options)
+{
+    // Угол между нормалями полигонов одного материала, который допускает Serious Modeller
+    const unsigned MODELLER_NORMAL_ANGLE = 90;
 
-    // Открыть файл для чтения
-    std::ifstream in;
-    in.open(argv[1],std::ifstream::in);
+    return static_cast<float>(options.maxNormalAngle > 0 ? options.maxNormalAngle : MODELLER_NORMAL_ANGLE);
+}
 
-    // Если не удалось открыть
-    if(in.fail()){
-        std::cout << "Can't open file \"" << argv[1] << "\"." << std::endl;
-        return 1;
+/**
+ * \brief Присоединить мелкие острова к соседним (в пределах угла между нормалями и объекта) и вывести итог
+ * \tparam Index Тип индексов вершин
+ * \param options Параметры запуска
+ * \param geometry Координаты исходного файла
+ * \param mesh Меш
+ * \param topology Смежность полигонов меша
+ * \param faceNormals Нормали полигонов (угол ограничен всегда, UnionNormalAngle)
+ * \param groups Группы (заменяются результатом)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет), номера групп обновляются
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void MergeIslands(const Options& options, ObjGeometry& geometry, const BasicMesh<Index>& mesh, MeshTopology<Index>& topology,
+                  const Coordinates& faceNormals, GroupMembers& groups, ObjectMaterials* materials, ThreadPool& pool)
+{
+    StatsPhase phase("merge");
+    const IslandGraph graph = BuildIslandGraph(mesh, groups, topology, pool);
+    const std::vector<float> uvAreas = options.mergeMaxUvArea > 0.0f ? IslandUvAreas(mesh, groups, geometry.texCoords(), pool)
+                                                                     : std::vector<float>();
+
+    IslandMergeSettings settings;
+    settings.maxFaces = options.mergeMaxFaces;
+    settings.maxUvArea = options.mergeMaxUvArea;
+    settings.maxNormalAngle = UnionNormalAngle(options);
+    IslandMerge merge = MergeSmallIslands(groups, graph, settings, faceNormals, uvAreas, ObjectOfGroups(materials, groups.groupCount()), pool);
+
+    std::cout << "Merged " << merge.mergedCount << " small islands into neighbours: " << groups.groupCount() << " -> "
+              << merge.groups.groupCount() << " materials" << std::endl;
+
+    if(materials){
+        for(auto& first : materials->firstGroup) first = merge.firstKept[first];
     }
+    groups = std::move(merge.groups);
+}
 
-    // Переменная для хранения текущей строки файла
-    std::string line;
+/**
+ * \brief Объединить группы с одинаковыми метками (метки групп объекта идут подряд)
+ * \param labels Новая группа каждой группы
+ * \param labelCount Кол-во новых групп
+ * \param groups Группы (заменяются результатом)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет), номера групп обновляются
+ * \param pool Пул потоков
+ */
+void UniteGroups(const std::vector<unsigned>& labels, unsigned labelCount, GroupMembers& groups, ObjectMaterials* materials,
+                 ThreadPool& pool)
+{
+    // Первая новая группа объекта - наименьшая метка его групп (у объекта без групп - первая группа следующего)
+    if(materials){
+        std::vector<unsigned>& first = materials->firstGroup;
+        std::vector<unsigned> firstLabel(first.size(), labelCount);
+        for(size_t o = first.size() - 1; o-- > 0;)
+        {
+            firstLabel[o] = firstLabel[o + 1];
+            for(unsigned g = first[o]; g < first[o + 1]; g++) firstLabel[o] = std::min(firstLabel[o], labels[g]);
+        }
+        first = std::move(firstLabel);
+    }
+    groups = UniteIslands(groups, labels, labelCount, pool);
+}
 
-    // Массив полигонов (массив массивов вершин)
-    using Polygon = std::vector<Vertex>;
-    std::vector<Polygon> polygons;
+/**
+ * \brief Найти острова с одинаковой разверткой, вывести итог и (в режиме "share") объединить их в общие материалы
+ * \tparam Index Тип индексов вершин
+ * \param options Параметры запуска
+ * \param geometry Координаты исходного файла
+ * \param mesh Меш
+ * \param faceNormals Нормали полигонов (нужны в режиме "share", угол ограничен всегда, UnionNormalAngle)
+ * \param groups Группы (заменяются результатом)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет), номера групп обновляются
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void FindDuplicates(const Options& options, ObjGeometry& geometry, const BasicMesh<Index>& mesh, const Coordinates& faceNormals,
+                    GroupMembers& groups, ObjectMaterials* materials, ThreadPool& pool)
+{
+    StatsPhase phase("duplicates");
+    const IslandDuplicates duplicates = FindDuplicateIslands(mesh, groups, geometry.texCoords(),
+                                                             ObjectOfGroups(materials, groups.groupCount()), pool);
+    std::cout << "Duplicate islands: " << duplicates.repeatedShapes << " shapes repeated across " << duplicates.repeatedIslands
+              << " of " << groups.groupCount() << " islands" << std::endl;
+    if(options.duplicateIslands != "share") return;
+
+    const IslandPartition partition = ShareDuplicateIslands(groups, duplicates, UnionNormalAngle(options), faceNormals, pool);
+    std::cout << "Duplicate islands share materials: " << groups.groupCount() << " -> " << partition.groupCount << " materials" << std::endl;
+    UniteGroups(partition.labels, partition.groupCount, groups, materials, pool);
+}
 
-    // Пока не достигнут конец файла
-    while(!in.eof())
-    {
-        // Получить строку
-        std::getline(in, line);
+/**
+ * \brief Раскрасить граф смежности и наложений островов, объединить острова одного цвета в материал и вывести итог
+ * \tparam Index Тип индексов вершин
+ * \param options Параметры запуска
+ * \param geometry Координаты исходного файла
+ * \param mesh Меш
+ * \param topology Смежность полигонов меша
+ * \param faceNormals Нормали полигонов (угол ограничен всегда, UnionNormalAngle)
+ * \param groups Группы (заменяются результатом)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет), номера групп обновляются
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void ShareMaterials(const Options& options, ObjGeometry& geometry, const BasicMesh<Index>& mesh, MeshTopology<Index>& topology,
+                    const Coordinates& faceNormals, GroupMembers& groups, ObjectMaterials* materials, ThreadPool& pool)
+{
+    StatsPhase phase("share");
+
+    // Накладывающиеся в развертке острова конфликтуют так же, как смежные (общий материал исказил бы текстуру)
+    const UvOverlaps overlaps = FindUvOverlaps(mesh, groups, geometry.texCoords(), pool);
+    const IslandGraph graph = AddIslandConflicts(BuildIslandGraph(mesh, groups, topology, pool), overlaps.pairs);
+    const IslandColoring coloring = ColorIslands(groups, graph, UnionNormalAngle(options), faceNormals,
+                                                 ObjectOfGroups(materials, groups.groupCount()), pool);
+
+    // Наибольшее кол-во островов одного материала
+    std::vector<unsigned> islands(coloring.colorCount, 0);
+    for(unsigned color : coloring.colors) islands[color]++;
+    std::cout << "Material sharing: " << groups.groupCount() << " islands -> " << coloring.colorCount << " materials (up to "
+              << (islands.empty() ? 0 : *std::max_element(islands.begin(), islands.end())) << " islands per material, "
+              << graph.neighbours.size() / 2 << " adjacent or overlapping pairs)" << std::endl;
+    if(overlaps.truncated){
+        std::cout << "UV overlap search stopped at the candidate limit, some overlapping islands may share a material" << std::endl;
+    }
 
-        // Поток ввода/вывода для строки
-        std::stringstream iss(line);
+    UniteGroups(coloring.colors, coloring.colorCount, groups, materials, pool);
+}
 
-        // Для "мусорных данных"
-        char cTrash;
+/**
+ * \brief Разбить острова не больше чем на заданное кол-во материалов и вывести итог
+ * \param options Параметры запуска
+ * \param faceNormals Нормали полигонов
+ * \param groups Группы (заменяются результатом)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет), номера групп обновляются
+ * \param pool Пул потоков
+ */
+void LimitMaterials(const Options& options, const Coordinates& faceNormals, GroupMembers& groups, ObjectMaterials* materials,
+                    ThreadPool& pool)
+{
+    StatsPhase phase("budget");
+    if(groups.groupCount() <= options.maxMaterials){
+        std::cout << groups.groupCount() << " materials fit into the budget of " << options.maxMaterials << std::endl;
+        return;
+    }
 
-        // Если строка начинается с подстроки "f "
-        if(!line.compare(0, 2, "f "))
-        {
-            // Полигон (массив вершин)
-            Polygon p;
+    const float maxNormalAngle = UnionNormalAngle(options);
+    const IslandPartition partition = PartitionIslands(groups, options.maxMaterials, maxNormalAngle, faceNormals,
+                                                       ObjectOfGroups(materials, groups.groupCount()), pool);
+    std::cout << "Material budget: " << groups.groupCount() << " islands -> " << partition.groupCount << " materials (budget "
+              << options.maxMaterials << ", widest normal cone of a shared material " << partition.maxSpread << " degrees)" << std::endl;
+    if(partition.groupCount > options.maxMaterials){
+        if(materials && materials->names.size() > options.maxMaterials){
+            std::cout << "Budget of " << options.maxMaterials << " materials can't be met: " << materials->names.size()
+                      << " objects need at least one material each" << std::endl;
+        }else{
+            std::cout << "Budget of " << options.maxMaterials << " materials can't be met without breaking the normal rule ("
+                      << maxNormalAngle << " degrees)" << std::endl;
+        }
+    }
 
-            // Первый символ (f) вписывается в мусорную переменную
-            iss >> cTrash;
+    UniteGroups(partition.labels, partition.groupCount, groups, materials, pool);
+}
 
-            // Читать символы строки в структуру вершины пока строка не закончится
-            Vertex v;
-            while (iss >> v.posIdx >> cTrash >> v.uvIdx >> cTrash >> v.normalIdx){
-                p.push_back(v);
-            }
+/**
+ * \brief Найти группы, накладывающиеся друг на друга в развертке, и вывести отчет
+ * \tparam Index Тип индексов вершин
+ * \param geometry Координаты исходного файла
+ * \param mesh Меш
+ * \param groups Группы
+ * \param materials Материалы групп при разбиении по объектам (nullptr - нет)
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void ReportUvOverlaps(ObjGeometry& geometry, const BasicMesh<Index>& mesh, const GroupMembers& groups,
+                      const ObjectMaterials* materials, ThreadPool& pool)
+{
+    // Наибольшее кол-во выводимых пар
+    const size_t MAX_LISTED_PAIRS = 20;
 
-            // Добавить полигон
-            polygons.push_back(p);
-        }
+    UvOverlaps overlaps;
+    {
+        StatsPhase phase("overlaps");
+        overlaps = FindUvOverlaps(mesh, groups, geometry.texCoords(), pool);
+    }
+
+    std::string first, second;
+    for(size_t i = 0; i < overlaps.pairs.size() && i < MAX_LISTED_PAIRS; i++)
+    {
+        first.clear();
+        second.clear();
+        AppendMaterialName(first, overlaps.pairs[i].first, materials);
+        AppendMaterialName(second, overlaps.pairs[i].second, materials);
+        std::cout << first << " overlaps " << second << " in UV space" << std::endl;
+    }
+    if(overlaps.pairs.size() > MAX_LISTED_PAIRS) std::cout << "..." << std::endl;
+    std::cout << "UV overlaps: " << overlaps.pairs.size() << " overlapping pairs of " << overlaps.candidateCount
+              << " candidates with intersecting bounds, " << overlaps.overlappingIslands << " of " << groups.groupCount()
+              << " groups overlap others" << std::endl;
+    if(overlaps.truncated){
+        std::cout << "UV overlap search stopped at the candidate limit, not all overlaps are listed" << std::endl;
+    }
+}
+
+/**
+ * \brief Обработать файл (разбить на группы и записать результат)
+ * \tparam Index Тип индексов вершин
+ * \param options Параметры запуска
+ * \param in Исходный файл (закрывается после чтения)
+ * \param scan Итоги предварительного прохода по файлу
+ * \param pool Пул потоков
+ * \param arena Арена для всех данных файла
+ * \return Код выполнения
+ */
+template<typename Index>
+int ConvertFile(const Options& options, MappedFile& in, const ObjScan& scan, ThreadPool& pool, Arena& arena)
+{
+    /** Ч Т Е Н И Е **/
+
+    // Полигоны
+    BasicMesh<Index> mesh(&arena);
+    {
+        StatsPhase phase("read");
+        ReadPolygons(in.data(), in.size(), scan, mesh, pool);
     }
 
     // Если не удалось считать данные полигонов
-    if(polygons.empty()){
+    if(mesh.faceCount() == 0){
         std::cout << "Can't ready polygon data from file." << std::endl;
         return 1;
     }
 
-    /** Р А З Б И Е Н И Е  Н А  Г Р У П П Ы **/
+    // Координаты вершин разбираются только при первом обращении (если включены использующие их проверки)
+    ObjGeometry geometry(in.data(), scan, pool);
+
+    /** С Л И Я Н И Е  В Е Р Ш И Н **/
 
-    // Группы полигонов
-    std::vector<Group> groups;
+    // Разбиение идет по копии меша с каноническими индексами, вывод сохраняет исходные индексы
+    BasicMesh<Index> weldedMesh(&arena);
+    if(options.weldPositions >= 0.0f){
+        WeldIndices(mesh, weldedMesh, geometry.positions(), eLinePosition, options.weldPositions, pool);
+    }
+    if(options.weldUv >= 0.0f){
+        WeldIndices(mesh, weldedMesh, geometry.texCoords(), eLineTexCoord, options.weldUv, pool);
+    }
+    const BasicMesh<Index>& groupingMesh = weldedMesh.faceCount() > 0 ? weldedMesh : mesh;
+
+    // Смежность полигонов строится только при первом обращении (если включены использующие ее проверки)
+    MeshTopology<Index> topology(groupingMesh, pool);
+    if(options.topology){
+        const EdgeCounts edges = topology.countEdges();
+        std::cout << edges.edges << " edges: " << edges.boundary << " boundary, " << edges.nonManifold << " non-manifold, "
+                  << edges.seams << " UV seams (" << topology.halfEdges().count() * 2 * sizeof(unsigned) / 1024
+                  << " KB of half-edges)" << std::endl;
+    }
+
+    /** Р А З Б И Е Н И Е  Н А  Г Р У П П Ы **/
 
-    // Пройтись по всем полигонам
-    for(unsigned p = 0; p < polygons.size(); p++)
+    // Разбить полигоны на группы выбранным алгоритмом (по всему мешу либо внутри каждого объекта)
+    GroupMembers groups(&arena);
+    ObjectMaterials objectMaterials;
+    ObjectMaterials* materials = options.perObject ? &objectMaterials : nullptr;
+    const bool edgeConnectivity = options.connectivity == "edge";
+    const ObjectFaces objects = options.perObject ? CollectObjectFaces(in.data(), scan.lines, &arena) : ObjectFaces();
+    auto divide = [&](const GroupingEngine& engine, ObjectMaterials& groupMaterials){
+        if(options.perObject) return GroupObjects(groupingMesh, objects, engine, pool, groupMaterials);
+        return CollectGroupMembers(engine.divide(groupingMesh, pool));
+    };
     {
-        // Последняя группа в которую был добавлен текущий полигон
-        int lastGroupPolyAdded = -1;
+        StatsPhase phase("group");
+        groups = divide(edgeConnectivity ? GetEdgeGroupingEngine() : *FindGroupingEngine(options.engine), objectMaterials);
+    }
 
-        // Пройтись по группам
-        for(unsigned g = 0; g < groups.size(); g++)
-        {
-            // Если полигон должен принадлжать текущей группе
-            if(groups[g].polygonBelongs(polygons[p]))
-            {
-                // Если была какая-то группа в которую этот же полигон был добавлен
-                if(lastGroupPolyAdded != -1) {
-                    groups[g].joinGroup(groups[lastGroupPolyAdded]);
-                    groups[lastGroupPolyAdded].cleanGroup();
-                }
-                    // Если полигон не добавлялся ранее ни в какие группы
-                else{
-                    groups[g].addPolygon(p,polygons[p]);
-                    lastGroupPolyAdded = static_cast<int>(g);
-                }
-            }
-        }
+    // Сравнение с правилом общей вершины (сколько групп разделилось из-за касания одной вершиной)
+    if(edgeConnectivity){
+        StatsPhase phase("connectivity");
+        ObjectMaterials vertexMaterials;
+        const GroupMembers vertexGroups = divide(*FindGroupingEngine(options.engine), vertexMaterials);
+        std::cout << "Edge connectivity: " << groups.groupCount() << " groups, vertex connectivity: " << vertexGroups.groupCount()
+                  << " groups (" << CountSplitGroups(vertexGroups, groups) << " of them split by edge rule)" << std::endl;
+    }
 
-        // Если полигон так и не был добавлен ни в одну из групп
-        // создать новую группу и добавить туда полигон
-        if(lastGroupPolyAdded == -1){
-            Group group;
-            group.addPolygon(p,polygons[p]);
-            groups.push_back(group);
-        }
+    // Нормали полигонов (для правила о нормалях, слияния островов, общих и ограничения кол-ва материалов)
+    Coordinates faceNormals;
+    if(options.maxNormalAngle > 0 || options.mergeMaxFaces > 0 || options.mergeMaxUvArea > 0.0f || options.duplicateIslands == "share" ||
+       options.shareMaterials || options.maxMaterials > 0){
+        StatsPhase phase("normals");
+        faceNormals = ComputeFaceNormals(groupingMesh, geometry, pool);
     }
 
-    // Удалить пустые группы
-    groups.erase(std::remove_if(groups.begin(),groups.end(),[](const Group& g){return g.polygons.empty();}),groups.end());
+    // Группы, в которых нормали расходятся больше допустимого угла, делятся на части
+    if(options.maxNormalAngle > 0){
+        SplitByNormals(options, groupingMesh, faceNormals, groups, materials, pool);
+    }
 
-    /** П О Д Г О Т О В К А  К  В Ы В О Д У **/
+    // Мелкие острова присоединяются к соседним
+    if(options.mergeMaxFaces > 0 || options.mergeMaxUvArea > 0.0f){
+        MergeIslands(options, geometry, groupingMesh, topology, faceNormals, groups, materials, pool);
+    }
 
-    // Имя выходного файла
-    std::string outputFilename = argc < 3 ? "output" : argv[2];
+    // Острова с одинаковой разверткой
+    if(!options.duplicateIslands.empty()){
+        FindDuplicates(options, geometry, groupingMesh, faceNormals, groups, materials, pool);
+    }
 
-    // Содержимое результирющих файлов
-    std::vector<std::string> objFileText = {
-            "# SED Auto Materials v1.0 OBJ File",
-            "mtllib " + outputFilename + ".mtl"
-    };
-    std::vector<std::string> mtlFileText = {
-            "# SED Auto Materials v1.0 MTL File",
-            "# Material Count: " + std::to_string(groups.size())
-    };
+    // Несмежные острова делят материалы
+    if(options.shareMaterials){
+        ShareMaterials(options, geometry, groupingMesh, topology, faceNormals, groups, materials, pool);
+    }
 
-    // Вернуться к началу исходного .obj файла
-    in.clear();
-    in.seekg(0, std::ios::beg);
+    // Кол-во материалов ограничивается
+    if(options.maxMaterials > 0){
+        LimitMaterials(options, faceNormals, groups, materials, pool);
+    }
 
-    // Пока не достигнут конец файла
-    while(!in.eof())
-    {
-        // Получить строку
-        std::getline(in, line);
+    // Наложения итоговых групп в развертке
+    if(options.uvOverlaps){
+        ReportUvOverlaps(geometry, groupingMesh, groups, materials, pool);
+    }
 
-        // Если строка не начинается с "#" или "mtlib"
-        if(line.compare(0, 1, "#") && line.compare(0, 6, "mtllib"))
+    // Порядок полигонов внутри групп для кеша вершин
+    if(options.vertexCache){
+        FaceOrderStats faceOrder;
         {
-            // Если строка начинается с "usemtl" - оборвать цикл
-            if(!line.compare(0,6,"usemtl")) break;
-                // Иначе добаить строку в массив стрк
-            else objFileText.push_back(line);
+            StatsPhase phase("vertex cache");
+            faceOrder = OptimizeFaceOrder(mesh, groups, pool);
         }
+        std::cout << "Vertex cache: ACMR " << faceOrder.acmrBefore() << " -> " << faceOrder.acmrAfter() << " ("
+                  << faceOrder.triangleCount << " triangles, " << faceOrder.reorderedGroups << " of " << groups.groupCount()
+                  << " groups reordered)" << std::endl;
     }
 
-    // Закрыть файл
-    in.close();
+    /** П О Д Г О Т О В К А  К  В Ы В О Д У **/
 
-    // Пройтись по всем группам
-    for(unsigned g = 0; g < groups.size(); g++)
+    // Имя выходного файла
+    const std::string& outputFilename = options.outputFilename;
+
+    // Основная информация исходного файла (вершины, нормали, uv-координаты)
+    TextLines baseData(&arena);
     {
-        // Добавление данных .mtl
-        mtlFileText.emplace_back("");
-        mtlFileText.emplace_back("newmtl Material." + std::to_string(g));
-        mtlFileText.emplace_back("Ns 225.000000");
-        mtlFileText.emplace_back("Ka 1.000000 1.000000 1.000000");
-        mtlFileText.emplace_back("Kd 0.800000 0.800000 0.800000");
-        mtlFileText.emplace_back("Ks 0.500000 0.500000 0.500000");
-        mtlFileText.emplace_back("Ke 0.000000 0.000000 0.000000");
-        mtlFileText.emplace_back("Ni 1.450000");
-        mtlFileText.emplace_back("d 1.000000");
-        mtlFileText.emplace_back("illum 2");
-
-        // Добавление данных .obj
-        objFileText.emplace_back("usemtl Material." + std::to_string(g));
-        objFileText.emplace_back("s off");
-
-        for(unsigned int p : groups[g].polygons)
-        {
-            const auto& polygon = polygons[p];
-            std::string polygonStr = "f";
+        StatsPhase phase("base data");
+        baseData.reserve(scan.baseLines);
+        ReadBaseObjData(in.data(), scan.lines, baseData);
+    }
 
-            for(const auto& v : polygon){
-                polygonStr += " " + std::to_string(v.posIdx) + "/" + std::to_string(v.uvIdx) + "/" + std::to_string(v.normalIdx);
-            }
+    // Закрыть файл
+    in.close();
 
-            objFileText.push_back(polygonStr);
-        }
+    // Содержимое результирющих файлов
+    std::pmr::string objFileText(&arena);
+    std::string mtlFileText;
+    {
+        StatsPhase phase("format");
+        objFileText = FormatObjText(outputFilename + ".mtl", baseData, mesh, groups, pool, materials);
+        mtlFileText = FormatMtlText(groups.groupCount(), materials);
     }
 
     /** В Ы В О Д **/
 
+    StatsPhase writePhase("write");
+
     // Запись в файл .obj
     std::ofstream outObj;
     outObj.open(outputFilename + ".obj", std::ios::out | std::ios::trunc);
-    for(const std::string& str : objFileText){
-        outObj << str << std::endl;
-    }
+    outObj.write(objFileText.data(), static_cast<std::streamsize>(objFileText.size()));
     outObj.close();
 
     // Запись в файл .mtl
     std::ofstream outMtl;
     outMtl.open(outputFilename + ".mtl", std::ios::out | std::ios::trunc);
-    for(const std::string& str : mtlFileText){
-        outMtl << str << std::endl;
+    outMtl.write(mtlFileText.data(), static_cast<std::streamsize>(mtlFileText.size()));
+    outMtl.close();
+
+    // Статистика этапов
+    if(options.stats){
+        std::cout << mesh.faceCount() << " polygons, " << groups.groupCount() << " groups, ";
+        if(materials) std::cout << materials->names.size() << " objects, ";
+        std::cout << sizeof(Index) * 8 << "-bit indices, " << InstructionSetName(ActiveInstructionSet()) << " kernels" << std::endl;
+        PrintStats(std::cout);
+        std::cout << "arena: " << arena.reservedBytes() / (1024 * 1024) << " MB in " << arena.blockCount() << " blocks" << std::endl;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Обработать файл во внешней памяти (меш целиком в память не загружается)
+ * \param options Параметры запуска
+ * \param in Исходный файл
+ * \param scan Итоги предварительного прохода по файлу
+ * \param memoryLimit Ограничение памяти (байт)
+ * \return Код выполнения
+ */
+int ConvertFileExternalMode(const Options& options, MappedFile& in, const ObjScan& scan, size_t memoryLimit)
+{
+    const std::string& outputFilename = options.outputFilename;
+    if(options.connectivity != "vertex") std::cout << "Option \"--connectivity\" is not supported in external memory and is ignored." << std::endl;
+    if(options.perObject) std::cout << "Option \"--per-object\" is not supported in external memory and is ignored." << std::endl;
+    if(options.topology) std::cout << "Option \"--topology\" is not supported in external memory and is ignored." << std::endl;
+    if(options.maxNormalAngle > 0) std::cout << "Option \"--max-normal-angle\" is not supported in external memory and is ignored." << std::endl;
+    if(options.mergeMaxFaces > 0) std::cout << "Option \"--merge-max-faces\" is not supported in external memory and is ignored." << std::endl;
+    if(options.mergeMaxUvArea > 0.0f) std::cout << "Option \"--merge-max-uv-area\" is not supported in external memory and is ignored." << std::endl;
+    if(!options.duplicateIslands.empty()) std::cout << "Option \"--duplicate-islands\" is not supported in external memory and is ignored." << std::endl;
+    if(options.vertexCache) std::cout << "Option \"--vertex-cache\" is not supported in external memory and is ignored." << std::endl;
+    if(options.uvOverlaps) std::cout << "Option \"--uv-overlaps\" is not supported in external memory and is ignored." << std::endl;
+    if(options.shareMaterials) std::cout << "Option \"--share-materials\" is not supported in external memory and is ignored." << std::endl;
+    if(options.maxMaterials > 0) std::cout << "Option \"--max-materials\" is not supported in external memory and is ignored." << std::endl;
+    if(options.weldPositions >= 0.0f) std::cout << "Option \"--weld-positions\" is not supported in external memory and is ignored." << std::endl;
+    if(options.weldUv >= 0.0f) std::cout << "Option \"--weld-uv\" is not supported in external memory and is ignored." << std::endl;
+
+    ExternalStats stats;
+    try{
+        StatsPhase phase("external");
+        if(!ConvertFileExternal(in.data(), in.size(), outputFilename + ".mtl", outputFilename + ".obj", scan, memoryLimit, stats)){
+            std::cout << "Can't ready polygon data from file." << std::endl;
+            return 1;
+        }
+    }catch(std::exception& e){
+        std::cout << e.what() << std::endl;
+        return 1;
     }
+
+    // Запись в файл .mtl
+    const std::string mtlFileText = FormatMtlText(stats.groupCount);
+    std::ofstream outMtl;
+    outMtl.open(outputFilename + ".mtl", std::ios::out | std::ios::trunc);
+    outMtl.write(mtlFileText.data(), static_cast<std::streamsize>(mtlFileText.size()));
     outMtl.close();
 
+    // Статистика этапов
+    if(options.stats){
+        std::cout << stats.faceCount << " polygons, " << stats.groupCount << " groups, " << stats.keyRuns
+                  << " + " << stats.faceRuns << " temporary runs" << std::endl;
+        PrintStats(std::cout);
+    }
+
     return 0;
+}
+
+/**
+ * \brief Точка входа
+ * \param argc Кол-во аргументов
+ * \param argv Аргументы
+ * \return Код выполнения
+ */
+int main(int argc, char* argv[])
+{
+    // Разобрать аргументы
+    Options options;
+    if(!ParseOptions(argc, argv, options)) return 1;
+
+    // Режим сверки алгоритмов разбиения (файл не нужен)
+    if(options.verify){
+        const unsigned mismatches = VerifyGroupingEngines(options.verifySettings) + VerifyLineIndexKernels(options.verifySettings) +
+                                    VerifyFloatParser(options.verifySettings) + VerifyLineEndings(options.verifySettings) +
+                                    VerifyNormalRule(options.verifySettings) + VerifyExternalMemory(options.verifySettings);
+        return mismatches == 0 ? 0 : 1;
+    }
+
+    // Режим замеров масштабируемости (файл не нужен)
+    if(options.benchmark){
+        return RunBenchmark(options.benchmarkSettings);
+    }
+
+    // Если не указан исходный файл
+    if(options.inputFile.empty()){
+        std::cout << "No file provided." << std::endl;
+        return 1;
+    }
+
+    // Пул потоков
+    ThreadPool pool(options.threads);
+
+    // Арена для всех данных файла (объявлена первой - освобождается последней и целиком)
+    Arena arena(options.hugePages);
+
+    // Открыть файл для чтения (отображение в память)
+    MappedFile in;
+
+    // Если не удалось открыть
+    if(!in.open(options.inputFile)){
+        std::cout << "Can't open file \"" << options.inputFile << "\"." << std::endl;
+        return 1;
+    }
+
+    // Файл заведомо не помещается в ограничение памяти (оценка без предварительного прохода - нижняя граница)
+    const size_t memoryLimit = options.memoryLimit > 0 ? static_cast<size_t>(options.memoryLimit) << 20u : PhysicalMemory() / 4 * 3;
+    if(memoryLimit > 0 && EstimateInMemoryBytes(ObjScan(), in.size()) > memoryLimit){
+        std::cout << "File doesn't fit into " << (memoryLimit >> 20u) << " MB, processing in external memory." << std::endl;
+        return ConvertFileExternalMode(options, in, ObjScan(), memoryLimit);
+    }
+
+    // Предварительный проход (индекс строк, кол-во строк и вершин полигонов, разрядность индексов)
+    ObjScan scan;
+    {
+        StatsPhase phase("scan");
+        scan = ScanObjFile(in.data(), in.size(), pool);
+    }
+    if(scan.skippedFaces > 0){
+        std::cout << scan.skippedFaces << " face lines without vertices in the format of the first face line are skipped" << std::endl;
+    }
+
+    // Файл не помещается в ограничение памяти - обработка во внешней памяти (индекс строк не нужен)
+    if(memoryLimit > 0 && EstimateInMemoryBytes(scan, in.size()) > memoryLimit){
+        std::cout << "File doesn't fit into " << (memoryLimit >> 20u) << " MB, processing in external memory." << std::endl;
+        scan.lines = LineIndex();
+        return ConvertFileExternalMode(options, in, scan, memoryLimit);
+    }
+
+    // Смещения полигонов меша 32-битные - при большем кол-ве вершин полигонов меш в памяти не строится
+    if(scan.faceVertices > std::numeric_limits<unsigned>::max()){
+        // Ограничение памяти внешней сортировки, если объем физической памяти неизвестен
+        const size_t DEFAULT_EXTERNAL_MEMORY = size_t(1) << 30u;
+
+        std::cout << "File has " << scan.faceVertices << " polygon vertices, more than 32-bit polygon offsets allow, processing in "
+                  << "external memory." << std::endl;
+        scan.lines = LineIndex();
+        return ConvertFileExternalMode(options, in, scan, memoryLimit > 0 ? memoryLimit : DEFAULT_EXTERNAL_MEMORY);
+    }
+
+    // Разрядность индексов - наименьшая достаточная для файла
+    switch(scan.indexWidth())
+    {
+        case eIndex16:
+            return ConvertFile<uint16_t>(options, in, scan, pool, arena);
+        case eIndex32:
+            return ConvertFile<uint32_t>(options, in, scan, pool, arena);
+        default:
+            return ConvertFile<uint64_t>(options, in, scan, pool, arena);
+    }
 }
\ No newline at end of file
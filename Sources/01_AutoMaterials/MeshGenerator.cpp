@@ -0,0 +1,230 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Генерация случайных мешей.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    /**
+     * \brief Случайное число в диапазоне [from, to]
+     */
+    unsigned RandomRange(std::mt19937& rng, unsigned from, unsigned to)
+    {
+        return std::uniform_int_distribution<unsigned>(from, to)(rng);
+    }
+
+    /**
+     * \brief Добавить в меш UV остров-сетку из четырехугольников
+     * \param mesh Меш
+     * \param rng Генератор случайных чисел
+     * \param posBase Первый индекс положения
+     * \param uvBase Первый индекс текстурных координат
+     * \param width Ширина сетки (в полигонах)
+     * \param height Высота сетки (в полигонах)
+     */
+    void AddGridIsland(Mesh& mesh, std::mt19937& rng, unsigned posBase, unsigned uvBase, unsigned width, unsigned height)
+    {
+        auto index = [&](unsigned x, unsigned y){ return y * (width + 1) + x; };
+
+        for(unsigned y = 0; y < height; y++)
+        {
+            for(unsigned x = 0; x < width; x++)
+            {
+                const unsigned corners[4] = {index(x, y), index(x + 1, y), index(x + 1, y + 1), index(x, y + 1)};
+                for(unsigned c : corners){
+                    mesh.addVertex({posBase + c, uvBase + c, RandomRange(rng, 1, 8)});
+                }
+                mesh.closePolygon();
+            }
+        }
+    }
+
+    /**
+     * \brief Острова-сетки (часть островов использует положения предыдущего острова - шов без общих UV)
+     */
+    void GenerateGridIslands(Mesh& mesh, std::mt19937& rng, unsigned faceCount)
+    {
+        unsigned posBase = 1, uvBase = 1;
+        unsigned lastPosBase = 1, lastVertexCount = 0;
+
+        while(mesh.faceCount() < faceCount)
+        {
+            unsigned width = RandomRange(rng, 1, 24);
+            unsigned height = RandomRange(rng, 1, 24);
+            unsigned vertexCount = (width + 1) * (height + 1);
+
+            // Шов - те же положения, другие текстурные координаты
+            bool seam = lastVertexCount >= vertexCount && RandomRange(rng, 0, 1);
+            unsigned islandPosBase = seam ? lastPosBase : posBase;
+
+            AddGridIsland(mesh, rng, islandPosBase, uvBase, width, height);
+
+            if(!seam){
+                lastPosBase = posBase;
+                lastVertexCount = vertexCount;
+                posBase += vertexCount;
+            }
+            uvBase += vertexCount;
+        }
+    }
+
+    /**
+     * \brief Перемешать порядок полигонов
+     */
+    Mesh ShufflePolygons(const Mesh& mesh, std::mt19937& rng)
+    {
+        std::vector<unsigned> order(mesh.faceCount());
+        std::iota(order.begin(), order.end(), 0u);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        Mesh shuffled;
+        shuffled.vertices.reserve(mesh.vertices.size());
+        shuffled.faceOffsets.reserve(mesh.faceOffsets.size());
+        for(unsigned p : order)
+        {
+            for(const auto& v : mesh.polygon(p)) shuffled.addVertex(v);
+            shuffled.closePolygon();
+        }
+        return shuffled;
+    }
+
+    /**
+     * \brief Острова-сетки, соединенные мостами из одной общей вершины
+     *
+     * \details Мосты добавляются в конец, после (перемешанных) островов - последующие полигоны почти не касаются
+     * вершин моста, поэтому ошибка объединения на мосту не исправляется позже сама собой
+     */
+    void GenerateBridgedIslands(Mesh& mesh, std::mt19937& rng, unsigned faceCount, bool shuffle)
+    {
+        unsigned gridFaces = faceCount - faceCount / 8;
+        GenerateGridIslands(mesh, rng, gridFaces);
+        if(shuffle) mesh = ShufflePolygons(mesh, rng);
+
+        unsigned posNext = 0, uvNext = 0;
+        for(const auto& v : mesh.vertices){
+            posNext = std::max(posNext, v.posIdx + 1);
+            uvNext = std::max(uvNext, v.uvIdx + 1);
+        }
+
+        const unsigned existing = static_cast<unsigned>(mesh.vertices.size());
+        auto randomExisting = [&](){ return mesh.vertices[RandomRange(rng, 0, existing - 1)]; };
+
+        while(mesh.faceCount() < faceCount)
+        {
+            if(RandomRange(rng, 0, 1))
+            {
+                // Треугольник, каждая вершина которого взята из случайного места (соединяет до трех островов)
+                const Vertex a = randomExisting(), b = randomExisting(), c = randomExisting();
+                mesh.addVertex(a);
+                mesh.addVertex(b);
+                mesh.addVertex(c);
+                mesh.closePolygon();
+            }
+            else
+            {
+                // Веер вокруг одной существующей вершины, остальные вершины новые
+                const Vertex center = randomExisting();
+                unsigned blades = RandomRange(rng, 2, 6);
+                for(unsigned i = 0; i < blades && mesh.faceCount() < faceCount; i++)
+                {
+                    mesh.addVertex(center);
+                    mesh.addVertex({posNext++, uvNext++, 1});
+                    mesh.addVertex({posNext++, uvNext++, 1});
+                    mesh.closePolygon();
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Полигоны из случайных вершин небольшого набора
+     */
+    void GenerateRandomSoup(Mesh& mesh, std::mt19937& rng, unsigned faceCount)
+    {
+        unsigned posPool = std::max(2u, faceCount / 2);
+        unsigned uvPool = RandomRange(rng, 1, 3);
+
+        for(unsigned p = 0; p < faceCount; p++)
+        {
+            unsigned size = RandomRange(rng, 3, 5);
+            for(unsigned i = 0; i < size; i++){
+                mesh.addVertex({RandomRange(rng, 1, posPool), RandomRange(rng, 1, uvPool), RandomRange(rng, 1, 4)});
+            }
+            mesh.closePolygon();
+        }
+    }
+
+    /**
+     * \brief Вырожденные полигоны и общие положения без общих UV
+     */
+    void GenerateDegenerate(Mesh& mesh, std::mt19937& rng, unsigned faceCount)
+    {
+        unsigned pool = std::max(2u, faceCount);
+
+        for(unsigned p = 0; p < faceCount; p++)
+        {
+            unsigned size = RandomRange(rng, 0, 4);
+            Vertex first = {RandomRange(rng, 1, pool), RandomRange(rng, 1, pool), 1};
+            for(unsigned i = 0; i < size; i++)
+            {
+                // Повтор вершины внутри полигона
+                if(i > 0 && RandomRange(rng, 0, 3) == 0) mesh.addVertex(first);
+                // То же положение, но другие текстурные координаты
+                else if(RandomRange(rng, 0, 3) == 0) mesh.addVertex({first.posIdx, RandomRange(rng, 1, pool), 1});
+                else mesh.addVertex({RandomRange(rng, 1, pool), RandomRange(rng, 1, pool), 1});
+            }
+            mesh.closePolygon();
+        }
+    }
+
+    /**
+     * \brief Сдвинуть индексы к верхней границе диапазона
+     */
+    void ShiftToHugeIndices(Mesh& mesh)
+    {
+        unsigned maxIdx = 0;
+        for(const auto& v : mesh.vertices) maxIdx = std::max({maxIdx, v.posIdx, v.uvIdx});
+
+        const unsigned shift = std::numeric_limits<unsigned>::max() - maxIdx;
+        for(auto& v : mesh.vertices){
+            v.posIdx += shift;
+            v.uvIdx += shift;
+        }
+    }
+}
+
+Mesh GenerateMesh(std::mt19937& rng, const MeshGeneratorSettings& settings)
+{
+    Mesh mesh;
+    const unsigned faceCount = std::max(1u, settings.faceCount);
+
+    switch(settings.kind)
+    {
+        case eRandomSoup: GenerateRandomSoup(mesh, rng, faceCount); break;
+        case eBridgedIslands: GenerateBridgedIslands(mesh, rng, faceCount, settings.shuffle); break;
+        case eDegenerate: GenerateDegenerate(mesh, rng, faceCount); break;
+        default: GenerateGridIslands(mesh, rng, faceCount); break;
+    }
+
+    if(settings.hugeIndices) ShiftToHugeIndices(mesh);
+    return settings.shuffle && settings.kind != eBridgedIslands ? ShufflePolygons(mesh, rng) : mesh;
+}
+
+const char* MeshKindName(MeshKind kind)
+{
+    switch(kind)
+    {
+        case eRandomSoup: return "random-soup";
+        case eGridIslands: return "grid-islands";
+        case eBridgedIslands: return "bridged-islands";
+        case eDegenerate: return "degenerate";
+        default: return "unknown";
+    }
+}
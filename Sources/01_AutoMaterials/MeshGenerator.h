@@ -0,0 +1,57 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Генерация случайных мешей.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <random>
+
+#include <Common/Mesh.h>
+
+/**
+ * Вид генерируемого меша
+ */
+enum MeshKind
+{
+    // Полигоны из случайных вершин небольшого набора (много случайных слияний)
+    eRandomSoup,
+    // Отдельные UV острова-сетки, у соседних островов общие положения но разные UV (швы)
+    eGridIslands,
+    // Острова-сетки, соединенные через единственную общую вершину (мосты, веера вокруг одной вершины)
+    eBridgedIslands,
+    // Вырожденные полигоны (0-2 вершины, повторы вершин), общие положения без общих UV
+    eDegenerate,
+    // Кол-во видов
+    eMeshKindCount
+};
+
+/**
+ * \brief Параметры генерации
+ */
+struct MeshGeneratorSettings
+{
+    /// Вид меша
+    MeshKind kind = eGridIslands;
+    /// Приблизительное кол-во полигонов
+    unsigned faceCount = 1000;
+    /// Сдвинуть индексы к верхней границе диапазона unsigned
+    bool hugeIndices = false;
+    /// Перемешать порядок полигонов
+    bool shuffle = true;
+};
+
+/**
+ * \brief Сгенерировать случайный меш
+ * \param rng Генератор случайных чисел
+ * \param settings Параметры генерации
+ * \return Меш
+ */
+Mesh GenerateMesh(std::mt19937& rng, const MeshGeneratorSettings& settings);
+
+/**
+ * \brief Имя вида меша (для отчетов)
+ * \param kind Вид
+ * \return Имя
+ */
+const char* MeshKindName(MeshKind kind);
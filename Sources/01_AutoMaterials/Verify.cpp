@@ -0,0 +1,591 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Сверка алгоритмов разбиения с эталоном.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Verify.h"
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Common/Cpu.h>
+#include <Common/ExternalMemory.h>
+#include <Common/FloatParser.h>
+#include <Common/Geometry.h>
+#include <Common/Grouping.h>
+#include <Common/Islands.h>
+#include <Common/LineIndex.h>
+#include <Common/NormalSplit.h>
+#include <Common/ObjReader.h>
+#include <Common/ObjWriter.h>
+
+namespace
+{
+    /**
+     * \brief Результаты сверки одного алгоритма
+     */
+    struct EngineReport
+    {
+        const GroupingEngine* engine = nullptr;
+        unsigned mismatches = 0;
+        double seconds = 0.0;
+    };
+
+    /**
+     * \brief Совпадают ли разбиения с точностью до перенумерации групп
+     * \param a Первое разбиение
+     * \param b Второе разбиение
+     * \param firstMismatch Первый полигон, на котором обнаружено расхождение
+     * \return Да или нет
+     */
+    bool SamePartition(const Partition& a, const Partition& b, unsigned& firstMismatch)
+    {
+        const unsigned NO_LABEL = std::numeric_limits<unsigned>::max();
+        firstMismatch = 0;
+
+        if(a.labels.size() != b.labels.size() || a.groupCount != b.groupCount) return false;
+
+        // Соответствие групп должно быть взаимно однозначным
+        std::vector<unsigned> aToB(a.groupCount, NO_LABEL), bToA(b.groupCount, NO_LABEL);
+        for(unsigned p = 0; p < a.labels.size(); p++)
+        {
+            const unsigned la = a.labels[p], lb = b.labels[p];
+            if(la >= a.groupCount || lb >= b.groupCount) { firstMismatch = p; return false; }
+            if(aToB[la] == NO_LABEL && bToA[lb] == NO_LABEL) { aToB[la] = lb; bToA[lb] = la; }
+            if(aToB[la] != lb || bToA[lb] != la) { firstMismatch = p; return false; }
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Запустить алгоритм разбиения и замерить время
+     */
+    Partition RunTimed(const GroupingEngine& engine, const Mesh& mesh, ThreadPool& pool, double& seconds)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Partition partition = engine.divide(mesh, pool);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return partition;
+    }
+
+    /**
+     * \brief Есть ли в одной группе полигоны, нормали которых расходятся больше заданного угла
+     * \param normals Нормали полигонов
+     * \param labels Группа каждого полигона
+     * \param maxAngle Угол, градусов
+     * \return Да или нет
+     */
+    bool ExceedsAngle(const Coordinates& normals, const std::vector<unsigned>& labels, float maxAngle)
+    {
+        // Допуск - погрешность нормалей, вычисленных в float
+        const float DOT_EPSILON = 1e-3f;
+        const float minDot = std::cos(maxAngle * 3.14159265f / 180.0f) - DOT_EPSILON;
+        for(size_t a = 0; a < labels.size(); a++)
+        {
+            for(size_t b = a + 1; b < labels.size(); b++)
+            {
+                const float dot = normals.x[a] * normals.x[b] + normals.y[a] * normals.y[b] + normals.z[a] * normals.z[b];
+                if(labels[a] == labels[b] && dot < minDot) return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * \brief Текст .obj файла с углом куба: три перпендикулярные грани из сетки квадратов, один остров развертки
+     * \param size Кол-во квадратов вдоль стороны грани
+     * \param rotation Поворот (матрица 3x3)
+     * \return Текст
+     */
+    std::string CubeCornerObj(unsigned size, const float rotation[3][3])
+    {
+        std::ostringstream text;
+        text << std::setprecision(9);
+        const unsigned side = size + 1;
+        for(unsigned axis = 0; axis < 3; axis++)
+        {
+            for(unsigned a = 0; a < side; a++)
+            {
+                for(unsigned b = 0; b < side; b++)
+                {
+                    float p[3] = {};
+                    p[(axis + 1) % 3] = static_cast<float>(a);
+                    p[(axis + 2) % 3] = static_cast<float>(b);
+                    text << "v " << rotation[0][0] * p[0] + rotation[0][1] * p[1] + rotation[0][2] * p[2] << ' '
+                         << rotation[1][0] * p[0] + rotation[1][1] * p[1] + rotation[1][2] * p[2] << ' '
+                         << rotation[2][0] * p[0] + rotation[2][1] * p[1] + rotation[2][2] * p[2] << '\n';
+                }
+            }
+        }
+
+        // Общие ребра граней не склеиваются по индексам, остров объединяет общая текстурная координата
+        text << "vt 0 0\n";
+        for(unsigned axis = 0; axis < 3; axis++)
+        {
+            const unsigned first = axis * side * side + 1;
+            for(unsigned a = 0; a < size; a++)
+            {
+                for(unsigned b = 0; b < size; b++)
+                {
+                    const unsigned v = first + a * side + b;
+                    text << "f " << v << "/1 " << v + side << "/1 " << v + side + 1 << "/1 " << v + 1 << "/1\n";
+                }
+            }
+        }
+        return text.str();
+    }
+
+    /**
+     * \brief Группа каждого полигона
+     * \param groups Группы
+     * \param faceCount Кол-во полигонов
+     * \return Группы полигонов
+     */
+    std::vector<unsigned> FaceLabels(const GroupMembers& groups, size_t faceCount)
+    {
+        std::vector<unsigned> labels(faceCount);
+        for(unsigned g = 0; g < groups.groupCount(); g++)
+        {
+            for(unsigned p = groups.offsets[g]; p < groups.offsets[g + 1]; p++) labels[groups.polygons[p]] = g;
+        }
+        return labels;
+    }
+}
+
+unsigned VerifyGroupingEngines(const VerifySettings& settings)
+{
+    const auto& engines = GetGroupingEngines();
+    const GroupingEngine& reference = engines.front();
+
+    std::vector<EngineReport> reports(engines.size());
+    for(unsigned e = 0; e < engines.size(); e++) reports[e].engine = &engines[e];
+
+    ThreadPool pool(settings.threads);
+    std::mt19937 rng(settings.seed);
+    unsigned long long totalFaces = 0;
+
+    for(unsigned i = 0; i < settings.iterations; i++)
+    {
+        // Вид меша и его размер меняются от итерации к итерации, каждый второй набор - с огромными индексами
+        MeshGeneratorSettings meshSettings;
+        meshSettings.kind = static_cast<MeshKind>(i % eMeshKindCount);
+        meshSettings.hugeIndices = (i / eMeshKindCount) % 2 == 1;
+        meshSettings.faceCount = std::uniform_int_distribution<unsigned>(1, std::max(1u, settings.maxFaces))(rng);
+
+        const Mesh mesh = GenerateMesh(rng, meshSettings);
+        totalFaces += mesh.faceCount();
+
+        const Partition expected = RunTimed(reference, mesh, pool, reports.front().seconds);
+
+        // Копии меша с другой разрядностью индексов (16 бит - только если индексы помещаются)
+        const Mesh64 mesh64 = ConvertMesh<uint64_t>(mesh);
+        const bool fits16 = std::all_of(mesh.vertices.begin(), mesh.vertices.end(), [](const Vertex& v){
+            return std::max({v.posIdx, v.uvIdx, v.normalIdx}) <= std::numeric_limits<uint16_t>::max();
+        });
+        const Mesh16 mesh16 = fits16 ? ConvertMesh<uint16_t>(mesh) : Mesh16();
+
+        for(unsigned e = 1; e < engines.size(); e++)
+        {
+            // Время замеряется на исходной (32-битной) разрядности, результат сверяется на всех
+            std::vector<std::pair<const char*, Partition>> results;
+            results.emplace_back("32-bit", RunTimed(engines[e], mesh, pool, reports[e].seconds));
+            results.emplace_back("64-bit", engines[e].divide(mesh64, pool));
+            if(fits16) results.emplace_back("16-bit", engines[e].divide(mesh16, pool));
+
+            for(const auto& result : results)
+            {
+                const Partition& actual = result.second;
+
+                unsigned firstMismatch = 0;
+                if(!SamePartition(expected, actual, firstMismatch))
+                {
+                    reports[e].mismatches++;
+                    std::cout << "MISMATCH: engine \"" << engines[e].name << "\" (" << result.first << " indices), iteration " << i
+                              << " (" << MeshKindName(meshSettings.kind) << (meshSettings.hugeIndices ? ", huge indices" : "")
+                              << ", " << mesh.faceCount() << " faces): expected " << expected.groupCount << " groups, got "
+                              << actual.groupCount << ", first differing polygon " << firstMismatch << std::endl;
+                }
+            }
+        }
+    }
+
+    // Отчет
+    std::cout << std::endl << "Verified " << settings.iterations << " meshes (" << totalFaces << " faces, seed "
+              << settings.seed << ", " << pool.threadCount() << " threads)" << std::endl;
+    std::cout << std::left << std::setw(14) << "engine" << std::right << std::setw(12) << "mismatches"
+              << std::setw(14) << "time, ms" << std::setw(12) << "speedup" << std::endl;
+
+    unsigned totalMismatches = 0;
+    for(const auto& report : reports)
+    {
+        totalMismatches += report.mismatches;
+        const double speedup = report.seconds > 0.0 ? reports.front().seconds / report.seconds : 0.0;
+        std::cout << std::left << std::setw(14) << report.engine->name << std::right << std::setw(12) << report.mismatches
+                  << std::setw(14) << std::fixed << std::setprecision(2) << report.seconds * 1000.0
+                  << std::setw(11) << std::setprecision(1) << speedup << "x" << std::endl;
+    }
+
+    return totalMismatches;
+}
+
+unsigned VerifyLineIndexKernels(const VerifySettings& settings)
+{
+    static const char* const LINES[] = {"f 1/1/1 2/2/2 3/3/3", "v 0.5 1 2", "vt 0 1", "vn 0 0 1", "usemtl m", "mtllib a.mtl",
+                                        "# comment", "", "f", "v", "vtx", "g group", "o object", "o", "\r"};
+
+    const InstructionSet active = ActiveInstructionSet();
+    ThreadPool pool(settings.threads);
+    std::mt19937 rng(settings.seed);
+    unsigned mismatches = 0;
+
+    for(unsigned i = 0; i < settings.iterations; i++)
+    {
+        // Случайный текст (длина от нескольких байт до нескольких фрагментов)
+        std::string text;
+        const unsigned lineCount = std::uniform_int_distribution<unsigned>(0, 1u << (i % 18u))(rng);
+        for(unsigned l = 0; l < lineCount; l++)
+        {
+            text += LINES[std::uniform_int_distribution<size_t>(0, std::size(LINES) - 1)(rng)];
+            if(l + 1 < lineCount || rng() % 2 == 0) text += '\n';
+        }
+
+        ForceInstructionSet(eIsaScalar);
+        const LineIndex expected = BuildLineIndex(text.data(), text.size(), pool);
+
+        for(int isa = eIsaScalar + 1; isa <= DetectInstructionSet(); isa++)
+        {
+            ForceInstructionSet(static_cast<InstructionSet>(isa));
+            const LineIndex actual = BuildLineIndex(text.data(), text.size(), pool);
+            if(actual.starts != expected.starts || actual.types != expected.types || actual.chunkLines != expected.chunkLines)
+            {
+                mismatches++;
+                std::cout << "MISMATCH: line index kernel \"" << InstructionSetName(static_cast<InstructionSet>(isa))
+                          << "\", iteration " << i << " (" << text.size() << " bytes): expected " << expected.lineCount()
+                          << " lines, got " << actual.lineCount() << std::endl;
+            }
+        }
+    }
+
+    ForceInstructionSet(active);
+    std::cout << "Verified line index kernels up to " << InstructionSetName(DetectInstructionSet()) << " on "
+              << settings.iterations << " texts: " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+unsigned VerifyFloatParser(const VerifySettings& settings)
+{
+    // На каждую итерацию - пакет чисел (итераций по умолчанию немного, а разбор дешевый)
+    const unsigned NUMBERS_PER_ITERATION = 1000;
+
+    std::mt19937 rng(settings.seed);
+    unsigned mismatches = 0;
+    unsigned checked = 0;
+
+    auto digits = [&](std::string& text, unsigned count){
+        for(unsigned d = 0; d < count; d++) text += static_cast<char>('0' + rng() % 10u);
+    };
+
+    for(unsigned i = 0; i < settings.iterations * NUMBERS_PER_ITERATION; i++)
+    {
+        // Случайное число: знак, целая часть, дробная часть, показатель степени, хвост после числа
+        std::string text;
+        if(rng() % 4u == 0) text += rng() % 2u == 0 ? '-' : '+';
+        const unsigned longMantissa = rng() % 8u == 0 ? 20u : 0u;
+        digits(text, std::uniform_int_distribution<unsigned>(0, 6 + longMantissa)(rng));
+        if(rng() % 4u != 0){
+            text += '.';
+            digits(text, std::uniform_int_distribution<unsigned>(0, 9 + longMantissa)(rng));
+        }
+        if(rng() % 4u == 0){
+            text += rng() % 2u == 0 ? 'e' : 'E';
+            if(rng() % 2u == 0) text += rng() % 2u == 0 ? '-' : '+';
+            digits(text, std::uniform_int_distribution<unsigned>(0, 2)(rng));
+        }
+        if(rng() % 2u == 0) text += rng() % 2u == 0 ? " 1.5" : "x";
+
+        // Эталон (std::from_chars не допускает знак "+")
+        const char* begin = text.data();
+        const char* end = text.data() + text.size();
+        float expected = 0.0f;
+        const auto reference = std::from_chars(begin + (*begin == '+' ? 1 : 0), end, expected);
+
+        // Сверяются только числа, которые разбирает эталон (значения вне диапазона float он не возвращает)
+        if(reference.ec != std::errc()) continue;
+        checked++;
+
+        float actual = 0.0f;
+        const char* p = begin;
+        const bool parsed = ParseFloat(p, end, actual);
+
+        uint32_t expectedBits = 0, actualBits = 0;
+        std::memcpy(&expectedBits, &expected, sizeof(expected));
+        std::memcpy(&actualBits, &actual, sizeof(actual));
+
+        if(!parsed || p != reference.ptr || actualBits != expectedBits){
+            mismatches++;
+            std::cout << "MISMATCH: float parser, \"" << text << "\": expected " << expected << " (" << (reference.ptr - begin)
+                      << " chars), got " << actual << " (" << (p - begin) << " chars)" << std::endl;
+        }
+    }
+
+    std::cout << "Verified float parser on " << checked << " numbers: " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+unsigned VerifyLineEndings(const VerifySettings& settings)
+{
+    static const char* const LINES[] = {"v 0.5 1 2", "v -1 0 3", "vt 0 1", "vt 0.25 0.75 1", "vn 0 0 1", "f 1/1/1 2/1/1 3/1/1", "f -1/-1/-1 -2/-1/-1 -3/-1/-1",
+                                        "usemtl m", "mtllib a.mtl", "# comment", "", "o object", "g", "s 1", "s off", "l 1 2"};
+
+    ThreadPool pool(settings.threads);
+    std::mt19937 rng(settings.seed);
+    unsigned mismatches = 0;
+
+    for(unsigned i = 0; i < settings.iterations; i++)
+    {
+        // Один и тот же текст с переводами строк LF и CRLF (вершины идут первыми, чтобы индексы полигонов были верны)
+        std::string lf = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n";
+        const unsigned lineCount = std::uniform_int_distribution<unsigned>(0, 1u << (i % 14u))(rng);
+        for(unsigned l = 0; l < lineCount; l++)
+        {
+            lf += LINES[std::uniform_int_distribution<size_t>(0, std::size(LINES) - 1)(rng)];
+            if(l + 1 < lineCount || rng() % 2 == 0) lf += '\n';
+        }
+        std::string crlf;
+        for(char c : lf)
+        {
+            if(c == '\n') crlf += '\r';
+            crlf += c;
+        }
+
+        const LineIndex lfIndex = BuildLineIndex(lf.data(), lf.size(), pool);
+        const LineIndex crlfIndex = BuildLineIndex(crlf.data(), crlf.size(), pool);
+
+        TextLines lfBase, crlfBase, crlfScanBase;
+        ReadBaseObjData(lf.data(), lfIndex, lfBase);
+        ReadBaseObjData(crlf.data(), crlfIndex, crlfBase);
+        ReadBaseObjData(crlf.data(), crlf.size(), crlfScanBase);
+        const bool carriageReturn = std::any_of(crlfBase.begin(), crlfBase.end(), [](const std::pmr::string& line){
+            return line.find('\r') != std::pmr::string::npos;
+        });
+
+        Mesh lfMesh, crlfMesh;
+        ReadPolygons(lf.data(), lf.size(), lfMesh, pool);
+        ReadPolygons(crlf.data(), crlf.size(), crlfMesh, pool);
+        const bool sameMesh = lfMesh.faceOffsets == crlfMesh.faceOffsets &&
+                              std::equal(lfMesh.vertices.begin(), lfMesh.vertices.end(), crlfMesh.vertices.begin(), crlfMesh.vertices.end(),
+                                         [](const Vertex& a, const Vertex& b){ return a == b && a.normalIdx == b.normalIdx; });
+
+        // Координаты из сохраненных строк основной информации - те же, что и из содержимого файла
+        const ObjScan crlfScan = ScanObjFile(crlf.data(), crlf.size(), pool);
+        ObjGeometry geometry(crlf.data(), crlfScan, pool);
+        auto sameCoordinates = [](const Coordinates& a, const Coordinates& b){
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        };
+        const bool sameGeometry = sameCoordinates(ReadBaseCoordinates(crlfBase, eLinePosition), geometry.positions()) &&
+                                  sameCoordinates(ReadBaseCoordinates(crlfBase, eLineTexCoord), geometry.texCoords());
+
+        if(lfIndex.types != crlfIndex.types || lfBase != crlfBase || crlfBase != crlfScanBase || carriageReturn || !sameMesh || !sameGeometry)
+        {
+            mismatches++;
+            std::cout << "MISMATCH: CRLF line endings, iteration " << i << " (" << lineCount << " lines): "
+                      << (lfIndex.types != crlfIndex.types ? "line types" : !sameMesh ? "polygons" : !sameGeometry ? "coordinates" : "base data")
+                      << " differ" << std::endl;
+        }
+    }
+
+    std::cout << "Verified CRLF line endings on " << settings.iterations << " texts: " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+unsigned VerifyNormalRule(const VerifySettings& settings)
+{
+    // Грани куба - острова из одного полигона, каждая грань смежна со всеми, кроме противоположной
+    const unsigned FACES = 6;
+    const float AXES[FACES][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+    // Кол-во квадратов вдоль стороны грани угла куба
+    const unsigned CORNER_SIZE = 5;
+
+    GroupMembers islands;
+    IslandGraph graph;
+    graph.offsets.push_back(0);
+    for(unsigned f = 0; f < FACES; f++)
+    {
+        islands.offsets.push_back(f);
+        islands.polygons.push_back(f);
+        for(unsigned g = 0; g < FACES; g++)
+        {
+            if(g == f || g == (f ^ 1u)) continue;
+            graph.neighbours.push_back(g);
+            graph.weights.push_back(1);
+        }
+        graph.offsets.push_back(static_cast<unsigned>(graph.neighbours.size()));
+    }
+    islands.offsets.push_back(FACES);
+
+    IslandDuplicates duplicates;
+    duplicates.classOf.assign(FACES, 0);
+    duplicates.repeatedShapes = 1;
+    duplicates.repeatedIslands = FACES;
+
+    ThreadPool pool(settings.threads);
+    std::mt19937 rng(settings.seed);
+    std::normal_distribution<float> gauss;
+    unsigned mismatches = 0;
+
+    for(unsigned i = 0; i < settings.iterations; i++)
+    {
+        // Куб в случайном положении (нормали перпендикулярных граней с погрешностью float)
+        float q[4] = {gauss(rng), gauss(rng), gauss(rng), gauss(rng)};
+        const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        for(float& c : q) c = length > 0.0f ? c / length : 0.5f;
+        const float w = q[0], x = q[1], y = q[2], z = q[3];
+        const float rotation[3][3] = {{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)},
+                                      {2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)},
+                                      {2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)}};
+        Coordinates normals;
+        normals.resize(FACES);
+        for(unsigned f = 0; f < FACES; f++)
+        {
+            normals.x[f] = rotation[0][0] * AXES[f][0] + rotation[0][1] * AXES[f][1] + rotation[0][2] * AXES[f][2];
+            normals.y[f] = rotation[1][0] * AXES[f][0] + rotation[1][1] * AXES[f][1] + rotation[1][2] * AXES[f][2];
+            normals.z[f] = rotation[2][0] * AXES[f][0] + rotation[2][1] * AXES[f][1] + rotation[2][2] * AXES[f][2];
+        }
+
+        // Перпендикулярные грани объединяются при угле 90 градусов, противоположные - нет
+        IslandMergeSettings mergeSettings;
+        mergeSettings.maxFaces = 1;
+        mergeSettings.maxNormalAngle = 90.0f;
+        const IslandMerge merge = MergeSmallIslands(islands, graph, mergeSettings, normals, {}, {}, pool);
+        const std::vector<unsigned> mergeLabels = FaceLabels(merge.groups, FACES);
+
+        const IslandPartition budget = PartitionIslands(islands, 4, 90.0f, normals, {}, pool);
+        const IslandPartition shared = ShareDuplicateIslands(islands, duplicates, 90.0f, normals, pool);
+
+        const char* failed = merge.mergedCount == 0 || ExceedsAngle(normals, mergeLabels, 90.0f) ? "small island merge" :
+                             budget.groupCount > 4 || ExceedsAngle(normals, budget.labels, 90.0f) ? "material budget" :
+                             shared.groupCount == FACES || ExceedsAngle(normals, shared.labels, 90.0f) ? "duplicate islands" : nullptr;
+        if(failed)
+        {
+            mismatches++;
+            std::cout << "MISMATCH: normal rule, iteration " << i << ": " << failed << " (" << merge.groups.groupCount() << ", "
+                      << budget.groupCount << " and " << shared.groupCount << " groups of cube faces at 90 degrees)" << std::endl;
+        }
+
+        // Угол куба (больше полигонов, чем в прежнем пределе попарной проверки) делится только при угле меньше 90 градусов
+        const std::string corner = CubeCornerObj(CORNER_SIZE, rotation);
+        const ObjScan scan = ScanObjFile(corner.data(), corner.size(), pool);
+        Mesh mesh;
+        ReadPolygons(corner.data(), corner.size(), scan, mesh, pool);
+        ObjGeometry geometry(corner.data(), scan, pool);
+        const Coordinates faceNormals = ComputeFaceNormals(mesh, geometry, pool);
+
+        GroupMembers island;
+        island.offsets = {0, static_cast<unsigned>(mesh.faceCount())};
+        island.polygons.resize(mesh.faceCount());
+        std::iota(island.polygons.begin(), island.polygons.end(), 0u);
+
+        const float maxAngle = static_cast<float>(std::uniform_int_distribution<unsigned>(45, 135)(rng));
+        const NormalSplit split = SplitGroupsByNormals(mesh, island, faceNormals, maxAngle, pool);
+        const unsigned expected = maxAngle >= 90.0f ? 1 : 3;
+        if(split.groups.groupCount() != expected || ExceedsAngle(faceNormals, FaceLabels(split.groups, mesh.faceCount()), maxAngle))
+        {
+            mismatches++;
+            std::cout << "MISMATCH: normal rule, iteration " << i << ": cube corner of " << mesh.faceCount() << " polygons split into "
+                      << split.groups.groupCount() << " groups at " << maxAngle << " degrees (expected " << expected << ")" << std::endl;
+        }
+    }
+
+    std::cout << "Verified normal rule on " << settings.iterations << " cubes and cube corners: " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+unsigned VerifyExternalMemory(const VerifySettings& settings)
+{
+    static const char* const EXTRA_LINES[] = {"usemtl m", "o object", "g", "s 1", "# comment", "mtllib a.mtl", ""};
+
+    // Ограничение памяти в 1 байт - буферы серий наименьшего размера (больше полигонов - больше временных файлов)
+    const size_t MEMORY_LIMIT = 1;
+
+    const std::filesystem::path objPath = std::filesystem::temp_directory_path() / "sed_verify_external.obj";
+    ThreadPool pool(settings.threads);
+    std::mt19937 rng(settings.seed);
+    unsigned mismatches = 0;
+    size_t runs = 0;
+
+    for(unsigned i = 0; i < settings.iterations; i++)
+    {
+        // Вершины, затем полигоны со случайными (в том числе относительными) индексами и прочими строками
+        const unsigned faceCount = std::uniform_int_distribution<unsigned>(1, 1u << (i % 18u))(rng);
+        const unsigned positions = std::max(3u, faceCount / 2), texCoords = std::max(1u, faceCount / 2);
+        std::string text;
+        for(unsigned v = 0; v < positions; v++) text += "v " + std::to_string(v) + " 0 1\n";
+        for(unsigned t = 0; t < texCoords; t++) text += "vt 0." + std::to_string(t) + " 1\n";
+        std::uniform_int_distribution<unsigned> position(1, positions), texCoord(1, texCoords);
+        for(unsigned f = 0; f < faceCount; f++)
+        {
+            if(rng() % 64 == 0) text += std::string(EXTRA_LINES[std::uniform_int_distribution<size_t>(0, std::size(EXTRA_LINES) - 1)(rng)]) + '\n';
+            const bool relative = rng() % 8 == 0;
+            text += 'f';
+            for(unsigned v = 0, count = 3 + rng() % 2; v < count; v++)
+            {
+                const unsigned p = position(rng), t = texCoord(rng);
+                text += relative ? " -" + std::to_string(positions - p + 1) + "/-" + std::to_string(texCoords - t + 1)
+                                 : " " + std::to_string(p) + "/" + std::to_string(t);
+            }
+            text += '\n';
+        }
+
+        // Обработка в памяти
+        const ObjScan scan = ScanObjFile(text.data(), text.size(), pool);
+        Mesh64 mesh;
+        ReadPolygons(text.data(), text.size(), scan, mesh, pool);
+        const GroupMembers groups = CollectGroupMembers(FindGroupingEngine("parallel")->divide(mesh, pool));
+        TextLines baseData;
+        ReadBaseObjData(text.data(), scan.lines, baseData);
+        const std::pmr::string expected = FormatObjText("verify.mtl", baseData, mesh, groups, pool);
+
+        // Обработка во внешней памяти
+        std::string actual;
+        ExternalStats stats;
+        try{
+            ConvertFileExternal(text.data(), text.size(), "verify.mtl", objPath.string(), scan, MEMORY_LIMIT, stats);
+            std::ifstream in(objPath, std::ios::in | std::ios::binary);
+            actual.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }catch(std::exception& e){
+            actual = e.what();
+        }
+        runs += stats.keyRuns + stats.faceRuns;
+
+        if(actual != std::string_view(expected.data(), expected.size()))
+        {
+            mismatches++;
+            std::cout << "MISMATCH: external memory, iteration " << i << " (" << faceCount << " polygons, " << stats.keyRuns
+                      << " + " << stats.faceRuns << " temporary runs): output differs from in-memory output" << std::endl;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::remove(objPath, error);
+    std::cout << "Verified external memory on " << settings.iterations << " files (" << runs << " temporary runs): "
+              << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
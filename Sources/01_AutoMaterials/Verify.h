@@ -0,0 +1,91 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Сверка алгоритмов разбиения с эталоном.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+/**
+ * \brief Параметры сверки
+ */
+struct VerifySettings
+{
+    /// Кол-во случайных мешей
+    unsigned iterations = 200;
+    /// Начальное значение генератора случайных чисел
+    unsigned seed = 1;
+    /// Максимальное кол-во полигонов в меше (эталонный алгоритм квадратичный)
+    unsigned maxFaces = 2000;
+    /// Кол-во потоков для параллельных алгоритмов (0 - по кол-ву аппаратных потоков)
+    unsigned threads = 0;
+};
+
+/**
+ * \brief Сверить все алгоритмы разбиения с эталонным на случайных мешах
+ *
+ * \details Разбиения сравниваются с точностью до перенумерации групп. Каждый алгоритм проверяется на 32- и 64-битных
+ * индексах, а также на 16-битных, если индексы меша в них помещаются. Выводит расхождения и отношение скорости
+ * каждого алгоритма к эталонному
+ *
+ * \param settings Параметры сверки
+ * \return Кол-во расхождений
+ */
+unsigned VerifyGroupingEngines(const VerifySettings& settings);
+
+/**
+ * \brief Сверить реализации ядер индекса строк для всех наборов инструкций, поддерживаемых процессором, с побайтной
+ *
+ * \details Случайные тексты (строки разных типов и длин, пустые строки, отсутствие завершающего перевода строки)
+ * индексируются с каждым набором инструкций. После сверки выбор набора инструкций восстанавливается
+ *
+ * \param settings Параметры сверки (кол-во итераций, начальное значение генератора, потоки)
+ * \return Кол-во расхождений
+ */
+unsigned VerifyLineIndexKernels(const VerifySettings& settings);
+
+/**
+ * \brief Сверить быстрый разбор чисел с плавающей точкой с std::from_chars
+ *
+ * \details Случайные числа (знаки, целые и дробные части разной длины, показатели степени, длинные мантиссы,
+ * денормализованные и переполняющиеся значения) сравниваются побитово вместе с позицией конца числа
+ *
+ * \param settings Параметры сверки (кол-во итераций, начальное значение генератора)
+ * \return Кол-во расхождений
+ */
+unsigned VerifyFloatParser(const VerifySettings& settings);
+
+/**
+ * \brief Сверить чтение файлов с переводами строк CRLF с чтением того же текста с переводами LF
+ *
+ * \details Случайные тексты из строк .obj файла сравниваются по типам строк индекса, основной информации (по индексу
+ * строк и без него, строки не должны содержать "\r") и полигонам. Координаты, прочитанные из сохраненных строк
+ * основной информации, сверяются с координатами из содержимого файла
+ *
+ * \param settings Параметры сверки (кол-во итераций, начальное значение генератора, потоки)
+ * \return Кол-во расхождений
+ */
+unsigned VerifyLineEndings(const VerifySettings& settings);
+
+/**
+ * \brief Проверить соблюдение правила нормалей при разделении групп, слиянии островов, ограничении и общих материалах
+ *
+ * \details Грани куба в случайном положении (острова из одного полигона) при угле 90 градусов: перпендикулярные
+ * грани должны объединяться. Угол куба из 75 полигонов (один остров) при случайном угле должен делиться, только если
+ * угол меньше 90 градусов. Нормали полигонов каждой группы должны расходиться не больше чем на угол
+ *
+ * \param settings Параметры сверки (кол-во итераций, начальное значение генератора, потоки)
+ * \return Кол-во расхождений
+ */
+unsigned VerifyNormalRule(const VerifySettings& settings);
+
+/**
+ * \brief Сверить обработку во внешней памяти с обработкой в памяти
+ *
+ * \details Случайные файлы (до 2^17 полигонов, относительные индексы, прочие строки) обрабатываются с наименьшими
+ * буферами серий, поэтому большие файлы сортируются через несколько временных файлов. Результат во внешней
+ * памяти (временный .obj файл) должен совпадать с текстом, полученным в памяти, побайтно
+ *
+ * \param settings Параметры сверки (кол-во итераций, начальное значение генератора, потоки)
+ * \return Кол-во расхождений
+ */
+unsigned VerifyExternalMemory(const VerifySettings& settings);
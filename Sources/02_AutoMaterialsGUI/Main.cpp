@@ -7,10 +7,7 @@
 #include <stdexcept>
 #include <cstring>
 #include <vector>
-#include <unordered_set>
-#include <algorithm>
 #include <string>
-#include <sstream>
 #include <fstream>
 
 #define NK_INCLUDE_FIXED_TYPES
@@ -23,6 +20,16 @@
 #include <nuklear/nuklear.h>
 #include <nuklear/nuklear_gdi.h>
 
+#include <Common/Arena.h>
+#include <Common/Geometry.h>
+#include <Common/Mesh.h>
+#include <Common/Grouping.h>
+#include <Common/ObjReader.h>
+#include <Common/ObjWriter.h>
+#include <Common/Platform.h>
+#include <Common/ThreadPool.h>
+#include <Common/Welding.h>
+
 /// Дескриптор осноного окна отрисовки
 HWND g_hwnd = nullptr;
 /// Дескриптор контекста отрисовки
@@ -34,69 +41,6 @@ const char* g_strWindowCaption = "SED Auto Materials";
 /// Контекст GUI Nuklear
 struct nk_context *g_nkContext = nullptr;
 
-/**
- * \brief Структура описывающая вершину
- *
- * \details Основной критений сравнения вершин - положение и текстурные координаты. Не обязательно хранить сами данные,
- * достаточно значть что индексы положения и текстурных координат совпадают
- */
-struct Vertex
-{
-    unsigned posIdx = 0;
-    unsigned uvIdx = 0;
-    unsigned normalIdx = 0;
-
-    bool operator==(const Vertex& v) const{
-        return this->posIdx == v.posIdx && this->uvIdx == v.uvIdx;
-    }
-
-    struct Hash
-    {
-        size_t operator()(const Vertex& v) const{
-            return std::hash<std::string>()(std::to_string(v.posIdx) + std::to_string(v.uvIdx));
-        }
-    };
-};
-
-/**
- * \brief Группа вершин
- *
- * \details Полигоны в группе объединены общими вершиными
- */
-struct Group
-{
-    std::vector<unsigned> polygons;
-    std::unordered_set<Vertex, Vertex::Hash> vertices;
-
-    [[nodiscard]] bool polygonBelongs(const std::vector<Vertex>& polygonVertices) const
-    {
-        return std::any_of(polygonVertices.begin(),polygonVertices.end(),[&](const Vertex& v){
-            return vertices.count(v);
-        });
-    }
-
-    void addPolygon(const unsigned polygonIdx, const std::vector<Vertex>& polygonVertices)
-    {
-        polygons.push_back(polygonIdx);
-
-        for(const auto& v : polygonVertices){
-            vertices.insert(v);
-        }
-    }
-
-    void joinGroup(Group& group)
-    {
-        polygons.insert(polygons.end(),group.polygons.begin(),group.polygons.end());
-        vertices.merge(group.vertices);
-    }
-
-    void cleanGroup()
-    {
-        polygons.clear();
-        vertices.clear();
-    }
-};
-
 /**
  * Глобальное ссостояние приложения
  */
@@ -130,14 +74,26 @@ GlobalAppState g_eGlobalState = GlobalAppState::eFileNotSelected;
 
 /// Путь к выбранному файлу
 std::string g_strPathToFile;
-/// Массив полигонов
-std::vector<std::vector<Vertex>> g_vPolygons;
+/// Арена данных текущего файла (освобождается при выборе следующего файла, блоки переиспользуются)
+Arena g_arena;
+/// Полигоны
+Mesh g_mesh(&g_arena);
+/// Полигоны с совпадающими текстурными координатами, замененными одним индексом (пусто - совпадающих нет)
+Mesh g_uvWeldedMesh(&g_arena);
+/// Слияние текстурных координат уже выполнено (выполняется при первом делении на UV группы со слиянием)
+bool g_bUvWelded = false;
+/// Допуск совпадения текстурных координат
+const float g_fUvWeldTolerance = 1.0e-5f;
+/// Сливать совпадающие текстурные координаты при делении на UV группы
+bool g_bWeldUv = true;
 /// Основная информация .obj (вершины, нормали, uv-координаты, не включая данные о полигонах)
-std::vector<std::string> g_objBaseData;
-/// Массив групп
-std::vector<Group> g_vGroups;
+TextLines g_objBaseData(&g_arena);
+/// Группы полигонов
+GroupMembers g_groups(&g_arena);
 /// Текущий способ деления на группы
 DivisionMode g_eDivisionMode = DivisionMode::ePerUvGroup;
+/// Пул потоков (чтение, разбиение, экспорт)
+ThreadPool g_threadPool;
 
 /**
  * Обработчик оконных сообщений
@@ -171,18 +127,6 @@ void OnFileSelected(const std::string& filePath);
  */
 void OnExportFileSelected(const std::string& filePath);
 
-/**
- * Считать данные о полигонах из файла
- * @param in Объект открытого потока чтения
- */
-void ReadPolygons(std::ifstream& in);
-
-/**
- * Считать основную информацию .obj файла
- * @param in Объект открытого потока чтения
- */
-void ReadBaseObjData(std::ifstream& in);
-
 /**
  * Деление геометрии на материалы - по материалу на каждую UV группу
  */
@@ -334,7 +278,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                 {
                     nk_gdi_set_font(font2);
                     nk_layout_row_dynamic(g_nkContext, 30, 1);
-                    nk_label(g_nkContext, std::string("Loaded " + std::to_string(g_vPolygons.size()) + " polygons").c_str(), nk_text_alignment::NK_TEXT_LEFT);
+                    nk_label(g_nkContext, std::string("Loaded " + std::to_string(g_mesh.faceCount()) + " polygons").c_str(), nk_text_alignment::NK_TEXT_LEFT);
                 }
                 nk_end(g_nkContext);
 
@@ -354,7 +298,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                         }
                     }
 
-                    std::string exportLabel = "Export (" + std::to_string(g_vGroups.size()) + " groups)";
+                    std::string exportLabel = "Export (" + std::to_string(g_groups.groupCount()) + " groups)";
                     if (nk_button_label(g_nkContext, exportLabel.c_str())){
                         OnExportFileButtonPressed();
                     }
@@ -367,6 +311,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                             g_eDivisionMode = DivisionMode::ePerPolygon;
                         }
                     }
+
+                    nk_bool weldUv = g_bWeldUv ? nk_true : nk_false;
+                    if (nk_checkbox_label(g_nkContext, "Weld duplicate UVs", &weldUv))
+                    {
+                        g_bWeldUv = weldUv == nk_true;
+                        if(g_eDivisionMode == DivisionMode::ePerUvGroup) g_eGlobalState = GlobalAppState::eFileRead;
+                    }
                 }
                 nk_end(g_nkContext);
             }
@@ -490,26 +441,36 @@ void OnExportFileButtonPressed()
  */
 void OnFileSelected(const std::string& filePath)
 {
-    // Открыть файл для чтения
-    std::ifstream in(filePath,std::ifstream::in);
+    // Открыть файл для чтения (отображение в память)
+    MappedFile in;
 
     // Если не удается открыть
-    if(in.fail()){
+    if(!in.open(filePath)){
         g_eGlobalState = GlobalAppState::eCanNotOpen;
         MessageBoxA(nullptr,"Can't open file for reading.","Error", MB_OK);
         return;
     }
 
-    // Прочесть данные полигонов
-    ReadPolygons(in);
-    if(g_vPolygons.empty()){
+    // Данные предыдущего файла освобождаются разом
+    g_mesh = Mesh(&g_arena);
+    g_uvWeldedMesh = Mesh(&g_arena);
+    g_bUvWelded = false;
+    g_objBaseData = TextLines(&g_arena);
+    g_groups = GroupMembers(&g_arena);
+    g_arena.release();
+
+    // Предварительный проход (точные размеры массивов), затем данные полигонов
+    const ObjScan scan = ScanObjFile(in.data(), in.size(), g_threadPool);
+    ReadPolygons(in.data(), in.size(), scan, g_mesh, g_threadPool);
+    if(g_mesh.faceCount() == 0){
         g_eGlobalState = GlobalAppState::eBadFile;
         MessageBoxA(nullptr,"File format is wrong or file is corrupt.","Error", MB_OK);
         return;
     }
 
     // Прочесть и сохранить строки основных данных (кроме полигонов)
-    ReadBaseObjData(in);
+    g_objBaseData.reserve(scan.baseLines);
+    ReadBaseObjData(in.data(), scan.lines, g_objBaseData);
 
     // Файл прочитан
     g_eGlobalState = GlobalAppState::eFileRead;
@@ -531,51 +492,11 @@ void OnExportFileSelected(const std::string &filePath)
     // Путь к результату (без расширения)
     std::string objOutputFilePath = std::string(drive) + std::string(directory) + std::string(basename);
 
-    // П О Д Г О Т О В К А (Нахуй она воообще тут нужна?? Можно было писать в файл сразу...)
+    // П О Д Г О Т О В К А
 
     // Содержимое результирющих файлов
-    std::vector<std::string> objFileText = {
-            "# SED Auto Materials v1.0 OBJ File",
-            "mtllib " + std::string(basename) + ".mtl"
-    };
-    objFileText.insert(objFileText.end(),g_objBaseData.begin(),g_objBaseData.end());
-
-    std::vector<std::string> mtlFileText = {
-            "# SED Auto Materials v1.0 MTL File",
-            "# Material Count: " + std::to_string(g_vGroups.size())
-    };
-
-    // Пройтись по всем группам
-    for(unsigned g = 0; g < g_vGroups.size(); g++)
-    {
-        // Добавление данных .mtl
-        mtlFileText.emplace_back("");
-        mtlFileText.emplace_back("newmtl Material." + std::to_string(g));
-        mtlFileText.emplace_back("Ns 225.000000");
-        mtlFileText.emplace_back("Ka 1.000000 1.000000 1.000000");
-        mtlFileText.emplace_back("Kd 0.800000 0.800000 0.800000");
-        mtlFileText.emplace_back("Ks 0.500000 0.500000 0.500000");
-        mtlFileText.emplace_back("Ke 0.000000 0.000000 0.000000");
-        mtlFileText.emplace_back("Ni 1.450000");
-        mtlFileText.emplace_back("d 1.000000");
-        mtlFileText.emplace_back("illum 2");
-
-        // Добавление данных .obj
-        objFileText.emplace_back("usemtl Material." + std::to_string(g));
-        objFileText.emplace_back("s off");
-
-        for(unsigned int p : g_vGroups[g].polygons)
-        {
-            const auto& polygon = g_vPolygons[p];
-            std::string polygonStr = "f";
-
-            for(const auto& v : polygon){
-                polygonStr += " " + std::to_string(v.posIdx) + "/" + std::to_string(v.uvIdx) + "/" + std::to_string(v.normalIdx);
-            }
-
-            objFileText.push_back(polygonStr);
-        }
-    }
+    const std::pmr::string objFileText = FormatObjText(std::string(basename) + ".mtl", g_objBaseData, g_mesh, g_groups, g_threadPool);
+    const std::string mtlFileText = FormatMtlText(g_groups.groupCount());
 
     // З А П И С Ь  В  Ф А Й Л Ы
 
@@ -583,153 +504,39 @@ void OnExportFileSelected(const std::string &filePath)
     std::ofstream outObj;
     outObj.open(objOutputFilePath + ".obj", std::ios::out | std::ios::trunc);
     if(outObj.fail()) throw std::runtime_error("Can't open .OBJ file for writing.");
-    for(const std::string& str : objFileText){
-        outObj << str << std::endl;
-    }
+    outObj.write(objFileText.data(), static_cast<std::streamsize>(objFileText.size()));
     outObj.close();
 
     // Запись в файл .mtl
     std::ofstream outMtl;
     outMtl.open(objOutputFilePath + ".mtl", std::ios::out | std::ios::trunc);
     if(outMtl.fail()) throw std::runtime_error("Can't open .MTL file for writing.");
-    for(const std::string& str : mtlFileText){
-        outMtl << str << std::endl;
-    }
+    outMtl.write(mtlFileText.data(), static_cast<std::streamsize>(mtlFileText.size()));
     outMtl.close();
 
     // Сообщение об успехе
     MessageBoxA(g_hwnd,"Files successfully exported.","Done",MB_OK);
 }
 
-/**
- * Считать данные о полигонах из файла
- * @param in Объект открытого потока чтения
- */
-void ReadPolygons(std::ifstream &in)
-{
-    // Очистить массив полигонов
-    g_vPolygons.clear();
-
-    // Вернуться к началу
-    in.clear();
-    in.seekg(0, std::ios::beg);
-
-    // Переменная для хранения текущей строки файла
-    std::string line;
-
-    // Массив полигонов (массив массивов вершин)
-    using Polygon = std::vector<Vertex>;
-
-    // Пока не достигнут конец файла
-    while(!in.eof())
-    {
-        // Получить строку
-        std::getline(in, line);
-
-        // Поток ввода/вывода для строки
-        std::stringstream iss(line);
-
-        // Для "мусорных данных"
-        char cTrash;
-
-        // Если строка начинается с подстроки "f "
-        if(!line.compare(0, 2, "f "))
-        {
-            // Полигон (массив вершин)
-            Polygon p;
-
-            // Первый символ (f) вписывается в мусорную переменную
-            iss >> cTrash;
-
-            // Читать символы строки в структуру вершины пока строка не закончится
-            Vertex v;
-            while (iss >> v.posIdx >> cTrash >> v.uvIdx >> cTrash >> v.normalIdx){
-                p.push_back(v);
-            }
-
-            // Добавить полигон
-            g_vPolygons.push_back(p);
-        }
-    }
-}
-
-/**
- * Считать начало файла в массив строк
- * @param in Объект открытого потока чтения
- */
-void ReadBaseObjData(std::ifstream &in)
-{
-    // Очистить массив строк
-    g_objBaseData.clear();
-
-    // Вернуться к началу
-    in.clear();
-    in.seekg(0, std::ios::beg);
-
-    // Переменная для хранения текущей строки файла
-    std::string line;
-
-    // Пока не достигнут конец файла
-    while(!in.eof())
-    {
-        // Получить строку
-        std::getline(in, line);
-
-        // Если строка не начинается с "#" или "mtlib"
-        if(line.compare(0, 1, "#") && line.compare(0, 6, "mtllib"))
-        {
-            // Если строка начинается с "usemtl" - оборвать цикл
-            if(!line.compare(0,6,"usemtl")) break;
-            // Иначе добаить строку в массив стрк
-            else g_objBaseData.push_back(line);
-        }
-    }
-}
-
 /**
  * Деление геометрии на материалы - по материалу на каждую UV группу
  */
 void DivideForEachUv()
 {
-    // Очистить группы
-    g_vGroups.clear();
-
-    // Пройтись по всем полигонам
-    for(unsigned p = 0; p < g_vPolygons.size(); p++)
-    {
-        // Последняя группа в которую был добавлен текущий полигон
-        int lastGroupPolyAdded = -1;
-
-        // Пройтись по группам
-        for(unsigned g = 0; g < g_vGroups.size(); g++)
-        {
-            // Если полигон должен принадлжать текущей группе
-            if(g_vGroups[g].polygonBelongs(g_vPolygons[p]))
-            {
-                // Если была какая-то группа в которую этот же полигон был добавлен
-                if(lastGroupPolyAdded != -1) {
-                    g_vGroups[g].joinGroup(g_vGroups[lastGroupPolyAdded]);
-                    g_vGroups[lastGroupPolyAdded].cleanGroup();
-                }
-                // Если полигон не добавлялся ранее ни в какие группы
-                else{
-                    g_vGroups[g].addPolygon(p,g_vPolygons[p]);
-                    lastGroupPolyAdded = static_cast<int>(g);
-                }
-            }
-        }
-
-        // Если полигон так и не был добавлен ни в одну из групп
-        // создать новую группу и добавить туда полигон
-        if(lastGroupPolyAdded == -1){
-            Group group;
-            group.addPolygon(p,g_vPolygons[p]);
-            g_vGroups.push_back(group);
+    // Совпадающие текстурные координаты (продублированные "vt") - один индекс. Координаты разбираются из сохраненных
+    // строк (файл уже закрыт) один раз на файл, результат сохраняется до выбора следующего файла
+    if(g_bWeldUv && !g_bUvWelded){
+        const WeldMap uvMap = WeldCoordinates(ReadBaseCoordinates(g_objBaseData, eLineTexCoord), 2, g_fUvWeldTolerance, g_threadPool);
+        if(uvMap.weldedCount > 0){
+            g_uvWeldedMesh = g_mesh;
+            RemapIndices(g_uvWeldedMesh, uvMap, eLineTexCoord, g_threadPool);
         }
+        g_bUvWelded = true;
     }
 
-    // Удалить пустые группы
-    g_vGroups.erase(std::remove_if(g_vGroups.begin(),g_vGroups.end(),[](const Group& g){return g.polygons.empty();}),g_vGroups.end());
+    // Полигоны с общими вершинами (положение + UV) объединяются в группы, экспортируются исходные индексы
+    const Mesh& mesh = g_bWeldUv && g_uvWeldedMesh.faceCount() > 0 ? g_uvWeldedMesh : g_mesh;
+    g_groups = CollectGroupMembers(GroupPolygonsParallel(mesh, g_threadPool));
 }
 
 /**
@@ -737,14 +544,5 @@ void DivideForEachUv()
  */
 void DivideForEachPoly()
 {
-    // Очистить группы
-    g_vGroups.clear();
-
-    // Пройтись по всем полигонам
-    for(unsigned p = 0; p < g_vPolygons.size(); p++)
-    {
-        Group group;
-        group.addPolygon(p,g_vPolygons[p]);
-        g_vGroups.push_back(group);
-    }
+    g_groups = CollectGroupMembers(GroupPolygonsPerPolygon(g_mesh));
 }
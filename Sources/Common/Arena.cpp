@@ -0,0 +1,114 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Арена памяти для данных файла.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Arena.h"
+#include "Platform.h"
+
+#include <new>
+
+namespace
+{
+    /// Гранулярность блоков (огромная страница - 2 МБ)
+    const size_t BLOCK_GRANULARITY = 64u << 10u;
+    const size_t HUGE_BLOCK_GRANULARITY = 2u << 20u;
+}
+
+Arena::BlockCache::BlockCache(bool hugePages) : hugePages_(hugePages)
+{}
+
+Arena::BlockCache::~BlockCache()
+{
+    for(const auto& block : blocks_) FreePages(block.data, block.size);
+}
+
+size_t Arena::BlockCache::reservedBytes() const
+{
+    size_t total = 0;
+    for(const auto& block : blocks_) total += block.size;
+    return total;
+}
+
+void* Arena::BlockCache::do_allocate(size_t bytes, size_t alignment)
+{
+    // Страницы выровнены сильнее любого разумного выравнивания
+    if(alignment > BLOCK_GRANULARITY) throw std::bad_alloc();
+
+    // Наименьший свободный блок подходящего размера
+    Block* best = nullptr;
+    for(auto& block : blocks_)
+    {
+        if(!block.used && block.size >= bytes && (!best || block.size < best->size)) best = &block;
+    }
+
+    if(best){
+        best->used = true;
+        return best->data;
+    }
+
+    // Новый блок
+    const size_t granularity = hugePages_ ? HUGE_BLOCK_GRANULARITY : BLOCK_GRANULARITY;
+    const size_t size = (bytes + granularity - 1) / granularity * granularity;
+    void* data = AllocatePages(size, hugePages_);
+    if(!data) throw std::bad_alloc();
+
+    blocks_.push_back({data, size, true});
+    return data;
+}
+
+void Arena::BlockCache::do_deallocate(void* pointer, size_t, size_t)
+{
+    // Блок остается в кеше
+    for(auto& block : blocks_)
+    {
+        if(block.data == pointer){
+            block.used = false;
+            return;
+        }
+    }
+}
+
+bool Arena::BlockCache::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+Arena::Arena(bool hugePages, size_t initialSize)
+    : blocks_(hugePages)
+    , monotonic_(initialSize, &blocks_)
+{}
+
+void Arena::release()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    monotonic_.release();
+}
+
+size_t Arena::reservedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.reservedBytes();
+}
+
+size_t Arena::blockCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.blockCount();
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return monotonic_.allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate(void*, size_t, size_t)
+{
+    // Память освобождается только целиком (release)
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
@@ -0,0 +1,95 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Арена памяти для данных файла.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+/**
+ * \brief Арена памяти для данных одного файла (меш, разбиение, группы, строки, результирующий текст)
+ *
+ * \details Обертка над std::pmr::monotonic_buffer_resource: выделение - сдвиг указателя, освобождение отдельных
+ * блоков ничего не делает, вся память освобождается разом через release(). Блоки, полученные у системы, при этом
+ * не возвращаются, а переиспользуются при обработке следующего файла, поэтому в установившемся режиме
+ * обращений к malloc почти нет. Выделения защищены мьютексом (контейнеры могут расти из рабочих потоков).
+ *
+ * В арену стоит помещать только данные, живущие до конца обработки файла - временные массивы алгоритмов
+ * освобождаются по ходу работы и в монотонной арене только увеличили бы пиковый объем памяти
+ */
+class Arena : public std::pmr::memory_resource
+{
+public:
+    /**
+     * \brief Создать арену
+     * \param hugePages Выделять блоки с прозрачными огромными страницами (только Linux)
+     * \param initialSize Размер первого блока (байт), следующие растут в геометрической прогрессии
+     */
+    explicit Arena(bool hugePages = false, size_t initialSize = 1u << 20u);
+
+    ~Arena() override = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * \brief Освободить всю выделенную из арены память
+     *
+     * \details Все контейнеры, использующие арену, к этому моменту должны быть уничтожены либо переназначены.
+     * Блоки остаются у арены для следующего файла
+     */
+    void release();
+
+    /**
+     * \brief Объем памяти, полученной ареной у системы (байт)
+     */
+    [[nodiscard]] size_t reservedBytes() const;
+
+    /**
+     * \brief Кол-во блоков, полученных ареной у системы
+     */
+    [[nodiscard]] size_t blockCount() const;
+
+private:
+    /**
+     * \brief Источник блоков для монотонной арены - страницы системы, освобожденные блоки кешируются
+     */
+    class BlockCache : public std::pmr::memory_resource
+    {
+    public:
+        explicit BlockCache(bool hugePages);
+        ~BlockCache() override;
+
+        BlockCache(const BlockCache&) = delete;
+        BlockCache& operator=(const BlockCache&) = delete;
+
+        [[nodiscard]] size_t reservedBytes() const;
+        [[nodiscard]] size_t blockCount() const { return blocks_.size(); }
+
+    private:
+        struct Block
+        {
+            void* data;
+            size_t size;
+            bool used;
+        };
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        std::vector<Block> blocks_;
+        bool hugePages_;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    BlockCache blocks_;
+    std::pmr::monotonic_buffer_resource monotonic_;
+    mutable std::mutex mutex_;
+};
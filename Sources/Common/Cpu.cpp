@@ -0,0 +1,107 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Наборы инструкций процессора.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Cpu.h"
+
+#include <atomic>
+
+#if defined(_MSC_VER) && defined(SED_LINE_INDEX_X86)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /// Названия наборов инструкций
+    const char* const ISA_NAMES[eIsaCount] = {"scalar", "sse2", "sse4.2", "avx2", "avx512"};
+
+    /// Выбранный набор инструкций (-1 - еще не определен)
+    std::atomic<int> g_activeIsa{-1};
+
+    /**
+     * \brief Определить набор инструкций
+     */
+    InstructionSet Detect()
+    {
+#if defined(_MSC_VER) && defined(SED_LINE_INDEX_X86)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool sse42 = (info[2] & (1 << 20)) != 0 && (info[2] & (1 << 23)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+        // Регистры AVX (и AVX-512) должны сохраняться ОС
+        const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        const bool osAvx = (xcr0 & 0x6) == 0x6;
+        const bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+        bool avx2 = false, avx512 = false;
+        if(maxLeaf >= 7){
+            __cpuidex(info, 7, 0);
+            avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+            avx512 = osAvx512 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+        }
+
+        if(avx512 && avx2) return eIsaAVX512;
+        if(avx2 && sse42) return eIsaAVX2;
+        if(sse42) return eIsaSSE42;
+        if(sse2) return eIsaSSE2;
+        return eIsaScalar;
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(SED_LINE_INDEX_X86)
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx2")) return eIsaAVX512;
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) return eIsaAVX2;
+        if(__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) return eIsaSSE42;
+        if(__builtin_cpu_supports("sse2")) return eIsaSSE2;
+        return eIsaScalar;
+#else
+        // Векторных ядер для платформы нет
+        return eIsaScalar;
+#endif
+    }
+}
+
+InstructionSet DetectInstructionSet()
+{
+    static const InstructionSet detected = Detect();
+    return detected;
+}
+
+InstructionSet ActiveInstructionSet()
+{
+    int isa = g_activeIsa.load(std::memory_order_relaxed);
+    if(isa < 0){
+        isa = DetectInstructionSet();
+        g_activeIsa.store(isa, std::memory_order_relaxed);
+    }
+    return static_cast<InstructionSet>(isa);
+}
+
+bool ForceInstructionSet(InstructionSet isa)
+{
+    if(isa < eIsaScalar || isa > DetectInstructionSet()) return false;
+    g_activeIsa.store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+const char* InstructionSetName(InstructionSet isa)
+{
+    return isa >= eIsaScalar && isa < eIsaCount ? ISA_NAMES[isa] : "unknown";
+}
+
+bool FindInstructionSet(const std::string& name, InstructionSet& isa)
+{
+    for(int i = 0; i < eIsaCount; i++)
+    {
+        if(name == ISA_NAMES[i]){
+            isa = static_cast<InstructionSet>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Наборы инструкций процессора.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <string>
+
+// Векторные ядра компилируются только для x86-64, на прочих платформах (в том числе 32-битном x86) определяется eIsaScalar
+#if defined(__x86_64__) || defined(_M_X64)
+#define SED_LINE_INDEX_X86
+#endif
+
+/**
+ * \brief Набор инструкций для векторных ядер (каждый следующий включает предыдущие)
+ */
+enum InstructionSet
+{
+    // Без векторных инструкций
+    eIsaScalar,
+    // SSE2 (есть на любом x86-64)
+    eIsaSSE2,
+    // SSE4.2 и POPCNT
+    eIsaSSE42,
+    // AVX2
+    eIsaAVX2,
+    // AVX-512 (F и BW)
+    eIsaAVX512,
+    // Кол-во наборов
+    eIsaCount
+};
+
+/**
+ * \brief Наиболее широкий набор инструкций, поддерживаемый процессором и ОС (и имеющий скомпилированные ядра)
+ */
+InstructionSet DetectInstructionSet();
+
+/**
+ * \brief Набор инструкций, по которому выбираются реализации ядер
+ *
+ * \details По умолчанию - DetectInstructionSet(), может быть понижен через ForceInstructionSet
+ */
+InstructionSet ActiveInstructionSet();
+
+/**
+ * \brief Принудительно выбрать набор инструкций (для замеров и проверки всех реализаций на одной машине)
+ * \param isa Набор инструкций
+ * \return Поддерживается ли набор процессором (если нет - выбор не меняется)
+ */
+bool ForceInstructionSet(InstructionSet isa);
+
+/**
+ * \brief Название набора инструкций ("scalar", "sse2", "sse4.2", "avx2", "avx512")
+ */
+const char* InstructionSetName(InstructionSet isa);
+
+/**
+ * \brief Найти набор инструкций по названию
+ * \param name Название
+ * \param isa Набор инструкций
+ * \return Найден ли набор
+ */
+bool FindInstructionSet(const std::string& name, InstructionSet& isa);
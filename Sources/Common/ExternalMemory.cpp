@@ -0,0 +1,375 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Обработка файлов, не помещающихся в память.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "ExternalMemory.h"
+#include "ObjWriter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    /// Приблизительный объем памяти на вершину полигона при группировке (ключи, хеш-таблицы), кроме самой вершины
+    const size_t GROUPING_BYTES_PER_FACE_VERTEX = 40;
+    /// Приблизительный объем памяти на полигон (смещение, метка группы, номер в группе)
+    const size_t BYTES_PER_FACE = 16;
+    /// Приблизительный объем памяти на строку основной информации (заголовок строки)
+    const size_t BYTES_PER_BASE_LINE = 32;
+    /// Наименьший размер серии (записей)
+    const size_t MIN_RUN_RECORDS = 1u << 16u;
+    /// Наименьший размер блока чтения серии при слиянии (записей)
+    const size_t MIN_BLOCK_RECORDS = 1u << 12u;
+    /// Размер буфера вывода (байт)
+    const size_t OUTPUT_BUFFER_SIZE = 4u << 20u;
+
+    /**
+     * \brief Вершина полигона (ключ вершины и полигон)
+     */
+    struct KeyRecord
+    {
+        uint64_t pos;
+        uint64_t uv;
+        unsigned face;
+
+        bool operator<(const KeyRecord& r) const
+        {
+            return pos != r.pos ? pos < r.pos : uv < r.uv;
+        }
+    };
+
+    /**
+     * \brief Полигон в группе (группа и смещение строки полигона в файле)
+     *
+     * \details Строка перечитывается не по порядку, поэтому вместе с ней хранится кол-во элементов до нее (для
+     * относительных индексов)
+     */
+    struct FaceRecord
+    {
+        uint64_t offset;
+        ElementCounts counts;
+        unsigned group;
+
+        bool operator<(const FaceRecord& r) const
+        {
+            return group != r.group ? group < r.group : offset < r.offset;
+        }
+    };
+
+    /**
+     * \brief Внешняя сортировка: записи копятся в буфере, полный буфер сортируется и сбрасывается во временный
+     * файл (серию), затем серии сливаются k-путевым слиянием
+     *
+     * \details Временные файлы создаются по заданному пути (std::tmpfile пишет в корень диска, что в Windows без прав
+     * администратора недоступно) и удаляются вместе с сортировкой
+     */
+    template<typename Record>
+    class RunSorter
+    {
+    public:
+        /**
+         * \param capacity Размер буфера (записей)
+         * \param runPrefix Начало пути временных файлов (к нему добавляется номер серии)
+         */
+        RunSorter(size_t capacity, std::string runPrefix) : capacity_(std::max(capacity, MIN_RUN_RECORDS)),
+                                                            runPrefix_(std::move(runPrefix))
+        {}
+
+        ~RunSorter()
+        {
+            for(FILE* run : runs_) std::fclose(run);
+            for(const std::string& path : runPaths_) std::remove(path.c_str());
+        }
+
+        RunSorter(const RunSorter&) = delete;
+        RunSorter& operator=(const RunSorter&) = delete;
+
+        void add(const Record& record)
+        {
+            buffer_.push_back(record);
+            if(buffer_.size() == capacity_) spill();
+        }
+
+        [[nodiscard]] size_t runCount() const { return runs_.size(); }
+
+        /**
+         * \brief Передать все записи обработчику в порядке сортировки (записи при этом удаляются)
+         * \param onRecord Обработчик записи
+         */
+        template<typename Fn>
+        void merge(Fn&& onRecord)
+        {
+            // Все записи поместились в буфер - временные файлы не нужны
+            if(runs_.empty())
+            {
+                std::sort(buffer_.begin(), buffer_.end());
+                for(const auto& record : buffer_) onRecord(record);
+                std::vector<Record>().swap(buffer_);
+                return;
+            }
+
+            if(!buffer_.empty()) spill();
+            std::vector<Record>().swap(buffer_);
+
+            // Каждая серия читается блоками, память буфера делится между сериями
+            struct Cursor
+            {
+                FILE* file = nullptr;
+                std::vector<Record> block;
+                size_t pos = 0;
+            };
+
+            const size_t blockSize = std::max(MIN_BLOCK_RECORDS, capacity_ / runs_.size());
+            std::vector<Cursor> cursors(runs_.size());
+
+            auto refill = [&](Cursor& cursor){
+                cursor.block.resize(blockSize);
+                const size_t count = std::fread(cursor.block.data(), sizeof(Record), blockSize, cursor.file);
+                if(count < blockSize && std::ferror(cursor.file)) throw std::runtime_error("Can't read temporary file.");
+                cursor.block.resize(count);
+                cursor.pos = 0;
+                return count > 0;
+            };
+
+            // Куча серий по текущей записи (наименьшая - на вершине)
+            auto greater = [&](size_t a, size_t b){
+                return cursors[b].block[cursors[b].pos] < cursors[a].block[cursors[a].pos];
+            };
+            std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+
+            for(size_t r = 0; r < runs_.size(); r++)
+            {
+                cursors[r].file = runs_[r];
+                std::rewind(cursors[r].file);
+                if(refill(cursors[r])) heap.push(r);
+            }
+
+            while(!heap.empty())
+            {
+                const size_t r = heap.top();
+                heap.pop();
+
+                Cursor& cursor = cursors[r];
+                onRecord(cursor.block[cursor.pos]);
+                if(++cursor.pos == cursor.block.size() && !refill(cursor)) continue;
+                heap.push(r);
+            }
+        }
+
+    private:
+        /**
+         * \brief Отсортировать буфер и записать его в новую серию
+         */
+        void spill()
+        {
+            std::sort(buffer_.begin(), buffer_.end());
+
+            runPaths_.push_back(runPrefix_ + "." + std::to_string(runs_.size()) + ".tmp");
+            FILE* run = std::fopen(runPaths_.back().c_str(), "w+b");
+            if(!run) throw std::runtime_error("Can't create temporary file \"" + runPaths_.back() + "\".");
+            runs_.push_back(run);
+
+            if(std::fwrite(buffer_.data(), sizeof(Record), buffer_.size(), run) != buffer_.size()){
+                throw std::runtime_error("Can't write temporary file.");
+            }
+
+            buffer_.clear();
+        }
+
+        size_t capacity_;
+        std::string runPrefix_;
+        std::vector<Record> buffer_;
+        std::vector<FILE*> runs_;
+        std::vector<std::string> runPaths_;
+    };
+
+    /**
+     * \brief Пройти по строкам полигонов файла
+     * \param data Содержимое файла
+     * \param size Размер содержимого
+     * \param layout Формат вершин полигонов
+     * \param face Меш для разбора строки (содержит только текущий полигон)
+     * \param onFace Обработчик полигона (смещение строки в файле, кол-во элементов до строки)
+     */
+    template<typename Fn>
+    void ForEachFace(const char* data, size_t size, FaceLayout layout, Mesh64& face, Fn&& onFace)
+    {
+        const char* p = data;
+        const char* end = data + size;
+        ElementCounts counts;
+
+        while(p < end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if(!lineEnd) lineEnd = end;
+            const LineType type = ClassifyLine(p, static_cast<size_t>(lineEnd - p));
+
+            face.clear();
+            if(ReadFaceLine(p, lineEnd, layout, counts, face)) onFace(static_cast<uint64_t>(p - data), counts);
+            else if(type == eLinePosition) counts.positions++;
+            else if(type == eLineTexCoord) counts.texCoords++;
+            else if(type == eLineNormal) counts.normals++;
+
+            p = lineEnd + 1;
+        }
+    }
+
+    /**
+     * \brief Найти корень множества (со сжатием пути делением пополам)
+     */
+    unsigned FindRoot(std::vector<unsigned>& parents, unsigned i)
+    {
+        while(parents[i] != i){
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    }
+
+    /**
+     * \brief Объединить множества (корнем становится меньший индекс, поэтому родитель всегда меньше потомка)
+     */
+    void UniteSets(std::vector<unsigned>& parents, unsigned a, unsigned b)
+    {
+        a = FindRoot(parents, a);
+        b = FindRoot(parents, b);
+        if(a == b) return;
+        if(a < b) parents[b] = a;
+        else parents[a] = b;
+    }
+
+    /**
+     * \brief Буферизированный вывод в поток
+     */
+    class OutputBuffer
+    {
+    public:
+        explicit OutputBuffer(std::ostream& out) : out_(out)
+        {
+            text_.reserve(OUTPUT_BUFFER_SIZE + 4096);
+        }
+
+        std::string& text() { return text_; }
+
+        void flushIfFull()
+        {
+            if(text_.size() >= OUTPUT_BUFFER_SIZE) flush();
+        }
+
+        void flush()
+        {
+            out_.write(text_.data(), static_cast<std::streamsize>(text_.size()));
+            text_.clear();
+        }
+
+    private:
+        std::ostream& out_;
+        std::string text_;
+    };
+}
+
+size_t EstimateInMemoryBytes(const ObjScan& scan, size_t fileSize)
+{
+    const size_t indexBytes = scan.indexWidth() == eIndex16 ? 2 : scan.indexWidth() == eIndex32 ? 4 : 8;
+
+    // Индекс строк, меш и данные группировки, затем копии строк основной информации и результирующий текст (каждые -
+    // до размера файла). Без предварительного прохода (пустые подсчеты) - нижняя граница
+    const size_t lineCount = scan.lines.lineCount();
+    return lineCount * (sizeof(size_t) + sizeof(LineType)) +
+           scan.faceVertices * (3 * indexBytes + GROUPING_BYTES_PER_FACE_VERTEX) + scan.faces * BYTES_PER_FACE +
+           scan.baseLines * BYTES_PER_BASE_LINE + 2 * fileSize;
+}
+
+bool ConvertFileExternal(const char* data, size_t size, const std::string& mtlFileName, const std::string& objPath,
+                         const ObjScan& scan, size_t memoryLimit, ExternalStats& stats)
+{
+    stats = ExternalStats();
+    Mesh64 face;
+    const FaceLayout layout = DetectFaceLayout(data, size);
+
+    /** П О И С К  О С Т Р О В О В **/
+
+    // Пары (ключ вершины, полигон), половина ограничения памяти - на буфер серий
+    std::vector<unsigned> parents;
+    parents.reserve(scan.faces);
+    {
+        RunSorter<KeyRecord> keys(memoryLimit / 2 / sizeof(KeyRecord), objPath + ".keys");
+        ForEachFace(data, size, layout, face, [&](uint64_t, const ElementCounts&){
+            if(parents.size() == std::numeric_limits<unsigned>::max()) throw std::runtime_error("Too many polygons.");
+
+            const auto f = static_cast<unsigned>(parents.size());
+            parents.push_back(f);
+            for(const auto& v : face.polygon(0)) keys.add({v.posIdx, v.uvIdx, f});
+        });
+
+        // Полигоны с общим ключом идут подряд и объединяются с первым из них
+        stats.keyRuns = keys.runCount();
+        bool first = true;
+        KeyRecord group = {};
+        keys.merge([&](const KeyRecord& record){
+            if(!first && record.pos == group.pos && record.uv == group.uv) UniteSets(parents, group.face, record.face);
+            else group = record;
+            first = false;
+        });
+    }
+
+    // Родитель меньше потомка, поэтому один проход по возрастанию сводит всех к корням, второй - нумерует группы
+    // в порядке появления (массив родителей становится массивом номеров групп)
+    const auto faceCount = static_cast<unsigned>(parents.size());
+    for(unsigned f = 0; f < faceCount; f++) parents[f] = parents[parents[f]];
+    for(unsigned f = 0; f < faceCount; f++) parents[f] = parents[f] == f ? stats.groupCount++ : parents[parents[f]];
+    stats.faceCount = faceCount;
+    if(faceCount == 0) return false;
+
+    /** В Ы В О Д **/
+
+    std::ofstream out(objPath, std::ios::out | std::ios::trunc);
+    if(out.fail()) throw std::runtime_error("Can't open file \"" + objPath + "\" for writing.");
+
+    OutputBuffer buffer(out);
+    AppendObjHeader(buffer.text(), mtlFileName);
+    ForEachBaseObjLine(data, size, [&](const char* line, size_t length){
+        buffer.text().append(line, length);
+        buffer.text() += '\n';
+        buffer.flushIfFull();
+    });
+
+    // Пары (группа, смещение строки полигона), слияние дает полигоны в порядке групп
+    RunSorter<FaceRecord> faces(memoryLimit / 2 / sizeof(FaceRecord), objPath + ".faces");
+    {
+        unsigned f = 0;
+        ForEachFace(data, size, layout, face, [&](uint64_t offset, const ElementCounts& counts){
+            faces.add({offset, counts, parents[f++]});
+        });
+    }
+    std::vector<unsigned>().swap(parents);
+    stats.faceRuns = faces.runCount();
+
+    unsigned currentGroup = std::numeric_limits<unsigned>::max();
+    faces.merge([&](const FaceRecord& record){
+        if(record.group != currentGroup){
+            currentGroup = record.group;
+            AppendGroupHeader(buffer.text(), currentGroup);
+        }
+
+        const char* line = data + record.offset;
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', size - static_cast<size_t>(record.offset)));
+        face.clear();
+        ReadFaceLine(line, lineEnd ? lineEnd : data + size, layout, record.counts, face);
+        AppendPolygon(buffer.text(), face.polygon(0), layout);
+        buffer.flushIfFull();
+    });
+
+    buffer.flush();
+    return true;
+}
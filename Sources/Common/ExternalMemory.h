@@ -0,0 +1,65 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Обработка файлов, не помещающихся в память.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "ObjReader.h"
+
+/**
+ * \brief Итоги обработки во внешней памяти
+ */
+struct ExternalStats
+{
+    /// Кол-во полигонов
+    unsigned faceCount = 0;
+    /// Кол-во групп (материалов)
+    unsigned groupCount = 0;
+    /// Кол-во временных файлов (отсортированных серий) при поиске островов
+    size_t keyRuns = 0;
+    /// Кол-во временных файлов (отсортированных серий) при упорядочивании полигонов по группам
+    size_t faceRuns = 0;
+};
+
+/**
+ * \brief Приблизительный объем памяти, нужный для обработки файла целиком в памяти
+ *
+ * \details Оценка по итогам предварительного прохода: индекс строк, меш выбранной разрядности, данные группировки,
+ * строки основной информации и результирующий текст. Для пустых подсчетов (ObjScan()) - нижняя граница по размеру файла
+ *
+ * \param scan Итоги предварительного прохода по файлу
+ * \param fileSize Размер .obj файла (байт)
+ * \return Объем (байт)
+ */
+size_t EstimateInMemoryBytes(const ObjScan& scan, size_t fileSize);
+
+/**
+ * \brief Разбить полигоны на UV группы и записать результирующий .obj, не загружая меш в память
+ *
+ * \details Полигоны читаются из файла потоком (в два прохода). Первый проход раскладывает пары (ключ вершины,
+ * полигон) в отсортированные серии во временных файлах (рядом с результирующим .obj файлом, путь которого
+ * дополняется ".keys.N.tmp" и ".faces.N.tmp"), при слиянии серий полигоны с общим ключом объединяются в
+ * union-find по полигонам. Второй проход раскладывает пары (группа, смещение строки полигона) в серии, k-путевое
+ * слияние которых дает полигоны в порядке групп - строки перечитываются из файла и записываются в результат.
+ * Результат совпадает с результатом обработки в памяти (индексы читаются как 64-битные, относительные
+ * переводятся в абсолютные по кол-ву элементов до строки).
+ *
+ * В памяти остаются только union-find (4 байта на полигон) и буферы серий, размер которых определяется
+ * ограничением памяти
+ *
+ * \param data Содержимое .obj файла (отображение в память)
+ * \param size Размер содержимого
+ * \param mtlFileName Имя .mtl файла (для строки mtllib)
+ * \param objPath Путь к результирующему .obj файлу
+ * \param scan Итоги предварительного прохода по файлу
+ * \param memoryLimit Ограничение памяти (байт)
+ * \param stats Итоги обработки
+ * \return Найдены ли полигоны (если нет - файл не записывается)
+ * \throws std::runtime_error При ошибке записи результата или работы с временными файлами
+ */
+bool ConvertFileExternal(const char* data, size_t size, const std::string& mtlFileName, const std::string& objPath,
+                         const ObjScan& scan, size_t memoryLimit, ExternalStats& stats);
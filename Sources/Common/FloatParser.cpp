@@ -0,0 +1,173 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Быстрый разбор чисел с плавающей точкой.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "FloatParser.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+// Разбор по 8 цифр рассчитан на порядок байтов little-endian
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SED_FLOAT_SWAR
+#endif
+
+namespace
+{
+    /// Степени десяти, точно представимые в float (до 10^10) и в double (до 10^22)
+    const float POW10_FLOAT[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+    const double POW10_DOUBLE[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    /// Наибольшее кол-во значащих цифр, помещающихся в 64-битную мантиссу
+    const int MAX_DIGITS = 19;
+
+    /// Наибольшая мантисса точного быстрого пути для float и double
+    const uint64_t MAX_FLOAT_MANTISSA = 1ull << 24u;
+    const uint64_t MAX_DOUBLE_MANTISSA = 1ull << 53u;
+
+    inline bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+#if defined(SED_FLOAT_SWAR)
+    inline uint64_t LoadEight(const char* p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    /**
+     * \brief Являются ли все 8 символов слова цифрами
+     */
+    inline bool IsEightDigits(uint64_t v)
+    {
+        return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4u)) == 0x3333333333333333ull;
+    }
+
+    /**
+     * \brief Значение 8 цифр слова (попарное сложение цифр, затем пар и четверок умножениями)
+     */
+    inline uint32_t ParseEightDigits(uint64_t v)
+    {
+        const uint64_t mask = 0x000000FF000000FFull;
+        const uint64_t mul1 = 0x000F424000000064ull;
+        const uint64_t mul2 = 0x0000271000000001ull;
+        v -= 0x3030303030303030ull;
+        v = (v * 10u) + (v >> 8u);
+        v = (((v & mask) * mul1) + (((v >> 16u) & mask) * mul2)) >> 32u;
+        return static_cast<uint32_t>(v);
+    }
+#endif
+
+    /**
+     * \brief Накопить цифры в мантиссу
+     * \param p Текущая позиция (сдвигается за цифры)
+     * \param end Конец строки
+     * \param mantissa Мантисса (при переполнении значение не используется)
+     */
+    inline void ReadDigits(const char*& p, const char* end, uint64_t& mantissa)
+    {
+#if defined(SED_FLOAT_SWAR)
+        while(end - p >= 8)
+        {
+            const uint64_t word = LoadEight(p);
+            if(!IsEightDigits(word)) break;
+            mantissa = mantissa * 100000000u + ParseEightDigits(word);
+            p += 8;
+        }
+#endif
+        for(; p < end && IsDigit(*p); p++) mantissa = mantissa * 10u + static_cast<uint64_t>(*p - '0');
+    }
+
+    /**
+     * \brief Разбор через std::from_chars (знак "+" пропускается)
+     */
+    bool ParseSlow(const char*& p, const char* end, float& value)
+    {
+        const char* start = p < end && *p == '+' ? p + 1 : p;
+        float result = 0.0f;
+        const auto parsed = std::from_chars(start, end, result);
+        if(parsed.ec != std::errc()) return false;
+
+        p = parsed.ptr;
+        value = result;
+        return true;
+    }
+}
+
+bool ParseFloat(const char*& p, const char* end, float& value)
+{
+    const char* cursor = p;
+
+    bool negative = false;
+    if(cursor < end && (*cursor == '-' || *cursor == '+')){
+        negative = *cursor == '-';
+        cursor++;
+    }
+
+    // Целая и дробная части - одна мантисса, дробные цифры уменьшают степень
+    uint64_t mantissa = 0;
+    const char* digits = cursor;
+    ReadDigits(cursor, end, mantissa);
+    int digitCount = static_cast<int>(cursor - digits);
+
+    int64_t exponent = 0;
+    if(cursor < end && *cursor == '.'){
+        cursor++;
+        const char* fraction = cursor;
+        ReadDigits(cursor, end, mantissa);
+        exponent = -static_cast<int64_t>(cursor - fraction);
+        digitCount += static_cast<int>(cursor - fraction);
+    }
+
+    // Нет цифр ("inf", "nan" и т.п.) либо мантисса не помещается в 64 бита
+    if(digitCount == 0 || digitCount > MAX_DIGITS) return ParseSlow(p, end, value);
+
+    // Показатель степени (без цифр после "e" не относится к числу)
+    if(cursor < end && (*cursor == 'e' || *cursor == 'E')){
+        const char* e = cursor + 1;
+        bool negativeExponent = false;
+        if(e < end && (*e == '-' || *e == '+')){
+            negativeExponent = *e == '-';
+            e++;
+        }
+        if(e < end && IsDigit(*e)){
+            int64_t explicitExponent = 0;
+            for(; e < end && IsDigit(*e); e++){
+                if(explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*e - '0');
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            cursor = e;
+        }
+    }
+
+    float result;
+    if(mantissa == 0){
+        result = 0.0f;
+    }else if(mantissa <= MAX_FLOAT_MANTISSA && exponent >= -10 && exponent <= 10){
+        // Мантисса и степень точны в float - одно округление
+        result = static_cast<float>(mantissa);
+        result = exponent < 0 ? result / POW10_FLOAT[-exponent] : result * POW10_FLOAT[exponent];
+    }else if(mantissa <= MAX_DOUBLE_MANTISSA && exponent >= -22 && exponent <= 22){
+        // Точно округленный double, затем float. Двойное округление ошибается, только если double попал ровно
+        // на середину между соседними float (младшие 29 бит мантиссы - 1000...0)
+        double d = static_cast<double>(mantissa);
+        d = exponent < 0 ? d / POW10_DOUBLE[-exponent] : d * POW10_DOUBLE[exponent];
+
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        if((bits & ((1ull << 29u) - 1)) == (1ull << 28u)) return ParseSlow(p, end, value);
+        result = static_cast<float>(d);
+    }else{
+        return ParseSlow(p, end, value);
+    }
+
+    value = negative ? -result : result;
+    p = cursor;
+    return true;
+}
@@ -0,0 +1,21 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Быстрый разбор чисел с плавающей точкой.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+/**
+ * \brief Разобрать десятичное число с плавающей точкой (результат совпадает с std::from_chars, округление к ближайшему)
+ *
+ * \details Цифры накапливаются по 8 за раз (SWAR - восемь символов в одном 64-битном слове), затем точный быстрый
+ * путь: мантисса до 2^53 и степень десяти до 22 дают точное значение double, которое округляется до float (при
+ * попадании ровно на середину между соседними float, а также для денормализованных и очень длинных чисел - разбор
+ * через std::from_chars). Допускаются знаки "+" и "-"
+ *
+ * \param p Начало числа (сдвигается за число, при ошибке не меняется)
+ * \param end Конец строки
+ * \param value Число
+ * \return Удалось ли разобрать число
+ */
+bool ParseFloat(const char*& p, const char* end, float& value);
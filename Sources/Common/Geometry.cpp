@@ -0,0 +1,158 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Координаты вершин и нормали полигонов.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Geometry.h"
+
+#include <cmath>
+
+#include "FloatParser.h"
+#include "Stats.h"
+
+namespace
+{
+    /// Минимальное кол-во полигонов в диапазоне при параллельном расчете нормалей
+    const size_t MIN_CHUNK_FACES = 16384;
+
+    /**
+     * \brief Прочитать компоненты строки (пробелы перед числами пропускаются, недостающие и ошибочные - 0)
+     * \param line Начало строки
+     * \param lineEnd Конец строки
+     * \param prefix Длина префикса строки ("v", "vt", "vn")
+     * \param out Координаты
+     * \param i Номер элемента
+     */
+    void ReadVector(const char* line, const char* lineEnd, size_t prefix, Coordinates& out, size_t i)
+    {
+        const char* p = line + prefix;
+        float* components[] = {&out.x[i], &out.y[i], &out.z[i]};
+        for(float* component : components)
+        {
+            while(p < lineEnd && (*p == ' ' || *p == '\t')) p++;
+            if(!ParseFloat(p, lineEnd, *component)) *component = 0.0f;
+        }
+    }
+}
+
+ObjGeometry::ObjGeometry(const char* data, const ObjScan& scan, ThreadPool& pool) : data_(data), scan_(scan), pool_(pool)
+{}
+
+const Coordinates& ObjGeometry::positions()
+{
+    return load(eLinePosition, scan_.positions, positions_, positionsLoaded_);
+}
+
+const Coordinates& ObjGeometry::texCoords()
+{
+    return load(eLineTexCoord, scan_.texCoords, texCoords_, texCoordsLoaded_);
+}
+
+const Coordinates& ObjGeometry::normals()
+{
+    return load(eLineNormal, scan_.normals, normals_, normalsLoaded_);
+}
+
+const Coordinates& ObjGeometry::load(LineType type, size_t count, Coordinates& out, bool& loaded)
+{
+    if(loaded) return out;
+    loaded = true;
+
+    StatsPhase phase("coordinates");
+    out.resize(count);
+
+    const LineIndex& lines = scan_.lines;
+    const size_t prefix = type == eLinePosition ? 1 : 2;
+    pool_.run(static_cast<unsigned>(lines.chunkCount()), [&](unsigned c){
+        const ElementCounts& base = scan_.chunkElements[c];
+        size_t element = type == eLinePosition ? base.positions : type == eLineTexCoord ? base.texCoords : base.normals;
+
+        for(size_t i = lines.chunkLines[c]; i < lines.chunkLines[c + 1]; i++)
+        {
+            if(lines.types[i] != type) continue;
+            ReadVector(data_ + lines.lineBegin(i), data_ + lines.lineEnd(i), prefix, out, element++);
+        }
+    });
+
+    return out;
+}
+
+Coordinates ReadBaseCoordinates(const TextLines& lines, LineType type)
+{
+    Coordinates out;
+    const size_t prefix = type == eLinePosition ? 1 : 2;
+    for(const auto& line : lines)
+    {
+        if(ClassifyLine(line.data(), line.size()) != type) continue;
+        out.resize(out.count() + 1);
+        ReadVector(line.data(), line.data() + line.size(), prefix, out, out.count() - 1);
+    }
+    return out;
+}
+
+template<typename Index>
+Coordinates ComputeFaceNormals(const BasicMesh<Index>& mesh, ObjGeometry& geometry, ThreadPool& pool)
+{
+    // Нормали вершин нужны только вырожденным полигонам и только при наличии индексов нормалей
+    static const Coordinates NO_NORMALS;
+    const bool hasNormals = mesh.faceLayout == eFacePositionNormal || mesh.faceLayout == eFacePositionUvNormal;
+    const Coordinates& positions = geometry.positions();
+    const Coordinates& normals = hasNormals ? geometry.normals() : NO_NORMALS;
+
+    Coordinates faceNormals;
+    faceNormals.resize(mesh.faceCount());
+
+    pool.parallelFor(mesh.faceCount(), [&](size_t begin, size_t end){
+        // Ненормированные нормали (вершины вне массива пропускаются)
+        for(size_t f = begin; f < end; f++)
+        {
+            const auto polygon = mesh.polygon(static_cast<unsigned>(f));
+            float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+
+            for(size_t i = 0; i < polygon.size(); i++)
+            {
+                const uint64_t a = polygon.first[i].posIdx;
+                const uint64_t b = polygon.first[(i + 1) % polygon.size()].posIdx;
+                if(a == 0 || b == 0 || a > positions.count() || b > positions.count()) continue;
+
+                nx += (positions.y[a - 1] - positions.y[b - 1]) * (positions.z[a - 1] + positions.z[b - 1]);
+                ny += (positions.z[a - 1] - positions.z[b - 1]) * (positions.x[a - 1] + positions.x[b - 1]);
+                nz += (positions.x[a - 1] - positions.x[b - 1]) * (positions.y[a - 1] + positions.y[b - 1]);
+            }
+
+            // Вырожденный полигон - среднее нормалей вершин
+            if(nx == 0.0f && ny == 0.0f && nz == 0.0f){
+                for(const auto& v : polygon)
+                {
+                    if(v.normalIdx == 0 || v.normalIdx > normals.count()) continue;
+                    nx += normals.x[v.normalIdx - 1];
+                    ny += normals.y[v.normalIdx - 1];
+                    nz += normals.z[v.normalIdx - 1];
+                }
+            }
+
+            faceNormals.x[f] = nx;
+            faceNormals.y[f] = ny;
+            faceNormals.z[f] = nz;
+        }
+
+        // Нормирование - независимые элементы отдельных массивов, цикл векторизуется компилятором
+        float* x = faceNormals.x.data();
+        float* y = faceNormals.y.data();
+        float* z = faceNormals.z.data();
+        for(size_t f = begin; f < end; f++)
+        {
+            const float length = std::sqrt(x[f] * x[f] + y[f] * y[f] + z[f] * z[f]);
+            const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+            x[f] *= scale;
+            y[f] *= scale;
+            z[f] *= scale;
+        }
+    }, MIN_CHUNK_FACES);
+
+    return faceNormals;
+}
+
+template Coordinates ComputeFaceNormals(const Mesh16&, ObjGeometry&, ThreadPool&);
+template Coordinates ComputeFaceNormals(const Mesh32&, ObjGeometry&, ThreadPool&);
+template Coordinates ComputeFaceNormals(const Mesh64&, ObjGeometry&, ThreadPool&);
@@ -0,0 +1,116 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Координаты вершин и нормали полигонов.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Mesh.h"
+#include "ObjReader.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Массив трехмерных векторов (отдельный массив на каждую компоненту)
+ */
+struct Coordinates
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    [[nodiscard]] size_t count() const { return x.size(); }
+
+    void resize(size_t count)
+    {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+    }
+};
+
+/**
+ * \brief Координаты из строк "v ", "vt " и "vn " .obj файла (элемент i - индекс i + 1 в строках полигонов)
+ *
+ * \details Каждый вид координат разбирается при первом обращении к нему (обычное разбиение на группы координаты не
+ * разбирает вовсе). Фрагменты индекса строк разбираются параллельно, каждый пишет сразу на свое место (начальные
+ * номера элементов фрагментов известны из предварительного прохода). Недостающие компоненты равны 0. Содержимое
+ * файла должно оставаться доступным до последнего обращения. Обращения - только из одного потока
+ */
+class ObjGeometry
+{
+public:
+    /**
+     * \brief Создать (без разбора)
+     * \param data Содержимое файла
+     * \param scan Итоги ScanObjFile (с индексом строк)
+     * \param pool Пул потоков
+     */
+    ObjGeometry(const char* data, const ObjScan& scan, ThreadPool& pool);
+
+    /**
+     * \brief Положения вершин ("v ")
+     */
+    const Coordinates& positions();
+
+    /**
+     * \brief Текстурные координаты ("vt ", z - третья компонента, если есть)
+     */
+    const Coordinates& texCoords();
+
+    /**
+     * \brief Нормали ("vn ")
+     */
+    const Coordinates& normals();
+
+private:
+    /**
+     * \brief Разобрать строки одного типа, если еще не разобраны
+     * \param type Тип строк
+     * \param count Кол-во строк
+     * \param out Координаты
+     * \param loaded Признак разобранных координат
+     * \return Координаты
+     */
+    const Coordinates& load(LineType type, size_t count, Coordinates& out, bool& loaded);
+
+    const char* data_;
+    const ObjScan& scan_;
+    ThreadPool& pool_;
+
+    Coordinates positions_;
+    Coordinates texCoords_;
+    Coordinates normals_;
+    bool positionsLoaded_ = false;
+    bool texCoordsLoaded_ = false;
+    bool normalsLoaded_ = false;
+};
+
+/**
+ * \brief Координаты одного вида из сохраненных строк основной информации (ReadBaseObjData)
+ *
+ * \details Для случаев, когда содержимое файла уже недоступно (строки "v ", "vt " и "vn " сохраняются целиком и в
+ * исходном порядке). Строки разбираются последовательно, недостающие компоненты равны 0
+ *
+ * \param lines Строки основной информации
+ * \param type Вид координат (eLinePosition, eLineTexCoord либо eLineNormal)
+ * \return Координаты (элемент i - индекс i + 1 в строках полигонов)
+ */
+Coordinates ReadBaseCoordinates(const TextLines& lines, LineType type);
+
+/**
+ * \brief Нормали полигонов (единичной длины)
+ *
+ * \details Нормаль считается по положениям вершин (метод Ньюэлла, подходит и для невыпуклых полигонов). Для
+ * вырожденных полигонов берется среднее нормалей вершин "vn", если их нет - нулевой вектор. Определена для
+ * uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param geometry Координаты (разбираются положения и нормали, если они есть в формате вершин полигонов)
+ * \param pool Пул потоков
+ * \return Нормаль каждого полигона
+ */
+template<typename Index>
+Coordinates ComputeFaceNormals(const BasicMesh<Index>& mesh, ObjGeometry& geometry, ThreadPool& pool);
@@ -0,0 +1,568 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Разбиение полигонов на группы.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Grouping.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+    /// Признак отсутствующего значения
+    const unsigned NO_INDEX = std::numeric_limits<unsigned>::max();
+
+    /**
+     * \brief Найти корень множества (со сжатием пути делением пополам)
+     * \param parents Массив родителей
+     * \param i Элемент
+     * \return Корень
+     */
+    unsigned FindRoot(std::vector<unsigned>& parents, unsigned i)
+    {
+        while(parents[i] != i){
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    }
+
+    /**
+     * \brief Объединить множества (корнем становится меньший индекс)
+     * \param parents Массив родителей
+     * \param a Первый элемент
+     * \param b Второй элемент
+     */
+    void UniteSets(std::vector<unsigned>& parents, unsigned a, unsigned b)
+    {
+        a = FindRoot(parents, a);
+        b = FindRoot(parents, b);
+        if(a == b) return;
+        if(a < b) parents[b] = a;
+        else parents[a] = b;
+    }
+
+    /**
+     * \brief Ключ вершины с 64-битными индексами (положение + текстурные координаты)
+     */
+    struct WideKey
+    {
+        uint64_t pos;
+        uint64_t uv;
+
+        bool operator==(const WideKey& k) const
+        {
+            return pos == k.pos && uv == k.uv;
+        }
+
+        bool operator<(const WideKey& k) const
+        {
+            return pos < k.pos || (pos == k.pos && uv < k.uv);
+        }
+    };
+
+    /**
+     * \brief Ключ ребра - упорядоченная пара ключей его вершин (ребро не зависит от направления обхода)
+     */
+    template<typename Key>
+    struct EdgeKey
+    {
+        Key first;
+        Key second;
+
+        bool operator==(const EdgeKey& k) const
+        {
+            return first == k.first && second == k.second;
+        }
+    };
+
+    /**
+     * \brief Ключ вершины (положение + текстурные координаты)
+     *
+     * \details Индексы до 32 бит упаковываются в одно 64-битное число, 64-битные индексы - в пару чисел
+     *
+     * \param v Вершина
+     * \return Ключ
+     */
+    template<typename Index>
+    auto VertexKey(const BasicVertex<Index>& v)
+    {
+        if constexpr(sizeof(Index) <= sizeof(uint32_t)){
+            return (static_cast<uint64_t>(v.posIdx) << 32u) | static_cast<uint64_t>(v.uvIdx);
+        }else{
+            return WideKey{v.posIdx, v.uvIdx};
+        }
+    }
+
+    /// Тип ключа вершины
+    template<typename Index>
+    using VertexKeyType = decltype(VertexKey(BasicVertex<Index>()));
+
+    /**
+     * \brief Перемешивание битов ключа (splitmix64)
+     * \param key Ключ
+     * \return Хеш
+     */
+    uint64_t MixKey(uint64_t key)
+    {
+        key = (key ^ (key >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27u)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31u);
+    }
+
+    uint64_t MixKey(const WideKey& key)
+    {
+        return MixKey(key.pos ^ MixKey(key.uv));
+    }
+
+    template<typename Key>
+    uint64_t MixKey(const EdgeKey<Key>& key)
+    {
+        return MixKey(MixKey(key.first) ^ (MixKey(key.second) * 0x9e3779b97f4a7c15ull));
+    }
+
+    /**
+     * \brief Хеш ключа для стандартных контейнеров
+     */
+    struct KeyHash
+    {
+        template<typename Key>
+        size_t operator()(const Key& key) const
+        {
+            return static_cast<size_t>(MixKey(key));
+        }
+    };
+
+    /**
+     * \brief Найти корень множества (атомарная версия, сжатие пути делением пополам)
+     * \param parents Массив родителей
+     * \param i Элемент
+     * \return Корень
+     */
+    unsigned FindRootAtomic(std::vector<std::atomic<unsigned>>& parents, unsigned i)
+    {
+        while(true)
+        {
+            unsigned parent = parents[i].load(std::memory_order_relaxed);
+            if(parent == i) return i;
+
+            const unsigned grandParent = parents[parent].load(std::memory_order_relaxed);
+            if(parent != grandParent){
+                parents[i].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+            }
+            i = grandParent;
+        }
+    }
+
+    /**
+     * \brief Объединить множества (атомарная версия)
+     *
+     * \details Корень с большим индексом всегда подвешивается к корню с меньшим, поэтому циклы невозможны
+     *
+     * \param parents Массив родителей
+     * \param a Первый элемент
+     * \param b Второй элемент
+     */
+    void UniteSetsAtomic(std::vector<std::atomic<unsigned>>& parents, unsigned a, unsigned b)
+    {
+        while(true)
+        {
+            a = FindRootAtomic(parents, a);
+            b = FindRootAtomic(parents, b);
+            if(a == b) return;
+            if(a < b) std::swap(a, b);
+
+            unsigned expected = a;
+            if(parents[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+        }
+    }
+
+    /**
+     * \brief Хеш-таблица с открытой адресацией: ключ вершины -> первый полигон с этой вершиной
+     */
+    template<typename Key>
+    class KeyTable
+    {
+    public:
+        explicit KeyTable(size_t expected)
+        {
+            size_t capacity = 16;
+            while(capacity < expected * 2) capacity <<= 1u;
+            keys_.resize(capacity);
+            values_.assign(capacity, NO_INDEX);
+            mask_ = capacity - 1;
+        }
+
+        /**
+         * \brief Вставить ключ, если его еще нет
+         * \param key Ключ
+         * \param value Значение
+         * \return Значение, связанное с ключом (уже существующее либо вставленное)
+         */
+        unsigned insert(const Key& key, unsigned value)
+        {
+            size_t slot = MixKey(key) & mask_;
+            while(values_[slot] != NO_INDEX)
+            {
+                if(keys_[slot] == key) return values_[slot];
+                slot = (slot + 1) & mask_;
+            }
+            keys_[slot] = key;
+            values_[slot] = value;
+            return value;
+        }
+
+    private:
+        std::vector<Key> keys_;
+        std::vector<unsigned> values_;
+        size_t mask_ = 0;
+    };
+
+    /**
+     * \brief Ключ полигона (вершина либо ребро), разложенный в корзину
+     */
+    template<typename Key>
+    struct KeyedPolygon
+    {
+        Key key;
+        unsigned polygon;
+    };
+
+    /**
+     * \brief Параллельно объединить полигоны с общими ключами (union-find с атомарными операциями)
+     *
+     * \details Ключи полигонов раскладываются по корзинам по хешу, каждая корзина обрабатывается отдельной задачей со
+     * своей хеш-таблицей, полигоны объединяются в общем lock-free union-find
+     *
+     * \param mesh Меш
+     * \param pool Пул потоков
+     * \param keysOf Перебор ключей полигона: keysOf(polygon, emit), emit(key) вызывается для каждого ключа
+     * \return Разбиение
+     */
+    template<typename Key, typename Index, typename KeysOf>
+    Partition UnitePolygonsByKeys(const BasicMesh<Index>& mesh, ThreadPool& pool, const KeysOf& keysOf)
+    {
+        const unsigned faceCount = mesh.faceCount();
+
+        // Каждый полигон - отдельное множество
+        std::vector<std::atomic<unsigned>> parents(faceCount);
+        pool.parallelFor(faceCount, [&](size_t begin, size_t end){
+            for(size_t p = begin; p < end; p++) parents[p].store(static_cast<unsigned>(p), std::memory_order_relaxed);
+        });
+
+        // Фрагменты полигонов раскладывают свои ключи по корзинам (по старшим битам хеша ключа)
+        const unsigned bucketCount = pool.threadCount() * 4;
+        const unsigned chunkCount = std::max(1u, std::min(bucketCount, faceCount / 4096));
+        const unsigned chunkSize = (faceCount + chunkCount - 1) / chunkCount;
+        auto bucketOf = [&](const Key& key){ return static_cast<unsigned>((MixKey(key) >> 32u) % bucketCount); };
+
+        // Первый проход считает размеры корзин каждого фрагмента, поэтому все корзины лежат в одном массиве точного
+        // размера: корзина за корзиной, внутри корзины - фрагменты по порядку
+        std::vector<size_t> offsets(static_cast<size_t>(bucketCount) * chunkCount + 1, 0);
+        pool.run(chunkCount, [&](unsigned c){
+            const unsigned begin = c * chunkSize;
+            const unsigned end = std::min(faceCount, begin + chunkSize);
+            std::vector<size_t> counts(bucketCount, 0);
+            for(unsigned p = begin; p < end; p++)
+            {
+                keysOf(p, [&](const Key& key){ counts[bucketOf(key)]++; });
+            }
+            for(unsigned b = 0; b < bucketCount; b++) offsets[static_cast<size_t>(b) * chunkCount + c + 1] = counts[b];
+        });
+        for(size_t i = 1; i < offsets.size(); i++) offsets[i] += offsets[i - 1];
+
+        std::vector<KeyedPolygon<Key>> items(offsets.back());
+        pool.run(chunkCount, [&](unsigned c){
+            const unsigned begin = c * chunkSize;
+            const unsigned end = std::min(faceCount, begin + chunkSize);
+            std::vector<size_t> cursors(bucketCount);
+            for(unsigned b = 0; b < bucketCount; b++) cursors[b] = offsets[static_cast<size_t>(b) * chunkCount + c];
+
+            for(unsigned p = begin; p < end; p++)
+            {
+                keysOf(p, [&](const Key& key){ items[cursors[bucketOf(key)]++] = {key, p}; });
+            }
+        });
+
+        // Каждая корзина - своя хеш-таблица, полигоны с общим ключом объединяются
+        pool.run(bucketCount, [&](unsigned b){
+            const size_t first = offsets[static_cast<size_t>(b) * chunkCount];
+            const size_t last = offsets[static_cast<size_t>(b + 1) * chunkCount];
+
+            KeyTable<Key> table(last - first);
+            for(size_t i = first; i < last; i++)
+            {
+                const unsigned root = table.insert(items[i].key, items[i].polygon);
+                if(root != items[i].polygon) UniteSetsAtomic(parents, root, items[i].polygon);
+            }
+        });
+        std::vector<KeyedPolygon<Key>>().swap(items);
+
+        // Корни множеств (параллельно), затем номера групп в порядке появления
+        Partition partition(mesh.resource());
+        partition.labels.resize(faceCount);
+        pool.parallelFor(faceCount, [&](size_t begin, size_t end){
+            for(size_t p = begin; p < end; p++) partition.labels[p] = FindRootAtomic(parents, static_cast<unsigned>(p));
+        });
+
+        // Корень - наименьший полигон множества, поэтому он встречается раньше остальных
+        for(unsigned p = 0; p < faceCount; p++)
+        {
+            const unsigned root = partition.labels[p];
+            partition.labels[p] = root == p ? partition.groupCount++ : partition.labels[root];
+        }
+
+        return partition;
+    }
+}
+
+template<typename Index>
+Partition GroupPolygonsReference(const BasicMesh<Index>& mesh)
+{
+    using Group = BasicGroup<Index>;
+
+    // Группы полигонов
+    std::vector<Group> groups;
+
+    // Пройтись по всем полигонам
+    for(unsigned p = 0; p < mesh.faceCount(); p++)
+    {
+        // Последняя группа в которую был добавлен текущий полигон
+        int lastGroupPolyAdded = -1;
+
+        // Пройтись по группам
+        for(unsigned g = 0; g < groups.size(); g++)
+        {
+            // Если полигон должен принадлжать текущей группе
+            if(groups[g].polygonBelongs(mesh.polygon(p)))
+            {
+                // Если была какая-то группа в которую этот же полигон был добавлен
+                // (полигон теперь в текущей группе, следующие совпавшие группы присоединяются уже к ней)
+                if(lastGroupPolyAdded != -1) {
+                    groups[g].joinGroup(groups[lastGroupPolyAdded]);
+                    groups[lastGroupPolyAdded].cleanGroup();
+                    lastGroupPolyAdded = static_cast<int>(g);
+                }
+                // Если полигон не добавлялся ранее ни в какие группы
+                else{
+                    groups[g].addPolygon(p,mesh.polygon(p));
+                    lastGroupPolyAdded = static_cast<int>(g);
+                }
+            }
+        }
+
+        // Если полигон так и не был добавлен ни в одну из групп
+        // создать новую группу и добавить туда полигон
+        if(lastGroupPolyAdded == -1){
+            Group group;
+            group.addPolygon(p,mesh.polygon(p));
+            groups.push_back(group);
+        }
+    }
+
+    // Удалить пустые группы
+    groups.erase(std::remove_if(groups.begin(),groups.end(),[](const Group& g){return g.polygons.empty();}),groups.end());
+
+    // Перевести группы в номера групп для каждого полигона
+    Partition partition(mesh.resource());
+    partition.labels.assign(mesh.faceCount(), 0);
+    partition.groupCount = static_cast<unsigned>(groups.size());
+    for(unsigned g = 0; g < groups.size(); g++){
+        for(unsigned p : groups[g].polygons) partition.labels[p] = g;
+    }
+
+    CanonicalizePartition(partition);
+    return partition;
+}
+
+template<typename Index>
+Partition GroupPolygonsUnionFind(const BasicMesh<Index>& mesh)
+{
+    const unsigned faceCount = mesh.faceCount();
+
+    // Каждый полигон - отдельное множество
+    std::vector<unsigned> parents(faceCount);
+    for(unsigned p = 0; p < faceCount; p++) parents[p] = p;
+
+    // Первый полигон, в котором встретилась вершина с данным ключом
+    std::unordered_map<VertexKeyType<Index>, unsigned, KeyHash> firstPolygon;
+    firstPolygon.reserve(mesh.vertices.size());
+
+    // Полигоны с общей вершиной объединяются в одно множество
+    for(unsigned p = 0; p < faceCount; p++)
+    {
+        for(const auto& v : mesh.polygon(p))
+        {
+            auto it = firstPolygon.emplace(VertexKey(v), p);
+            if(!it.second) UniteSets(parents, it.first->second, p);
+        }
+    }
+
+    // Корни множеств становятся группами (в порядке появления)
+    Partition partition(mesh.resource());
+    partition.labels.resize(faceCount);
+    std::vector<unsigned> rootLabels(faceCount, NO_INDEX);
+    for(unsigned p = 0; p < faceCount; p++)
+    {
+        unsigned root = FindRoot(parents, p);
+        if(rootLabels[root] == NO_INDEX) rootLabels[root] = partition.groupCount++;
+        partition.labels[p] = rootLabels[root];
+    }
+
+    return partition;
+}
+
+template<typename Index>
+Partition GroupPolygonsParallel(const BasicMesh<Index>& mesh, ThreadPool& pool)
+{
+    return UnitePolygonsByKeys<VertexKeyType<Index>>(mesh, pool, [&](unsigned p, const auto& emit){
+        for(const auto& v : mesh.polygon(p)) emit(VertexKey(v));
+    });
+}
+
+template<typename Index>
+Partition GroupPolygonsByEdges(const BasicMesh<Index>& mesh, ThreadPool& pool)
+{
+    using Key = VertexKeyType<Index>;
+    return UnitePolygonsByKeys<EdgeKey<Key>>(mesh, pool, [&](unsigned p, const auto& emit){
+        const auto polygon = mesh.polygon(p);
+        for(size_t i = 0; i < polygon.size(); i++)
+        {
+            const Key a = VertexKey(polygon.first[i]);
+            const Key b = VertexKey(polygon.first[(i + 1) % polygon.size()]);
+            emit(b < a ? EdgeKey<Key>{b, a} : EdgeKey<Key>{a, b});
+        }
+    });
+}
+
+template<typename Index>
+Partition GroupPolygonsPerPolygon(const BasicMesh<Index>& mesh)
+{
+    Partition partition(mesh.resource());
+    partition.groupCount = mesh.faceCount();
+    partition.labels.resize(mesh.faceCount());
+    for(unsigned p = 0; p < mesh.faceCount(); p++) partition.labels[p] = p;
+    return partition;
+}
+
+void CanonicalizePartition(Partition& partition)
+{
+    std::vector<unsigned> newLabels(partition.groupCount, NO_INDEX);
+    unsigned count = 0;
+
+    for(auto& label : partition.labels)
+    {
+        if(newLabels[label] == NO_INDEX) newLabels[label] = count++;
+        label = newLabels[label];
+    }
+
+    partition.groupCount = count;
+}
+
+GroupMembers CollectGroupMembers(const Partition& partition)
+{
+    GroupMembers members(partition.labels.get_allocator().resource());
+
+    // Подсчет размеров групп
+    members.offsets.assign(partition.groupCount + 1, 0);
+    for(unsigned label : partition.labels) members.offsets[label + 1]++;
+    for(unsigned g = 0; g < partition.groupCount; g++) members.offsets[g + 1] += members.offsets[g];
+
+    // Раскладка полигонов по группам (устойчивая - порядок полигонов сохраняется)
+    members.polygons.resize(partition.labels.size());
+    std::vector<unsigned> cursors(members.offsets.begin(), members.offsets.end() - 1);
+    for(unsigned p = 0; p < partition.labels.size(); p++){
+        members.polygons[cursors[partition.labels[p]]++] = p;
+    }
+
+    return members;
+}
+
+unsigned CountSplitGroups(const GroupMembers& coarse, const GroupMembers& fine)
+{
+    // Группа каждого полигона в другом разбиении
+    std::vector<unsigned> labels(fine.polygons.size(), NO_INDEX);
+    for(unsigned g = 0; g < fine.groupCount(); g++)
+    {
+        for(unsigned i = fine.offsets[g]; i < fine.offsets[g + 1]; i++) labels[fine.polygons[i]] = g;
+    }
+
+    unsigned split = 0;
+    for(unsigned g = 0; g < coarse.groupCount(); g++)
+    {
+        const unsigned first = labels[coarse.polygons[coarse.offsets[g]]];
+        for(unsigned i = coarse.offsets[g] + 1; i < coarse.offsets[g + 1]; i++)
+        {
+            if(labels[coarse.polygons[i]] != first){
+                split++;
+                break;
+            }
+        }
+    }
+    return split;
+}
+
+template Partition GroupPolygonsReference(const Mesh16&);
+template Partition GroupPolygonsReference(const Mesh32&);
+template Partition GroupPolygonsReference(const Mesh64&);
+template Partition GroupPolygonsUnionFind(const Mesh16&);
+template Partition GroupPolygonsUnionFind(const Mesh32&);
+template Partition GroupPolygonsUnionFind(const Mesh64&);
+template Partition GroupPolygonsParallel(const Mesh16&, ThreadPool&);
+template Partition GroupPolygonsParallel(const Mesh32&, ThreadPool&);
+template Partition GroupPolygonsParallel(const Mesh64&, ThreadPool&);
+template Partition GroupPolygonsByEdges(const Mesh16&, ThreadPool&);
+template Partition GroupPolygonsByEdges(const Mesh32&, ThreadPool&);
+template Partition GroupPolygonsByEdges(const Mesh64&, ThreadPool&);
+template Partition GroupPolygonsPerPolygon(const Mesh16&);
+template Partition GroupPolygonsPerPolygon(const Mesh32&);
+template Partition GroupPolygonsPerPolygon(const Mesh64&);
+
+namespace
+{
+    /**
+     * \brief Однопоточные алгоритмы в виде функции разбиения (пул не используется)
+     */
+    template<typename Index>
+    Partition DivideReference(const BasicMesh<Index>& mesh, ThreadPool&)
+    {
+        return GroupPolygonsReference(mesh);
+    }
+
+    template<typename Index>
+    Partition DivideUnionFind(const BasicMesh<Index>& mesh, ThreadPool&)
+    {
+        return GroupPolygonsUnionFind(mesh);
+    }
+}
+
+const std::vector<GroupingEngine>& GetGroupingEngines()
+{
+    static const std::vector<GroupingEngine> engines = {
+            {"reference", "Original quadratic algorithm (reference)",
+             DivideReference<uint16_t>, DivideReference<uint32_t>, DivideReference<uint64_t>},
+            {"unionfind", "Union-find over (position, uv) vertex keys",
+             DivideUnionFind<uint16_t>, DivideUnionFind<uint32_t>, DivideUnionFind<uint64_t>},
+            {"parallel", "Parallel lock-free union-find over hash-partitioned vertex keys",
+             GroupPolygonsParallel<uint16_t>, GroupPolygonsParallel<uint32_t>, GroupPolygonsParallel<uint64_t>}
+    };
+    return engines;
+}
+
+const GroupingEngine& GetEdgeGroupingEngine()
+{
+    static const GroupingEngine engine = {"edges", "Parallel lock-free union-find over shared (position, uv) edges",
+                                          GroupPolygonsByEdges<uint16_t>, GroupPolygonsByEdges<uint32_t>, GroupPolygonsByEdges<uint64_t>};
+    return engine;
+}
+
+const GroupingEngine* FindGroupingEngine(const std::string& name)
+{
+    for(const auto& engine : GetGroupingEngines()){
+        if(name == engine.name) return &engine;
+    }
+    return nullptr;
+}
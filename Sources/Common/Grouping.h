@@ -0,0 +1,221 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Разбиение полигонов на группы.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <type_traits>
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Группа вершин
+ *
+ * \details Полигоны в группе объединены общими вершиными. Используется эталонным (квадратичным) алгоритмом
+ */
+template<typename Index>
+struct BasicGroup
+{
+    std::vector<unsigned> polygons;
+    std::unordered_set<BasicVertex<Index>, typename BasicVertex<Index>::Hash> vertices;
+
+    [[nodiscard]] bool polygonBelongs(const BasicPolygonView<Index>& polygonVertices) const
+    {
+        return std::any_of(polygonVertices.begin(),polygonVertices.end(),[&](const BasicVertex<Index>& v){
+            return vertices.count(v);
+        });
+    }
+
+    void addPolygon(const unsigned polygonIdx, const BasicPolygonView<Index>& polygonVertices)
+    {
+        polygons.push_back(polygonIdx);
+
+        for(const auto& v : polygonVertices){
+            vertices.insert(v);
+        }
+    }
+
+    void joinGroup(BasicGroup& group)
+    {
+        polygons.insert(polygons.end(),group.polygons.begin(),group.polygons.end());
+        vertices.merge(group.vertices);
+    }
+
+    void cleanGroup()
+    {
+        polygons.clear();
+        vertices.clear();
+    }
+};
+
+/**
+ * \brief Результат разбиения - номер группы для каждого полигона
+ *
+ * \details Группы пронумерованы в порядке появления их первого полигона, поэтому разбиения, полученные разными
+ * алгоритмами, можно сравнивать напрямую
+ */
+struct Partition
+{
+    /// Номер группы каждого полигона
+    std::pmr::vector<unsigned> labels;
+    /// Кол-во групп
+    unsigned groupCount = 0;
+
+    Partition() = default;
+
+    explicit Partition(std::pmr::memory_resource* resource) : labels(resource)
+    {}
+};
+
+/**
+ * \brief Списки полигонов каждой группы (CSR)
+ */
+struct GroupMembers
+{
+    /// Смещения начала групп (последний элемент - общее кол-во полигонов)
+    std::pmr::vector<unsigned> offsets;
+    /// Индексы полигонов, упорядоченные по группам
+    std::pmr::vector<unsigned> polygons;
+
+    GroupMembers() = default;
+
+    explicit GroupMembers(std::pmr::memory_resource* resource) : offsets(resource), polygons(resource)
+    {}
+
+    [[nodiscard]] unsigned groupCount() const
+    {
+        return offsets.empty() ? 0 : static_cast<unsigned>(offsets.size() - 1);
+    }
+};
+
+/**
+ * \brief Алгоритм разбиения на UV группы
+ */
+struct GroupingEngine
+{
+    /// Имя (для командной строки)
+    const char* name;
+    /// Краткое описание
+    const char* description;
+    /// Функции разбиения для каждой разрядности индексов (результат выделяется из источника памяти меша)
+    Partition (*divide16)(const Mesh16& mesh, ThreadPool& pool);
+    Partition (*divide32)(const Mesh32& mesh, ThreadPool& pool);
+    Partition (*divide64)(const Mesh64& mesh, ThreadPool& pool);
+
+    /**
+     * \brief Разбить меш на группы (выбирается функция по разрядности индексов меша)
+     * \param mesh Меш
+     * \param pool Пул потоков
+     * \return Разбиение
+     */
+    template<typename Index>
+    Partition divide(const BasicMesh<Index>& mesh, ThreadPool& pool) const
+    {
+        if constexpr(std::is_same_v<Index, uint16_t>) return divide16(mesh, pool);
+        else if constexpr(std::is_same_v<Index, uint32_t>) return divide32(mesh, pool);
+        else return divide64(mesh, pool);
+    }
+};
+
+// Функции разбиения определены для uint16_t, uint32_t и uint64_t индексов
+
+/**
+ * \brief Эталонное разбиение на UV группы (исходный квадратичный алгоритм на основе Group)
+ * \param mesh Меш
+ * \return Разбиение
+ */
+template<typename Index>
+Partition GroupPolygonsReference(const BasicMesh<Index>& mesh);
+
+/**
+ * \brief Разбиение на UV группы при помощи системы непересекающихся множеств (union-find)
+ * \param mesh Меш
+ * \return Разбиение
+ */
+template<typename Index>
+Partition GroupPolygonsUnionFind(const BasicMesh<Index>& mesh);
+
+/**
+ * \brief Параллельное разбиение на UV группы (union-find с атомарными операциями)
+ *
+ * \details Вершины раскладываются по корзинам по хешу ключа (положение + UV), каждая корзина обрабатывается
+ * отдельной задачей со своей хеш-таблицей, полигоны объединяются в общем lock-free union-find
+ *
+ * \param mesh Меш
+ * \param pool Пул потоков
+ * \return Разбиение
+ */
+template<typename Index>
+Partition GroupPolygonsParallel(const BasicMesh<Index>& mesh, ThreadPool& pool);
+
+/**
+ * \brief Параллельное разбиение на UV группы по общим ребрам
+ *
+ * \details Полигоны объединяются, только если у них есть общее ребро - пара вершин с совпадающими положениями и UV
+ * (острова, касающиеся одной вершиной, остаются разными группами). Ребра упаковываются в ключи из пары ключей
+ * вершин и обрабатываются так же, как вершины в GroupPolygonsParallel. Результат всегда мельче (либо равен)
+ * разбиения по общим вершинам
+ *
+ * \param mesh Меш
+ * \param pool Пул потоков
+ * \return Разбиение
+ */
+template<typename Index>
+Partition GroupPolygonsByEdges(const BasicMesh<Index>& mesh, ThreadPool& pool);
+
+/**
+ * \brief Разбиение "по группе на каждый полигон"
+ * \param mesh Меш
+ * \return Разбиение
+ */
+template<typename Index>
+Partition GroupPolygonsPerPolygon(const BasicMesh<Index>& mesh);
+
+/**
+ * \brief Перенумеровать группы в порядке появления их первого полигона
+ * \param partition Разбиение
+ */
+void CanonicalizePartition(Partition& partition);
+
+/**
+ * \brief Собрать списки полигонов для каждой группы (полигоны внутри группы идут в исходном порядке)
+ * \param partition Разбиение
+ * \return Списки полигонов (выделяются из источника памяти разбиения)
+ */
+GroupMembers CollectGroupMembers(const Partition& partition);
+
+/**
+ * \brief Кол-во групп, полигоны которых попали в другом разбиении в разные группы
+ * \param coarse Группы
+ * \param fine Другие группы тех же полигонов
+ * \return Кол-во разделенных групп
+ */
+unsigned CountSplitGroups(const GroupMembers& coarse, const GroupMembers& fine);
+
+/**
+ * \brief Все доступные алгоритмы разбиения на UV группы (первый - эталонный)
+ * \return Массив алгоритмов
+ */
+const std::vector<GroupingEngine>& GetGroupingEngines();
+
+/**
+ * \brief Разбиение по общим ребрам (GroupPolygonsByEdges) в виде алгоритма разбиения
+ *
+ * \details В список GetGroupingEngines не входит - дает другие группы, чем эталон
+ *
+ * \return Алгоритм
+ */
+const GroupingEngine& GetEdgeGroupingEngine();
+
+/**
+ * \brief Найти алгоритм разбиения по имени
+ * \param name Имя
+ * \return Указатель на алгоритм либо nullptr
+ */
+const GroupingEngine* FindGroupingEngine(const std::string& name);
@@ -0,0 +1,1057 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Граф смежности островов и их слияние.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Islands.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <queue>
+
+namespace
+{
+    /// Признак отсутствующего значения
+    const unsigned NO_ISLAND = ~0u;
+
+    /// Минимальное кол-во элементов в диапазоне при параллельной обработке
+    const size_t MIN_CHUNK_ELEMENTS = 16384;
+
+    /// Минимальное кол-во островов в диапазоне при параллельной обработке
+    const size_t MIN_CHUNK_ISLANDS = 256;
+
+    /// Допуск при сравнении углов (погрешность нормалей, вычисленных в float)
+    const float ANGLE_EPSILON = 1e-3f;
+
+    /// Кол-во 64-битных слов множества цветов соседей острова (насыщенность учитывает первые 512 цветов)
+    const unsigned TRACKED_COLOR_WORDS = 8;
+
+    /// Наибольшее кол-во итераций k-средних при разбиении островов на ограниченное кол-во групп
+    const unsigned KMEANS_ITERATIONS = 16;
+
+    /// Косинус, начиная с которого ось считается совпадающей с центром (новый центр не нужен)
+    const float NEAREST_DOT = 0.999999f;
+
+    /// Шаг округления величин развертки при сравнении островов (доля текстуры)
+    const double SHAPE_QUANTUM = 1e-4;
+
+    /// Половина полного раствора (конус, не ограничивающий нормали)
+    const float FULL_ANGLE = 3.14159265f;
+
+    /**
+     * \brief Ось конуса (единичный вектор)
+     */
+    struct Axis
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+        /// Задана ли ось (у острова из одних вырожденных полигонов оси нет)
+        bool valid = false;
+    };
+
+    /**
+     * \brief Конус, содержащий нормали полигонов острова
+     */
+    struct Cone
+    {
+        Axis axis;
+        /// Половина раствора (радиан)
+        float angle = 0.0f;
+    };
+
+    inline float Dot(const Axis& a, const Axis& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    /**
+     * \brief Угол между единичными векторами (через atan2 - без потери точности acos у близких векторов)
+     * \param a Первый вектор
+     * \param b Второй вектор
+     * \return Угол (радиан)
+     */
+    inline float AngleBetween(const Axis& a, const Axis& b)
+    {
+        const float cx = a.y * b.z - a.z * b.y;
+        const float cy = a.z * b.x - a.x * b.z;
+        const float cz = a.x * b.y - a.y * b.x;
+        return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), Dot(a, b));
+    }
+
+    /**
+     * \brief Конус нормалей острова (ось - средняя нормаль, раствор - до самой далекой от нее нормали)
+     * \param normals Нормали полигонов
+     * \param faces Полигоны острова
+     * \param count Кол-во полигонов
+     * \return Конус
+     */
+    Cone IslandCone(const Coordinates& normals, const unsigned* faces, size_t count)
+    {
+        Cone cone;
+        bool degenerate = true;
+        for(size_t i = 0; i < count; i++)
+        {
+            const unsigned f = faces[i];
+            cone.axis.x += normals.x[f];
+            cone.axis.y += normals.y[f];
+            cone.axis.z += normals.z[f];
+            degenerate = degenerate && normals.x[f] == 0.0f && normals.y[f] == 0.0f && normals.z[f] == 0.0f;
+        }
+        if(degenerate) return {};
+
+        // Нормали взаимно уничтожаются - конус не ограничивает их
+        const float length = std::sqrt(Dot(cone.axis, cone.axis));
+        if(length <= 0.0f) return {{0.0f, 0.0f, 1.0f, true}, FULL_ANGLE};
+        cone.axis = {cone.axis.x / length, cone.axis.y / length, cone.axis.z / length, true};
+
+        for(size_t i = 0; i < count; i++)
+        {
+            const Axis n{normals.x[faces[i]], normals.y[faces[i]], normals.z[faces[i]], true};
+            if(n.x == 0.0f && n.y == 0.0f && n.z == 0.0f) continue;
+            cone.angle = std::max(cone.angle, AngleBetween(n, cone.axis));
+        }
+        return cone;
+    }
+
+    /**
+     * \brief Наименьший конус, содержащий оба конуса
+     * \param a Первый конус
+     * \param b Второй конус
+     * \param maxAngle Предельная половина раствора (радиан)
+     * \param result Объединенный конус
+     * \return Помещается ли объединение в предельный раствор
+     */
+    bool UniteCones(const Cone& a, const Cone& b, float maxAngle, Cone& result)
+    {
+        if(!a.axis.valid || !b.axis.valid){
+            result = a.axis.valid ? a : b;
+            return result.angle <= maxAngle + ANGLE_EPSILON;
+        }
+
+        const float dot = Dot(a.axis, b.axis);
+        const float distance = AngleBetween(a.axis, b.axis);
+        if(distance + b.angle <= a.angle){
+            result = a;
+        }else if(distance + a.angle <= b.angle){
+            result = b;
+        }else{
+            // Ось поворачивается от оси первого конуса к оси второго на разницу растворов
+            const float angle = (a.angle + b.angle + distance) * 0.5f;
+            const Axis side{b.axis.x - dot * a.axis.x, b.axis.y - dot * a.axis.y, b.axis.z - dot * a.axis.z, true};
+            const float length = std::sqrt(Dot(side, side));
+            if(angle >= FULL_ANGLE || length <= 0.0f){
+                result = {a.axis, FULL_ANGLE};
+            }else{
+                const float c = std::cos(angle - a.angle);
+                const float s = std::sin(angle - a.angle) / length;
+                result.axis = {a.axis.x * c + side.x * s, a.axis.y * c + side.y * s, a.axis.z * c + side.z * s, true};
+                result.angle = angle;
+            }
+        }
+        return result.angle <= maxAngle + ANGLE_EPSILON;
+    }
+
+    /**
+     * \brief Описание полигона острова (не зависит от сдвига, поворота и отражения развертки)
+     */
+    struct FaceShape
+    {
+        /// Кол-во вершин
+        int64_t sides;
+        /// Площадь, периметр и расстояние от центра полигона до центра острова в долях SHAPE_QUANTUM (-1 - у
+        /// полигона нет текстурных координат)
+        int64_t area;
+        int64_t perimeter;
+        int64_t radius;
+
+        bool operator==(const FaceShape& s) const
+        {
+            return sides == s.sides && area == s.area && perimeter == s.perimeter && radius == s.radius;
+        }
+
+        bool operator<(const FaceShape& s) const
+        {
+            if(sides != s.sides) return sides < s.sides;
+            if(area != s.area) return area < s.area;
+            if(perimeter != s.perimeter) return perimeter < s.perimeter;
+            return radius < s.radius;
+        }
+    };
+
+    /**
+     * \brief Описание общего ребра двух полигонов острова (связность развертки)
+     */
+    struct EdgeShape
+    {
+        /// Длина ребра в развертке в долях SHAPE_QUANTUM
+        int64_t length;
+        /// Описания полигонов ребра (first не больше second)
+        FaceShape first;
+        FaceShape second;
+
+        bool operator==(const EdgeShape& e) const
+        {
+            return length == e.length && first == e.first && second == e.second;
+        }
+
+        bool operator<(const EdgeShape& e) const
+        {
+            if(length != e.length) return length < e.length;
+            if(!(first == e.first)) return first < e.first;
+            return second < e.second;
+        }
+    };
+
+    /**
+     * \brief Перемешивание битов ключа (splitmix64)
+     * \param key Ключ
+     * \return Хеш
+     */
+    uint64_t MixKey(uint64_t key)
+    {
+        key = (key ^ (key >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27u)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31u);
+    }
+
+    /**
+     * \brief Конусы нормалей всех островов (параллельно)
+     * \param groups Острова
+     * \param normals Нормали полигонов
+     * \param pool Пул потоков
+     * \return Конусы
+     */
+    std::vector<Cone> IslandCones(const GroupMembers& groups, const Coordinates& normals, ThreadPool& pool)
+    {
+        std::vector<Cone> cones(groups.groupCount());
+        pool.parallelFor(cones.size(), [&](size_t begin, size_t end){
+            for(size_t g = begin; g < end; g++)
+            {
+                cones[g] = IslandCone(normals, groups.polygons.data() + groups.offsets[g], groups.offsets[g + 1] - groups.offsets[g]);
+            }
+        }, MIN_CHUNK_ISLANDS);
+        return cones;
+    }
+
+    /**
+     * \brief Диапазоны островов объектов
+     * \param objectOf Объект каждого острова (пусто - один диапазон)
+     * \param islandCount Кол-во островов
+     * \return Начало каждого диапазона (последний элемент - кол-во островов)
+     */
+    std::vector<unsigned> ObjectRanges(const std::vector<unsigned>& objectOf, unsigned islandCount)
+    {
+        std::vector<unsigned> ranges{0};
+        for(unsigned g = 1; g < islandCount; g++) if(!objectOf.empty() && objectOf[g] != objectOf[g - 1]) ranges.push_back(g);
+        ranges.push_back(islandCount);
+        return ranges;
+    }
+
+    /**
+     * \brief Найти корень множества (со сжатием пути делением пополам)
+     * \param parents Массив родителей
+     * \param i Элемент
+     * \return Корень
+     */
+    unsigned FindRoot(std::vector<unsigned>& parents, unsigned i)
+    {
+        while(parents[i] != i){
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    }
+}
+
+template<typename Index>
+IslandGraph BuildIslandGraph(const BasicMesh<Index>& mesh, const GroupMembers& groups, MeshTopology<Index>& topology,
+                             ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+    IslandGraph graph;
+    graph.offsets.assign(islandCount + 1, 0);
+    if(islandCount == 0) return graph;
+
+    // Остров каждого полигона
+    std::vector<unsigned> islandOf(mesh.faceCount(), NO_ISLAND);
+    pool.parallelFor(islandCount, [&](size_t begin, size_t end){
+        for(size_t g = begin; g < end; g++)
+        {
+            for(unsigned i = groups.offsets[g]; i < groups.offsets[g + 1]; i++) islandOf[groups.polygons[i]] = static_cast<unsigned>(g);
+        }
+    }, MIN_CHUNK_ISLANDS);
+
+    const HalfEdges& halfEdges = topology.halfEdges();
+    const size_t count = halfEdges.count();
+
+    // Пара соседних островов для полуребра (ребро из двух полуребер учитывается один раз)
+    auto pairOf = [&](size_t h, unsigned& a, unsigned& b){
+        const unsigned mate = halfEdges.mates[h];
+        if(mate == h || (mate < h && halfEdges.mates[mate] == h)) return false;
+        a = islandOf[halfEdges.faces[h]];
+        b = islandOf[halfEdges.faces[mate]];
+        return a != b && a != NO_ISLAND && b != NO_ISLAND;
+    };
+
+    // Пары в обе стороны раскладываются по корзинам - диапазонам первого острова, поэтому корзины, упорядоченные
+    // по отдельности, вместе дают упорядоченный граф. Первый проход считает размеры корзин каждого фрагмента
+    const unsigned bucketCount = pool.threadCount() * 4;
+    const unsigned chunkCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(bucketCount, count / MIN_CHUNK_ELEMENTS)));
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    auto bucketOf = [&](unsigned island){ return static_cast<unsigned>(static_cast<uint64_t>(island) * bucketCount / islandCount); };
+
+    std::vector<size_t> offsets(static_cast<size_t>(bucketCount) * chunkCount + 1, 0);
+    pool.run(chunkCount, [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        std::vector<size_t> counts(bucketCount, 0);
+        unsigned a, b;
+        for(size_t h = begin; h < end; h++)
+        {
+            if(!pairOf(h, a, b)) continue;
+            counts[bucketOf(a)]++;
+            counts[bucketOf(b)]++;
+        }
+        for(unsigned k = 0; k < bucketCount; k++) offsets[static_cast<size_t>(k) * chunkCount + c + 1] = counts[k];
+    });
+    for(size_t i = 1; i < offsets.size(); i++) offsets[i] += offsets[i - 1];
+
+    std::vector<uint64_t> pairs(offsets.back());
+    pool.run(chunkCount, [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        std::vector<size_t> cursors(bucketCount);
+        for(unsigned k = 0; k < bucketCount; k++) cursors[k] = offsets[static_cast<size_t>(k) * chunkCount + c];
+        unsigned a, b;
+        for(size_t h = begin; h < end; h++)
+        {
+            if(!pairOf(h, a, b)) continue;
+            pairs[cursors[bucketOf(a)]++] = (static_cast<uint64_t>(a) << 32u) | b;
+            pairs[cursors[bucketOf(b)]++] = (static_cast<uint64_t>(b) << 32u) | a;
+        }
+    });
+
+    // Корзины сортируются параллельно, одинаковые пары сворачиваются в начало корзины (повторы - вес связи)
+    std::vector<unsigned> weights(pairs.size());
+    std::vector<size_t> uniqueCounts(bucketCount + 1, 0);
+    pool.run(bucketCount, [&](unsigned k){
+        const size_t first = offsets[static_cast<size_t>(k) * chunkCount];
+        const size_t last = offsets[static_cast<size_t>(k + 1) * chunkCount];
+        std::sort(pairs.begin() + static_cast<ptrdiff_t>(first), pairs.begin() + static_cast<ptrdiff_t>(last));
+
+        size_t out = first;
+        for(size_t run = first; run < last;)
+        {
+            size_t runEnd = run + 1;
+            while(runEnd < last && pairs[runEnd] == pairs[run]) runEnd++;
+            pairs[out] = pairs[run];
+            weights[out++] = static_cast<unsigned>(runEnd - run);
+            run = runEnd;
+        }
+        uniqueCounts[k + 1] = out - first;
+    });
+    for(unsigned k = 1; k <= bucketCount; k++) uniqueCounts[k] += uniqueCounts[k - 1];
+
+    // Раскладка в CSR (острова корзины принадлежат только ей, кол-во соседей считается без гонок)
+    graph.neighbours.resize(uniqueCounts.back());
+    graph.weights.resize(uniqueCounts.back());
+    pool.run(bucketCount, [&](unsigned k){
+        const size_t first = offsets[static_cast<size_t>(k) * chunkCount];
+        for(size_t i = 0; i < uniqueCounts[k + 1] - uniqueCounts[k]; i++)
+        {
+            const uint64_t pair = pairs[first + i];
+            graph.neighbours[uniqueCounts[k] + i] = static_cast<unsigned>(pair);
+            graph.weights[uniqueCounts[k] + i] = weights[first + i];
+            graph.offsets[(pair >> 32u) + 1]++;
+        }
+    });
+    for(unsigned g = 1; g <= islandCount; g++) graph.offsets[g] += graph.offsets[g - 1];
+
+    return graph;
+}
+
+IslandGraph AddIslandConflicts(const IslandGraph& graph, const std::vector<std::pair<unsigned, unsigned>>& pairs)
+{
+    const unsigned islandCount = graph.islandCount();
+
+    // Конфликты каждого острова в обе стороны (CSR, по возрастанию)
+    std::vector<unsigned> conflictOffsets(islandCount + 1, 0), conflicts(pairs.size() * 2);
+    for(const auto& pair : pairs)
+    {
+        conflictOffsets[pair.first + 1]++;
+        conflictOffsets[pair.second + 1]++;
+    }
+    for(unsigned g = 1; g <= islandCount; g++) conflictOffsets[g] += conflictOffsets[g - 1];
+    std::vector<unsigned> cursors(conflictOffsets.begin(), conflictOffsets.end() - 1);
+    for(const auto& pair : pairs)
+    {
+        conflicts[cursors[pair.first]++] = pair.second;
+        conflicts[cursors[pair.second]++] = pair.first;
+    }
+
+    // Списки соседей и конфликтов сливаются с сохранением порядка (конфликт уже смежных островов не добавляется)
+    IslandGraph result;
+    result.offsets.assign(islandCount + 1, 0);
+    result.neighbours.reserve(graph.neighbours.size() + conflicts.size());
+    result.weights.reserve(graph.neighbours.size() + conflicts.size());
+    for(unsigned g = 0; g < islandCount; g++)
+    {
+        auto conflict = conflicts.begin() + conflictOffsets[g];
+        const auto last = conflicts.begin() + conflictOffsets[g + 1];
+        std::sort(conflict, last);
+
+        for(unsigned i = graph.offsets[g]; i <= graph.offsets[g + 1]; i++)
+        {
+            const bool neighbour = i < graph.offsets[g + 1];
+            for(; conflict != last && (!neighbour || *conflict < graph.neighbours[i]); ++conflict)
+            {
+                result.neighbours.push_back(*conflict);
+                result.weights.push_back(0);
+            }
+            if(!neighbour) break;
+            if(conflict != last && *conflict == graph.neighbours[i]) ++conflict;
+            result.neighbours.push_back(graph.neighbours[i]);
+            result.weights.push_back(graph.weights[i]);
+        }
+        result.offsets[g + 1] = static_cast<unsigned>(result.neighbours.size());
+    }
+    return result;
+}
+
+template<typename Index>
+std::vector<float> IslandUvAreas(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& texCoords,
+                                 ThreadPool& pool)
+{
+    std::vector<float> areas(groups.groupCount(), 0.0f);
+    pool.parallelFor(groups.groupCount(), [&](size_t begin, size_t end){
+        for(size_t g = begin; g < end; g++)
+        {
+            double area = 0.0;
+            for(unsigned i = groups.offsets[g]; i < groups.offsets[g + 1]; i++)
+            {
+                const auto polygon = mesh.polygon(groups.polygons[i]);
+                double doubled = 0.0;
+                bool complete = true;
+                for(size_t v = 0; v < polygon.size() && complete; v++)
+                {
+                    const uint64_t a = polygon.first[v].uvIdx;
+                    const uint64_t b = polygon.first[(v + 1) % polygon.size()].uvIdx;
+                    complete = a != 0 && b != 0 && a <= texCoords.count() && b <= texCoords.count();
+                    if(complete) doubled += static_cast<double>(texCoords.x[a - 1]) * texCoords.y[b - 1] -
+                                            static_cast<double>(texCoords.x[b - 1]) * texCoords.y[a - 1];
+                }
+                if(complete) area += std::abs(doubled) * 0.5;
+            }
+            areas[g] = static_cast<float>(area);
+        }
+    }, MIN_CHUNK_ISLANDS);
+    return areas;
+}
+
+GroupMembers UniteIslands(const GroupMembers& groups, const std::vector<unsigned>& labels, unsigned labelCount, ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+
+    // Острова каждой новой группы (CSR, в исходном порядке) и размеры групп
+    std::vector<unsigned> islandOffsets(labelCount + 1, 0), islands(islandCount);
+    GroupMembers united(groups.offsets.get_allocator().resource());
+    united.offsets.assign(labelCount + 1, 0);
+    for(unsigned g = 0; g < islandCount; g++)
+    {
+        islandOffsets[labels[g] + 1]++;
+        united.offsets[labels[g] + 1] += groups.offsets[g + 1] - groups.offsets[g];
+    }
+    for(unsigned l = 1; l <= labelCount; l++)
+    {
+        islandOffsets[l] += islandOffsets[l - 1];
+        united.offsets[l] += united.offsets[l - 1];
+    }
+    std::vector<unsigned> cursors(islandOffsets.begin(), islandOffsets.end() - 1);
+    for(unsigned g = 0; g < islandCount; g++) islands[cursors[labels[g]]++] = g;
+
+    // Полигоны групп копируются параллельно, внутри группы из нескольких островов - по возрастанию
+    united.polygons.resize(groups.polygons.size());
+    pool.parallelFor(labelCount, [&](size_t begin, size_t end){
+        for(size_t l = begin; l < end; l++)
+        {
+            unsigned* first = united.polygons.data() + united.offsets[l];
+            unsigned* out = first;
+            for(unsigned i = islandOffsets[l]; i < islandOffsets[l + 1]; i++)
+            {
+                const unsigned g = islands[i];
+                out = std::copy(groups.polygons.begin() + groups.offsets[g], groups.polygons.begin() + groups.offsets[g + 1], out);
+            }
+            if(islandOffsets[l + 1] - islandOffsets[l] > 1) std::sort(first, out);
+        }
+    }, MIN_CHUNK_ISLANDS);
+
+    return united;
+}
+
+IslandMerge MergeSmallIslands(const GroupMembers& groups, const IslandGraph& graph, const IslandMergeSettings& settings,
+                              const Coordinates& faceNormals, const std::vector<float>& uvAreas,
+                              const std::vector<unsigned>& objectOf, ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+    const bool limitAngle = settings.maxNormalAngle > 0.0f;
+    const bool limitArea = settings.maxUvArea > 0.0f && uvAreas.size() == islandCount;
+    const float halfAngle = settings.maxNormalAngle * 0.5f * FULL_ANGLE / 180.0f;
+
+    // Размеры и конусы нормалей объединенных островов (по корню), конусы исходных островов - параллельно
+    std::vector<unsigned> faces(islandCount);
+    std::vector<double> areas(islandCount, 0.0);
+    std::vector<Cone> cones = limitAngle ? IslandCones(groups, faceNormals, pool) : std::vector<Cone>();
+    for(unsigned g = 0; g < islandCount; g++)
+    {
+        faces[g] = groups.offsets[g + 1] - groups.offsets[g];
+        if(limitArea) areas[g] = uvAreas[g];
+    }
+
+    auto small = [&](unsigned g){
+        return (settings.maxFaces > 0 && faces[g] <= settings.maxFaces) || (limitArea && areas[g] < settings.maxUvArea);
+    };
+
+    // Мелкие острова - от самых мелких (порядок не зависит от кол-ва потоков)
+    std::vector<unsigned> order;
+    for(unsigned g = 0; g < islandCount; g++) if(small(g)) order.push_back(g);
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b){
+        if(faces[a] != faces[b]) return faces[a] < faces[b];
+        if(areas[a] != areas[b]) return areas[a] < areas[b];
+        return a < b;
+    });
+
+    // Объединенные острова - множества с корнем в острове, к которому присоединяли, и списком исходных островов
+    std::vector<unsigned> parents(islandCount), nextMember(islandCount, NO_ISLAND), lastMember(islandCount);
+    std::iota(parents.begin(), parents.end(), 0u);
+    std::iota(lastMember.begin(), lastMember.end(), 0u);
+
+    IslandMerge result{GroupMembers(groups.offsets.get_allocator().resource()), {}, 0};
+    struct Candidate
+    {
+        unsigned root;
+        unsigned weight;
+    };
+    std::vector<Candidate> candidates;
+    for(const unsigned s : order)
+    {
+        if(parents[s] != s || !small(s)) continue;
+
+        // Соседние объединенные острова (по соседям всех исходных островов), вес - общее кол-во ребер
+        candidates.clear();
+        for(unsigned m = s; m != NO_ISLAND; m = nextMember[m])
+        {
+            for(unsigned k = graph.offsets[m]; k < graph.offsets[m + 1]; k++)
+            {
+                const unsigned r = FindRoot(parents, graph.neighbours[k]);
+                if(r == s || (!objectOf.empty() && objectOf[r] != objectOf[s])) continue;
+                candidates.push_back({r, graph.weights[k]});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b){ return a.root < b.root; });
+        size_t unique = 0;
+        for(size_t i = 0; i < candidates.size(); i++)
+        {
+            if(unique > 0 && candidates[unique - 1].root == candidates[i].root) candidates[unique - 1].weight += candidates[i].weight;
+            else candidates[unique++] = candidates[i];
+        }
+        candidates.resize(unique);
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b){ return a.weight > b.weight; });
+
+        // Первый сосед (по убыванию веса), объединение с которым не нарушает правило нормалей
+        for(const Candidate& candidate : candidates)
+        {
+            const unsigned r = candidate.root;
+            Cone united;
+            if(limitAngle && !UniteCones(cones[r], cones[s], halfAngle, united)) continue;
+
+            parents[s] = r;
+            nextMember[lastMember[r]] = s;
+            lastMember[r] = lastMember[s];
+            faces[r] += faces[s];
+            areas[r] += areas[s];
+            if(limitAngle) cones[r] = united;
+            result.mergedCount++;
+            break;
+        }
+    }
+
+    // Новые группы - сохранившиеся острова в исходном порядке
+    result.firstKept.assign(islandCount + 1, 0);
+    for(unsigned g = 0; g < islandCount; g++) result.firstKept[g + 1] = result.firstKept[g] + (parents[g] == g ? 1 : 0);
+
+    std::vector<unsigned> labels(islandCount);
+    for(unsigned g = 0; g < islandCount; g++) labels[g] = result.firstKept[FindRoot(parents, g)];
+    result.groups = UniteIslands(groups, labels, result.firstKept.back(), pool);
+
+    return result;
+}
+
+IslandColoring ColorIslands(const GroupMembers& groups, const IslandGraph& graph, float maxNormalAngle,
+                            const Coordinates& faceNormals, const std::vector<unsigned>& objectOf, ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+    const bool limitAngle = maxNormalAngle > 0.0f;
+    const float halfAngle = maxNormalAngle * 0.5f * FULL_ANGLE / 180.0f;
+
+    const std::vector<Cone> cones = limitAngle ? IslandCones(groups, faceNormals, pool) : std::vector<Cone>();
+
+    // Диапазоны островов объектов (раскрашиваются независимо, связи между объектами не учитываются)
+    const std::vector<unsigned> ranges = ObjectRanges(objectOf, islandCount);
+    const unsigned rangeCount = static_cast<unsigned>(ranges.size() - 1);
+
+    IslandColoring coloring;
+    coloring.colors.assign(islandCount, NO_ISLAND);
+    std::vector<unsigned> colorCounts(rangeCount + 1, 0);
+
+    pool.parallelFor(rangeCount, [&](size_t rangeBegin, size_t rangeEnd){
+        for(size_t r = rangeBegin; r < rangeEnd; r++)
+        {
+            const unsigned first = ranges[r];
+            const unsigned count = ranges[r + 1] - first;
+
+            // Цвета соседей каждого острова - битовое множество (первые TRACKED_COLOR_WORDS * 64 цветов)
+            unsigned maxDegree = 0;
+            for(unsigned g = first; g < first + count; g++) maxDegree = std::max(maxDegree, graph.offsets[g + 1] - graph.offsets[g]);
+            const unsigned words = std::min(TRACKED_COLOR_WORDS, maxDegree / 64 + 1);
+            std::vector<uint64_t> seen(static_cast<size_t>(count) * words, 0);
+            std::vector<unsigned> saturation(count, 0);
+
+            // Очередь - наибольшая насыщенность, затем наибольшая степень, затем наименьший номер (устаревшие
+            // элементы пропускаются при извлечении)
+            struct Entry
+            {
+                unsigned saturation;
+                unsigned degree;
+                unsigned island;
+
+                bool operator<(const Entry& e) const
+                {
+                    if(saturation != e.saturation) return saturation < e.saturation;
+                    if(degree != e.degree) return degree < e.degree;
+                    return island > e.island;
+                }
+            };
+            std::priority_queue<Entry> queue;
+            for(unsigned g = first; g < first + count; g++) queue.push({0, graph.offsets[g + 1] - graph.offsets[g], g});
+
+            std::vector<unsigned> usedBy;
+            std::vector<Cone> colorCones;
+            while(!queue.empty())
+            {
+                const Entry entry = queue.top();
+                queue.pop();
+                const unsigned g = entry.island;
+                if(coloring.colors[g] != NO_ISLAND || entry.saturation != saturation[g - first]) continue;
+
+                // Наименьший цвет, не занятый соседями и (если угол ограничен) вмещающий нормали острова
+                for(unsigned k = graph.offsets[g]; k < graph.offsets[g + 1]; k++)
+                {
+                    const unsigned n = graph.neighbours[k];
+                    if(n >= first && n < first + count && coloring.colors[n] != NO_ISLAND) usedBy[coloring.colors[n]] = g;
+                }
+                unsigned color = 0;
+                Cone united;
+                while(color < usedBy.size() && (usedBy[color] == g || (limitAngle && !UniteCones(colorCones[color], cones[g], halfAngle, united)))) color++;
+                if(color == usedBy.size()){
+                    usedBy.push_back(NO_ISLAND);
+                    if(limitAngle) colorCones.push_back(cones[g]);
+                }else if(limitAngle){
+                    colorCones[color] = united;
+                }
+                coloring.colors[g] = color;
+
+                // Насыщенность нераскрашенных соседей
+                if(color >= words * 64) continue;
+                for(unsigned k = graph.offsets[g]; k < graph.offsets[g + 1]; k++)
+                {
+                    const unsigned n = graph.neighbours[k];
+                    if(n < first || n >= first + count || coloring.colors[n] != NO_ISLAND) continue;
+                    uint64_t& word = seen[static_cast<size_t>(n - first) * words + color / 64];
+                    const uint64_t bit = 1ull << (color % 64);
+                    if(word & bit) continue;
+                    word |= bit;
+                    queue.push({++saturation[n - first], graph.offsets[n + 1] - graph.offsets[n], n});
+                }
+            }
+            colorCounts[r + 1] = static_cast<unsigned>(usedBy.size());
+        }
+    }, 1);
+
+    // Сквозная нумерация цветов (цвета объекта идут подряд)
+    for(unsigned r = 1; r <= rangeCount; r++) colorCounts[r] += colorCounts[r - 1];
+    pool.parallelFor(rangeCount, [&](size_t begin, size_t end){
+        for(size_t r = begin; r < end; r++)
+        {
+            for(unsigned g = ranges[r]; g < ranges[r + 1]; g++) coloring.colors[g] += colorCounts[r];
+        }
+    }, 1);
+    coloring.colorCount = colorCounts.back();
+    return coloring;
+}
+
+IslandPartition PartitionIslands(const GroupMembers& groups, unsigned maxGroups, float maxNormalAngle,
+                                 const Coordinates& faceNormals, const std::vector<unsigned>& objectOf, ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+    const bool limitAngle = maxNormalAngle > 0.0f;
+    const float halfAngle = maxNormalAngle * 0.5f * FULL_ANGLE / 180.0f;
+    const std::vector<Cone> cones = IslandCones(groups, faceNormals, pool);
+    const std::vector<unsigned> ranges = ObjectRanges(objectOf, islandCount);
+    const unsigned rangeCount = static_cast<unsigned>(ranges.size() - 1);
+    auto weightOf = [&](unsigned g){ return static_cast<float>(groups.offsets[g + 1] - groups.offsets[g]); };
+
+    // Доли ограничения - пропорционально кол-ву островов (остаток - объектам с наибольшими остатками долей)
+    std::vector<unsigned> budgets(rangeCount);
+    std::vector<uint64_t> remainders(rangeCount);
+    uint64_t assigned = 0;
+    for(unsigned r = 0; r < rangeCount; r++)
+    {
+        const uint64_t share = static_cast<uint64_t>(maxGroups) * (ranges[r + 1] - ranges[r]);
+        budgets[r] = std::max(1u, static_cast<unsigned>(share / std::max(1u, islandCount)));
+        remainders[r] = share % std::max(1u, islandCount);
+        assigned += budgets[r];
+    }
+    std::vector<unsigned> order(rangeCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b){ return remainders[a] > remainders[b]; });
+    for(unsigned i = 0; i < rangeCount && assigned < maxGroups; i++, assigned++) budgets[order[i]]++;
+
+    IslandPartition partition;
+    partition.labels.assign(islandCount, 0);
+    for(unsigned r = 0; r < rangeCount; r++)
+    {
+        const unsigned first = ranges[r];
+        const unsigned count = ranges[r + 1] - first;
+        const unsigned k = std::min(budgets[r], count);
+        unsigned* labels = partition.labels.data() + first;
+        if(count == 0) continue;
+
+        // Начальные центры - ось самого крупного острова, затем каждый раз ось, наиболее удаленная от всех центров
+        // (острова без оси подходят к любой группе и в выборе не участвуют)
+        std::vector<Axis> centers;
+        std::vector<float> nearest(count, -2.0f);
+        unsigned seed = NO_ISLAND;
+        for(unsigned i = 0; i < count; i++)
+        {
+            if(cones[first + i].axis.valid && (seed == NO_ISLAND || weightOf(first + i) > weightOf(first + seed))) seed = i;
+        }
+        while(seed != NO_ISLAND && centers.size() < k)
+        {
+            const Axis center = cones[first + seed].axis;
+            centers.push_back(center);
+            pool.parallelFor(count, [&](size_t begin, size_t end){
+                for(size_t i = begin; i < end; i++)
+                {
+                    if(cones[first + i].axis.valid) nearest[i] = std::max(nearest[i], Dot(cones[first + i].axis, center));
+                }
+            }, MIN_CHUNK_ISLANDS);
+
+            seed = NO_ISLAND;
+            for(unsigned i = 0; i < count; i++)
+            {
+                if(cones[first + i].axis.valid && nearest[i] < NEAREST_DOT && (seed == NO_ISLAND || nearest[i] < nearest[seed])) seed = i;
+            }
+        }
+
+        // Сферический k-средних: острова - к ближайшему центру (параллельно), центры - средние оси групп
+        std::fill(labels, labels + count, 0u);
+        for(unsigned iteration = 0; iteration < KMEANS_ITERATIONS && centers.size() > 1; iteration++)
+        {
+            std::atomic<bool> changed{false};
+            pool.parallelFor(count, [&](size_t begin, size_t end){
+                bool localChanged = false;
+                for(size_t i = begin; i < end; i++)
+                {
+                    const Axis& axis = cones[first + i].axis;
+                    if(!axis.valid) continue;
+                    unsigned best = 0;
+                    float bestDot = Dot(axis, centers[0]);
+                    for(unsigned c = 1; c < centers.size(); c++)
+                    {
+                        const float dot = Dot(axis, centers[c]);
+                        if(dot > bestDot){
+                            best = c;
+                            bestDot = dot;
+                        }
+                    }
+                    localChanged = localChanged || labels[i] != best;
+                    labels[i] = best;
+                }
+                if(localChanged) changed = true;
+            }, MIN_CHUNK_ISLANDS);
+            if(iteration > 0 && !changed) break;
+
+            std::vector<Axis> sums(centers.size());
+            for(unsigned i = 0; i < count; i++)
+            {
+                const Axis& axis = cones[first + i].axis;
+                if(!axis.valid) continue;
+                Axis& sum = sums[labels[i]];
+                sum.x += axis.x * weightOf(first + i);
+                sum.y += axis.y * weightOf(first + i);
+                sum.z += axis.z * weightOf(first + i);
+            }
+            for(unsigned c = 0; c < centers.size(); c++)
+            {
+                const float length = std::sqrt(Dot(sums[c], sums[c]));
+                if(length > 0.0f) centers[c] = {sums[c].x / length, sums[c].y / length, sums[c].z / length, true};
+            }
+        }
+
+        // Конусы групп. Если угол ограничен, острова групп шире половины угла раскладываются заново: от крупных к
+        // мелким, в первую группу, объединение с которой укладывается в угол, иначе - в новую группу
+        std::vector<Cone> groupCones(std::max<size_t>(1, centers.size()));
+        for(unsigned i = 0; i < count; i++) UniteCones(groupCones[labels[i]], cones[first + i], FULL_ANGLE, groupCones[labels[i]]);
+        if(limitAngle){
+            std::vector<unsigned> orphans;
+            for(unsigned i = 0; i < count; i++) if(groupCones[labels[i]].angle > halfAngle + ANGLE_EPSILON) orphans.push_back(i);
+            for(Cone& cone : groupCones) if(cone.angle > halfAngle + ANGLE_EPSILON) cone = Cone();
+            std::stable_sort(orphans.begin(), orphans.end(), [&](unsigned a, unsigned b){ return weightOf(first + a) > weightOf(first + b); });
+
+            for(const unsigned i : orphans)
+            {
+                Cone united;
+                unsigned c = 0;
+                while(c < groupCones.size() && !UniteCones(groupCones[c], cones[first + i], halfAngle, united)) c++;
+                if(c == groupCones.size()){
+                    groupCones.push_back(cones[first + i]);
+                }else{
+                    groupCones[c] = united;
+                }
+                labels[i] = c;
+            }
+        }
+
+        // Разброс групп из нескольких островов (раствор конуса, не больше 180 градусов)
+        std::vector<unsigned> sizes(groupCones.size(), 0);
+        for(unsigned i = 0; i < count; i++) sizes[labels[i]]++;
+        for(size_t c = 0; c < groupCones.size(); c++)
+        {
+            if(sizes[c] > 1) partition.maxSpread = std::max(partition.maxSpread, std::min(180.0f, groupCones[c].angle * 360.0f / FULL_ANGLE));
+        }
+
+        // Сквозная нумерация непустых групп
+        std::vector<unsigned> renumbered(groupCones.size(), NO_ISLAND);
+        for(unsigned i = 0; i < count; i++)
+        {
+            if(renumbered[labels[i]] == NO_ISLAND) renumbered[labels[i]] = partition.groupCount++;
+            labels[i] = renumbered[labels[i]];
+        }
+    }
+    return partition;
+}
+
+template<typename Index>
+IslandDuplicates FindDuplicateIslands(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& texCoords,
+                                      const std::vector<unsigned>& objectOf, ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+    auto quantize = [](double value){ return static_cast<int64_t>(std::llround(value / SHAPE_QUANTUM)); };
+
+    // Описания полигонов (на месте полигонов острова) и хеш острова
+    std::vector<FaceShape> shapes(groups.polygons.size());
+    std::vector<std::vector<EdgeShape>> edgeShapes(islandCount);
+    std::vector<uint64_t> hashes(islandCount);
+    auto shapeHash = [](const FaceShape& shape){
+        return MixKey(static_cast<uint64_t>(shape.sides) ^ MixKey(static_cast<uint64_t>(shape.area) ^
+               MixKey(static_cast<uint64_t>(shape.perimeter) ^ MixKey(static_cast<uint64_t>(shape.radius)))));
+    };
+    pool.parallelFor(islandCount, [&](size_t begin, size_t end){
+        std::vector<double> centerX, centerY;
+        std::vector<std::pair<std::pair<uint64_t, uint64_t>, std::pair<unsigned, double>>> edges;
+        for(size_t g = begin; g < end; g++)
+        {
+            const unsigned first = groups.offsets[g];
+            const unsigned count = groups.offsets[g + 1] - first;
+            centerX.assign(count, 0.0);
+            centerY.assign(count, 0.0);
+
+            // Площадь, периметр и центр каждого полигона, центр острова - среднее центров полигонов
+            double islandX = 0.0, islandY = 0.0;
+            unsigned textured = 0;
+            for(unsigned i = 0; i < count; i++)
+            {
+                const auto polygon = mesh.polygon(groups.polygons[first + i]);
+                FaceShape& shape = shapes[first + i];
+                shape = {static_cast<int64_t>(polygon.size()), -1, -1, -1};
+
+                double doubled = 0.0, perimeter = 0.0;
+                bool complete = polygon.size() > 0;
+                for(size_t v = 0; v < polygon.size() && complete; v++)
+                {
+                    const uint64_t a = polygon.first[v].uvIdx;
+                    const uint64_t b = polygon.first[(v + 1) % polygon.size()].uvIdx;
+                    complete = a != 0 && b != 0 && a <= texCoords.count() && b <= texCoords.count();
+                    if(!complete) break;
+                    const double ax = texCoords.x[a - 1], ay = texCoords.y[a - 1];
+                    const double bx = texCoords.x[b - 1], by = texCoords.y[b - 1];
+                    doubled += ax * by - bx * ay;
+                    perimeter += std::sqrt((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+                    centerX[i] += ax;
+                    centerY[i] += ay;
+                }
+                if(!complete) continue;
+
+                centerX[i] /= static_cast<double>(polygon.size());
+                centerY[i] /= static_cast<double>(polygon.size());
+                shape.area = quantize(std::abs(doubled) * 0.5);
+                shape.perimeter = quantize(perimeter);
+                islandX += centerX[i];
+                islandY += centerY[i];
+                textured++;
+            }
+            if(textured > 0){
+                islandX /= textured;
+                islandY /= textured;
+            }
+
+            uint64_t hash = MixKey(count);
+            for(unsigned i = 0; i < count; i++)
+            {
+                FaceShape& shape = shapes[first + i];
+                if(shape.area >= 0) shape.radius = quantize(std::hypot(centerX[i] - islandX, centerY[i] - islandY));
+            }
+
+            // Общие ребра полигонов (одинаковые пары текстурных координат) с описаниями обоих полигонов
+            edges.clear();
+            for(unsigned i = 0; i < count; i++)
+            {
+                if(shapes[first + i].area < 0) continue;
+                const auto polygon = mesh.polygon(groups.polygons[first + i]);
+                for(size_t v = 0; v < polygon.size(); v++)
+                {
+                    const uint64_t a = polygon.first[v].uvIdx;
+                    const uint64_t b = polygon.first[(v + 1) % polygon.size()].uvIdx;
+                    if(a == b) continue;
+                    const double length = std::hypot(texCoords.x[b - 1] - texCoords.x[a - 1], texCoords.y[b - 1] - texCoords.y[a - 1]);
+                    edges.push_back({{std::min(a, b), std::max(a, b)}, {i, length}});
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            std::vector<EdgeShape>& islandEdges = edgeShapes[g];
+            for(size_t e = 1; e < edges.size(); e++)
+            {
+                if(edges[e].first != edges[e - 1].first) continue;
+                const FaceShape& a = shapes[first + edges[e - 1].second.first];
+                const FaceShape& b = shapes[first + edges[e].second.first];
+                islandEdges.push_back({quantize(edges[e].second.second), a < b ? a : b, a < b ? b : a});
+            }
+            std::sort(islandEdges.begin(), islandEdges.end());
+
+            std::sort(shapes.begin() + first, shapes.begin() + first + count);
+            for(unsigned i = 0; i < count; i++) hash = MixKey(hash ^ shapeHash(shapes[first + i]));
+            for(const EdgeShape& edge : islandEdges)
+            {
+                hash = MixKey(hash ^ MixKey(static_cast<uint64_t>(edge.length) ^ MixKey(shapeHash(edge.first) ^ MixKey(shapeHash(edge.second)))));
+            }
+            hashes[g] = hash;
+        }
+    }, MIN_CHUNK_ISLANDS);
+
+    // Острова упорядочиваются по объекту и хешу, острова с одним хешем сравниваются с первыми островами классов
+    std::vector<unsigned> order(islandCount);
+    std::iota(order.begin(), order.end(), 0u);
+    auto objectKey = [&](unsigned g){ return objectOf.empty() ? 0u : objectOf[g]; };
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b){
+        if(objectKey(a) != objectKey(b)) return objectKey(a) < objectKey(b);
+        if(hashes[a] != hashes[b]) return hashes[a] < hashes[b];
+        return a < b;
+    });
+
+    IslandDuplicates duplicates;
+    duplicates.classOf.resize(islandCount);
+    std::vector<unsigned> representatives;
+    std::vector<unsigned> classSizes;
+    for(unsigned run = 0; run < islandCount;)
+    {
+        unsigned runEnd = run + 1;
+        while(runEnd < islandCount && hashes[order[runEnd]] == hashes[order[run]] && objectKey(order[runEnd]) == objectKey(order[run])) runEnd++;
+
+        representatives.clear();
+        classSizes.clear();
+        for(unsigned i = run; i < runEnd; i++)
+        {
+            const unsigned g = order[i];
+            const unsigned size = groups.offsets[g + 1] - groups.offsets[g];
+            size_t r = 0;
+            for(; r < representatives.size(); r++)
+            {
+                const unsigned rep = representatives[r];
+                if(groups.offsets[rep + 1] - groups.offsets[rep] == size &&
+                   std::equal(shapes.begin() + groups.offsets[g], shapes.begin() + groups.offsets[g + 1], shapes.begin() + groups.offsets[rep]) &&
+                   edgeShapes[g] == edgeShapes[rep]) break;
+            }
+            if(r == representatives.size()){
+                representatives.push_back(g);
+                classSizes.push_back(0);
+            }
+            duplicates.classOf[g] = representatives[r];
+            classSizes[r]++;
+        }
+        for(unsigned size : classSizes)
+        {
+            if(size < 2) continue;
+            duplicates.repeatedShapes++;
+            duplicates.repeatedIslands += size;
+        }
+        run = runEnd;
+    }
+    return duplicates;
+}
+
+IslandPartition ShareDuplicateIslands(const GroupMembers& groups, const IslandDuplicates& duplicates, float maxNormalAngle,
+                                      const Coordinates& faceNormals, ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+    const bool limitAngle = maxNormalAngle > 0.0f;
+    const float halfAngle = maxNormalAngle * 0.5f * FULL_ANGLE / 180.0f;
+    const std::vector<Cone> cones = limitAngle ? IslandCones(groups, faceNormals, pool) : std::vector<Cone>();
+
+    // Группы класса - цепочка от первого острова класса (класс всегда начинается своим первым островом)
+    IslandPartition partition;
+    partition.labels.resize(islandCount);
+    std::vector<unsigned> nextGroup;
+    std::vector<unsigned> groupFirst;
+    std::vector<Cone> groupCones;
+    std::vector<unsigned> firstGroupOf(islandCount, NO_ISLAND);
+    for(unsigned g = 0; g < islandCount; g++)
+    {
+        const unsigned rep = duplicates.classOf[g];
+        unsigned group = firstGroupOf[rep];
+        unsigned last = NO_ISLAND;
+        Cone united;
+        while(group != NO_ISLAND && limitAngle && !UniteCones(groupCones[group], cones[g], halfAngle, united))
+        {
+            last = group;
+            group = nextGroup[group];
+        }
+
+        if(group == NO_ISLAND){
+            group = partition.groupCount++;
+            nextGroup.push_back(NO_ISLAND);
+            groupCones.push_back(limitAngle ? cones[g] : Cone());
+            if(last != NO_ISLAND) nextGroup[last] = group;
+            else firstGroupOf[rep] = group;
+        }else if(limitAngle){
+            groupCones[group] = united;
+        }
+        partition.labels[g] = group;
+    }
+    return partition;
+}
+
+template IslandGraph BuildIslandGraph(const Mesh16&, const GroupMembers&, MeshTopology<uint16_t>&, ThreadPool&);
+template IslandGraph BuildIslandGraph(const Mesh32&, const GroupMembers&, MeshTopology<uint32_t>&, ThreadPool&);
+template IslandGraph BuildIslandGraph(const Mesh64&, const GroupMembers&, MeshTopology<uint64_t>&, ThreadPool&);
+
+template std::vector<float> IslandUvAreas(const Mesh16&, const GroupMembers&, const Coordinates&, ThreadPool&);
+template std::vector<float> IslandUvAreas(const Mesh32&, const GroupMembers&, const Coordinates&, ThreadPool&);
+template std::vector<float> IslandUvAreas(const Mesh64&, const GroupMembers&, const Coordinates&, ThreadPool&);
+
+template IslandDuplicates FindDuplicateIslands(const Mesh16&, const GroupMembers&, const Coordinates&, const std::vector<unsigned>&, ThreadPool&);
+template IslandDuplicates FindDuplicateIslands(const Mesh32&, const GroupMembers&, const Coordinates&, const std::vector<unsigned>&, ThreadPool&);
+template IslandDuplicates FindDuplicateIslands(const Mesh64&, const GroupMembers&, const Coordinates&, const std::vector<unsigned>&, ThreadPool&);
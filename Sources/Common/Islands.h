@@ -0,0 +1,256 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Граф смежности островов и их слияние.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "Mesh.h"
+#include "Geometry.h"
+#include "Grouping.h"
+#include "Topology.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Граф смежности островов (групп) в CSR
+ *
+ * \details Острова смежны, если у их полигонов есть общее ребро (по положениям вершин, например шов развертки).
+ * Вес связи - кол-во общих ребер
+ */
+struct IslandGraph
+{
+    /// Смещения начала соседей каждого острова (последний элемент - общее кол-во связей в обе стороны)
+    std::vector<unsigned> offsets;
+    /// Соседи (по возрастанию номера)
+    std::vector<unsigned> neighbours;
+    /// Кол-во общих ребер с каждым соседом
+    std::vector<unsigned> weights;
+
+    [[nodiscard]] unsigned islandCount() const
+    {
+        return offsets.empty() ? 0 : static_cast<unsigned>(offsets.size() - 1);
+    }
+};
+
+/**
+ * \brief Построить граф смежности островов
+ *
+ * \details Фрагменты полуребер параллельно собирают и сворачивают пары соседних островов, затем пары всех
+ * фрагментов сворачиваются и раскладываются в CSR. Определена для uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param groups Острова
+ * \param topology Смежность полигонов меша (строится, если еще не построена)
+ * \param pool Пул потоков
+ * \return Граф
+ */
+template<typename Index>
+IslandGraph BuildIslandGraph(const BasicMesh<Index>& mesh, const GroupMembers& groups, MeshTopology<Index>& topology,
+                             ThreadPool& pool);
+
+/**
+ * \brief Добавить в граф связи конфликтующих островов без общих ребер (например, накладывающихся в развертке)
+ *
+ * \details Связь, которой не было в графе, получает вес 0, существующие связи не меняются
+ *
+ * \param graph Граф смежности островов
+ * \param pairs Пары конфликтующих островов
+ * \return Граф со связями обоих видов
+ */
+IslandGraph AddIslandConflicts(const IslandGraph& graph, const std::vector<std::pair<unsigned, unsigned>>& pairs);
+
+/**
+ * \brief Площадь каждого острова в пространстве развертки (1 - вся текстура)
+ *
+ * \details Площадь полигона - по формуле шнурования (для невыпуклых полигонов - по модулю суммы), полигоны без
+ * текстурных координат не учитываются. Острова обрабатываются параллельно. Определена для uint16_t, uint32_t и
+ * uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param groups Острова
+ * \param texCoords Текстурные координаты
+ * \param pool Пул потоков
+ * \return Площади
+ */
+template<typename Index>
+std::vector<float> IslandUvAreas(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& texCoords,
+                                 ThreadPool& pool);
+
+/**
+ * \brief Параметры слияния мелких островов
+ */
+struct IslandMergeSettings
+{
+    /// Остров мелкий, если полигонов в нем не больше (0 - не учитывается)
+    unsigned maxFaces = 0;
+    /// Остров мелкий, если его площадь развертки меньше (0 - не учитывается)
+    float maxUvArea = 0.0f;
+    /// Наибольший угол между нормалями полигонов объединенного острова, градусов (0 - не ограничен)
+    float maxNormalAngle = 0.0f;
+};
+
+/**
+ * \brief Результат слияния островов
+ */
+struct IslandMerge
+{
+    /// Новые группы (объединенный остров занимает место того, к которому присоединены мелкие)
+    GroupMembers groups;
+    /// Кол-во сохранившихся групп перед каждой исходной (последний элемент - общее кол-во новых групп)
+    std::vector<unsigned> firstKept;
+    /// Кол-во присоединенных к соседям островов
+    unsigned mergedCount = 0;
+};
+
+/**
+ * \brief Присоединить мелкие острова к соседним
+ *
+ * \details Мелкие острова обрабатываются жадно, от самых мелких: остров присоединяется к соседу с наибольшим кол-вом
+ * общих ребер, если объединение остается в пределах угла между нормалями (нормали каждого объединенного острова
+ * хранятся в виде охватывающего конуса, объединение допустимо, если половина раствора конуса не больше половины
+ * угла) и сосед относится к тому же объекту. Остров, выросший выше порога, больше не присоединяется. Конусы
+ * исходных островов считаются параллельно
+ *
+ * \param groups Острова
+ * \param graph Граф смежности островов
+ * \param settings Параметры слияния
+ * \param faceNormals Нормали полигонов (нужны, если угол ограничен)
+ * \param uvAreas Площади развертки островов (нужны, если задан порог площади)
+ * \param objectOf Объект каждого острова (пусто - острова без объектов)
+ * \param pool Пул потоков
+ * \return Новые группы (выделяются из источника памяти исходных групп)
+ */
+IslandMerge MergeSmallIslands(const GroupMembers& groups, const IslandGraph& graph, const IslandMergeSettings& settings,
+                              const Coordinates& faceNormals, const std::vector<float>& uvAreas,
+                              const std::vector<unsigned>& objectOf, ThreadPool& pool);
+
+/**
+ * \brief Результат раскраски островов
+ */
+struct IslandColoring
+{
+    /// Цвет (новая группа) каждого острова, цвета объекта идут подряд
+    std::vector<unsigned> colors;
+    /// Кол-во цветов
+    unsigned colorCount = 0;
+};
+
+/**
+ * \brief Раскрасить граф смежности островов (DSATUR), чтобы несмежные острова могли делить один материал
+ *
+ * \details Первым раскрашивается остров с наибольшим кол-вом разных цветов соседей (затем - с наибольшим кол-вом
+ * соседей) в наименьший цвет, не занятый соседями. Цвета соседей каждого острова хранятся битовым множеством. Если
+ * угол ограничен, нормали всех островов цвета должны помещаться в конус с половиной раствора не больше половины
+ * угла, иначе берется следующий цвет. Острова разных объектов раскрашиваются независимо и параллельно
+ *
+ * \param groups Острова
+ * \param graph Граф смежности островов
+ * \param maxNormalAngle Наибольший угол между нормалями полигонов одного цвета, градусов (0 - не ограничен)
+ * \param faceNormals Нормали полигонов (нужны, если угол ограничен)
+ * \param objectOf Объект каждого острова (пусто - острова без объектов, острова объекта идут подряд)
+ * \param pool Пул потоков
+ * \return Цвета островов
+ */
+IslandColoring ColorIslands(const GroupMembers& groups, const IslandGraph& graph, float maxNormalAngle,
+                            const Coordinates& faceNormals, const std::vector<unsigned>& objectOf, ThreadPool& pool);
+
+/**
+ * \brief Объединить острова с одинаковыми метками в группы
+ *
+ * \details Группа l - все острова с меткой l, полигоны группы из нескольких островов упорядочены по возрастанию.
+ * Группы заполняются параллельно
+ *
+ * \param groups Острова
+ * \param labels Метка (номер новой группы) каждого острова
+ * \param labelCount Кол-во меток
+ * \param pool Пул потоков
+ * \return Новые группы (выделяются из источника памяти исходных групп)
+ */
+GroupMembers UniteIslands(const GroupMembers& groups, const std::vector<unsigned>& labels, unsigned labelCount, ThreadPool& pool);
+
+/**
+ * \brief Результат разбиения островов на ограниченное кол-во групп
+ */
+struct IslandPartition
+{
+    /// Группа каждого острова, группы объекта идут подряд
+    std::vector<unsigned> labels;
+    /// Кол-во групп (больше ограничения, если его нельзя выдержать без нарушения правила нормалей)
+    unsigned groupCount = 0;
+    /// Наибольший раствор конуса нормалей группы из нескольких островов, градусов
+    float maxSpread = 0.0f;
+};
+
+/**
+ * \brief Разбить острова не больше чем на заданное кол-во групп с наименьшим разбросом нормалей в группе
+ *
+ * \details Ограничение делится между объектами пропорционально кол-ву островов (не меньше одной группы на объект).
+ * Острова объекта группируются сферическим k-средних по средним нормалям островов (с весом по кол-ву полигонов):
+ * начальные центры - наиболее удаленные друг от друга оси, острова распределяются к ближайшему центру параллельно.
+ * Если угол ограничен, острова групп, конус нормалей которых шире половины угла, заново раскладываются по группам
+ * (в первую подходящую, иначе - в новую), поэтому групп может стать больше ограничения
+ *
+ * \param groups Острова
+ * \param maxGroups Наибольшее кол-во групп
+ * \param maxNormalAngle Наибольший угол между нормалями полигонов группы, градусов (0 - не ограничен)
+ * \param faceNormals Нормали полигонов
+ * \param objectOf Объект каждого острова (пусто - острова без объектов, острова объекта идут подряд)
+ * \param pool Пул потоков
+ * \return Группы островов
+ */
+IslandPartition PartitionIslands(const GroupMembers& groups, unsigned maxGroups, float maxNormalAngle,
+                                 const Coordinates& faceNormals, const std::vector<unsigned>& objectOf, ThreadPool& pool);
+
+/**
+ * \brief Классы островов с одинаковой разверткой
+ */
+struct IslandDuplicates
+{
+    /// Класс каждого острова (первый остров с такой же разверткой)
+    std::vector<unsigned> classOf;
+    /// Кол-во классов из нескольких островов
+    unsigned repeatedShapes = 0;
+    /// Кол-во островов в таких классах
+    unsigned repeatedIslands = 0;
+};
+
+/**
+ * \brief Найти острова с одинаковой (с точностью до сдвига, поворота и отражения) разверткой
+ *
+ * \details Каждый полигон острова описывается кол-вом вершин, площадью и периметром в развертке и расстоянием от его
+ * центра до центра острова (величины округляются до 1/10000 текстуры и не зависят от сдвига, поворота и отражения).
+ * Связность описывается общими ребрами полигонов (одинаковые пары текстурных координат): длиной ребра и описаниями
+ * обоих полигонов, поэтому острова из тех же полигонов в другом расположении различаются. Упорядоченные описания
+ * полигонов и ребер острова и их хеш считаются параллельно. Острова одного объекта с одинаковым хешем сравниваются
+ * по обоим спискам описаний полностью. Определена для uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param groups Острова
+ * \param texCoords Текстурные координаты
+ * \param objectOf Объект каждого острова (пусто - острова без объектов)
+ * \param pool Пул потоков
+ * \return Классы островов
+ */
+template<typename Index>
+IslandDuplicates FindDuplicateIslands(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& texCoords,
+                                      const std::vector<unsigned>& objectOf, ThreadPool& pool);
+
+/**
+ * \brief Объединить острова с одинаковой разверткой в общие группы
+ *
+ * \details Если угол ограничен, острова класса раскладываются по группам в первую, конус нормалей которой вместе
+ * с нормалями острова не шире половины угла (например, отраженные половины модели с расходящимися нормалями
+ * остаются в разных группах)
+ *
+ * \param groups Острова
+ * \param duplicates Классы островов (FindDuplicateIslands)
+ * \param maxNormalAngle Наибольший угол между нормалями полигонов группы, градусов (0 - не ограничен)
+ * \param faceNormals Нормали полигонов (нужны, если угол ограничен)
+ * \param pool Пул потоков
+ * \return Группы островов (в порядке первого острова)
+ */
+IslandPartition ShareDuplicateIslands(const GroupMembers& groups, const IslandDuplicates& duplicates, float maxNormalAngle,
+                                      const Coordinates& faceNormals, ThreadPool& pool);
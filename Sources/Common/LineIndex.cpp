@@ -0,0 +1,298 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Индекс строк .obj файла.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "LineIndex.h"
+
+#include "Cpu.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+// Векторные ядра - только для x86-64 (SED_LINE_INDEX_X86 из Cpu.h)
+#if defined(SED_LINE_INDEX_X86)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SED_TARGET(isa)
+#else
+#define SED_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace
+{
+    /// Минимальный размер фрагмента при параллельной обработке (байт)
+    const size_t MIN_CHUNK_SIZE = 1u << 20u;
+
+    /**
+     * \brief Реализации ядер поиска переводов строки для одного набора инструкций
+     */
+    struct NewlineKernels
+    {
+        /// Кол-во переводов строки в диапазоне
+        size_t (*count)(const char* p, const char* end);
+        /// Записать позиции после каждого перевода строки (отсчет от data), вернуть конец записанного
+        size_t* (*find)(const char* data, const char* p, const char* end, size_t* out);
+    };
+
+    /**
+     * \brief Кол-во установленных битов (без POPCNT)
+     */
+    inline size_t BitCount(uint64_t mask)
+    {
+        return std::bitset<64>(mask).count();
+    }
+
+    size_t CountNewlinesScalar(const char* p, const char* end)
+    {
+        return static_cast<size_t>(std::count(p, end, '\n'));
+    }
+
+    size_t* FindNewlinesScalar(const char* data, const char* p, const char* end, size_t* out)
+    {
+        for(; p < end; p++)
+        {
+            if(*p == '\n') *out++ = static_cast<size_t>(p - data) + 1;
+        }
+        return out;
+    }
+
+#if defined(SED_LINE_INDEX_X86)
+    /**
+     * \brief Номер младшего установленного бита (маска не нулевая)
+     */
+    inline unsigned LowestBit(uint64_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+    }
+
+    SED_TARGET("sse2")
+    size_t CountNewlinesSSE2(const char* p, const char* end)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+        size_t count = 0;
+        for(; end - p >= 16; p += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            count += BitCount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline))));
+        }
+        return count + CountNewlinesScalar(p, end);
+    }
+
+    SED_TARGET("sse2")
+    size_t* FindNewlinesSSE2(const char* data, const char* p, const char* end, size_t* out)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+        for(; end - p >= 16; p += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+            const size_t base = static_cast<size_t>(p - data) + 1;
+            for(; mask != 0; mask &= mask - 1) *out++ = base + LowestBit(mask);
+        }
+        return FindNewlinesScalar(data, p, end, out);
+    }
+
+    // SSE4.2 отличается от SSE2 только аппаратным подсчетом битов (POPCNT)
+    SED_TARGET("sse4.2,popcnt")
+    size_t CountNewlinesSSE42(const char* p, const char* end)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+        size_t count = 0;
+        for(; end - p >= 16; p += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            count += static_cast<size_t>(_mm_popcnt_u32(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)))));
+        }
+        return count + CountNewlinesScalar(p, end);
+    }
+
+    SED_TARGET("avx2,popcnt")
+    size_t CountNewlinesAVX2(const char* p, const char* end)
+    {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        size_t count = 0;
+        for(; end - p >= 32; p += 32)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            count += static_cast<size_t>(_mm_popcnt_u32(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)))));
+        }
+        return count + CountNewlinesScalar(p, end);
+    }
+
+    SED_TARGET("avx2")
+    size_t* FindNewlinesAVX2(const char* data, const char* p, const char* end, size_t* out)
+    {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        for(; end - p >= 32; p += 32)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+            const size_t base = static_cast<size_t>(p - data) + 1;
+            for(; mask != 0; mask &= mask - 1) *out++ = base + LowestBit(mask);
+        }
+        return FindNewlinesScalar(data, p, end, out);
+    }
+
+    SED_TARGET("avx512f,avx512bw,popcnt")
+    size_t CountNewlinesAVX512(const char* p, const char* end)
+    {
+        const __m512i newline = _mm512_set1_epi8('\n');
+        size_t count = 0;
+        for(; end - p >= 64; p += 64)
+        {
+            const __m512i block = _mm512_loadu_si512(reinterpret_cast<const void*>(p));
+            count += static_cast<size_t>(_mm_popcnt_u64(_mm512_cmpeq_epi8_mask(block, newline)));
+        }
+        return count + CountNewlinesScalar(p, end);
+    }
+
+    SED_TARGET("avx512f,avx512bw")
+    size_t* FindNewlinesAVX512(const char* data, const char* p, const char* end, size_t* out)
+    {
+        const __m512i newline = _mm512_set1_epi8('\n');
+        for(; end - p >= 64; p += 64)
+        {
+            const __m512i block = _mm512_loadu_si512(reinterpret_cast<const void*>(p));
+            uint64_t mask = _mm512_cmpeq_epi8_mask(block, newline);
+            const size_t base = static_cast<size_t>(p - data) + 1;
+            for(; mask != 0; mask &= mask - 1) *out++ = base + LowestBit(mask);
+        }
+        return FindNewlinesScalar(data, p, end, out);
+    }
+#endif
+
+    /**
+     * \brief Реализации ядер для набора инструкций (наиболее широкие, не превышающие его)
+     * \param isa Набор инструкций
+     * \return Ядра
+     */
+    NewlineKernels SelectNewlineKernels(InstructionSet isa)
+    {
+#if defined(SED_LINE_INDEX_X86)
+        switch(isa)
+        {
+            case eIsaAVX512:
+                return {CountNewlinesAVX512, FindNewlinesAVX512};
+            case eIsaAVX2:
+                return {CountNewlinesAVX2, FindNewlinesAVX2};
+            case eIsaSSE42:
+                return {CountNewlinesSSE42, FindNewlinesSSE2};
+            case eIsaSSE2:
+                return {CountNewlinesSSE2, FindNewlinesSSE2};
+            default:
+                break;
+        }
+#endif
+        (void)isa;
+        return {CountNewlinesScalar, FindNewlinesScalar};
+    }
+
+    /**
+     * \brief Разделить содержимое на фрагменты (по границам строк)
+     * \param data Содержимое
+     * \param size Размер содержимого
+     * \param pool Пул потоков
+     * \return Границы фрагментов (первая - 0, последняя - size)
+     */
+    std::vector<size_t> SplitChunks(const char* data, size_t size, ThreadPool& pool)
+    {
+        // Каждая граница сдвигается на начало следующей строки
+        const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(pool.threadCount() * 4, size / MIN_CHUNK_SIZE));
+        std::vector<size_t> bounds(chunkCount + 1, size);
+        bounds[0] = 0;
+        for(size_t c = 1; c < chunkCount; c++)
+        {
+            size_t pos = std::max(bounds[c - 1], size / chunkCount * c);
+            const void* newline = pos < size ? std::memchr(data + pos, '\n', size - pos) : nullptr;
+            bounds[c] = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+        }
+        return bounds;
+    }
+}
+
+LineType ClassifyLine(const char* line, size_t length)
+{
+    length = TrimLineLength(line, length);
+    if(length == 0) return eLineOther;
+
+    switch(line[0])
+    {
+        case 'f':
+            return length == 1 || line[1] == ' ' ? eLineFace : eLineOther;
+        case 'v':
+            if(length >= 2 && line[1] == ' ') return eLinePosition;
+            if(length >= 3 && line[2] == ' ' && line[1] == 't') return eLineTexCoord;
+            if(length >= 3 && line[2] == ' ' && line[1] == 'n') return eLineNormal;
+            return eLineOther;
+        case 'u':
+            return length >= 6 && std::memcmp(line, "usemtl", 6) == 0 ? eLineUseMtl : eLineOther;
+        case 'm':
+            return length >= 6 && std::memcmp(line, "mtllib", 6) == 0 ? eLineMtlLib : eLineOther;
+        case '#':
+            return eLineComment;
+        case 'o':
+        case 'g':
+            return length == 1 || line[1] == ' ' ? eLineObject : eLineOther;
+        case 's':
+            return length >= 2 && line[1] == ' ' ? eLineSmoothing : eLineOther;
+        default:
+            return eLineOther;
+    }
+}
+
+LineIndex BuildLineIndex(const char* data, size_t size, ThreadPool& pool)
+{
+    const std::vector<size_t> bounds = SplitChunks(data, size, pool);
+    const size_t chunkCount = bounds.size() - 1;
+    const NewlineKernels kernels = SelectNewlineKernels(ActiveInstructionSet());
+
+    // Кол-во строк, начинающихся после переводов строки каждого фрагмента (первая строка - перед всеми)
+    std::vector<size_t> counts(chunkCount + 1, 0);
+    counts[0] = 1;
+    pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+        counts[c + 1] = kernels.count(data + bounds[c], data + bounds[c + 1]);
+    });
+
+    // Начала строк каждого фрагмента пишутся сразу на свои места (массив точного размера)
+    LineIndex index;
+    index.chunkLines.resize(chunkCount + 1);
+    for(size_t c = 0; c < chunkCount; c++) counts[c + 1] += counts[c];
+    const size_t lineCount = counts[chunkCount];
+
+    index.starts.resize(lineCount + 1);
+    index.starts[0] = 0;
+    index.starts[lineCount] = size + 1;
+    pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+        kernels.find(data, data + bounds[c], data + bounds[c + 1], index.starts.data() + counts[c]);
+    });
+
+    // Фрагменту принадлежат строки, начинающиеся в его границах (строка после завершающего перевода - последнему)
+    for(size_t c = 0; c < chunkCount; c++)
+    {
+        index.chunkLines[c] = static_cast<size_t>(std::lower_bound(index.starts.begin(), index.starts.begin() + lineCount, bounds[c]) - index.starts.begin());
+    }
+    index.chunkLines[0] = 0;
+    index.chunkLines[chunkCount] = lineCount;
+
+    // Типы строк
+    index.types.resize(lineCount);
+    pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+        for(size_t i = index.chunkLines[c]; i < index.chunkLines[c + 1]; i++)
+        {
+            index.types[i] = ClassifyLine(data + index.starts[i], index.lineEnd(i) - index.starts[i]);
+        }
+    });
+
+    return index;
+}
@@ -0,0 +1,96 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Индекс строк .obj файла.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ThreadPool.h"
+
+/**
+ * \brief Тип строки .obj файла (по началу строки)
+ */
+enum LineType : uint8_t
+{
+    // Прочие строки
+    eLineOther,
+    // Полигон ("f ", в том числе "f" без вершин)
+    eLineFace,
+    // Положение вершины ("v ")
+    eLinePosition,
+    // Текстурные координаты ("vt ")
+    eLineTexCoord,
+    // Нормаль ("vn ")
+    eLineNormal,
+    // Материал ("usemtl")
+    eLineUseMtl,
+    // Библиотека материалов ("mtllib")
+    eLineMtlLib,
+    // Комментарий ("#")
+    eLineComment,
+    // Начало объекта либо группы ("o ", "g ")
+    eLineObject,
+    // Группа сглаживания ("s ")
+    eLineSmoothing,
+    // Полигон, первая вершина которого не соответствует формату файла (отмечается при ScanObjFile и пропускается)
+    eLineSkippedFace
+};
+
+/**
+ * \brief Индекс строк - начала и типы всех строк содержимого
+ *
+ * \details Строки разделяются символом перевода строки, последняя строка (даже пустая) тоже учитывается. Строки
+ * поделены на фрагменты (по границам строк) для параллельной обработки
+ */
+struct LineIndex
+{
+    /// Начала строк (последний элемент - размер содержимого + 1, конец строки i - starts[i + 1] - 1)
+    std::vector<size_t> starts;
+    /// Типы строк
+    std::vector<LineType> types;
+    /// Первая строка каждого фрагмента (последний элемент - кол-во строк)
+    std::vector<size_t> chunkLines;
+
+    [[nodiscard]] size_t lineCount() const { return types.size(); }
+    [[nodiscard]] size_t chunkCount() const { return chunkLines.size() - 1; }
+    [[nodiscard]] size_t lineBegin(size_t i) const { return starts[i]; }
+    [[nodiscard]] size_t lineEnd(size_t i) const { return starts[i + 1] - 1; }
+};
+
+/**
+ * \brief Определить тип строки
+ * \param line Начало строки
+ * \param length Длина строки (завершающий "\r" строк CRLF не учитывается)
+ * \return Тип
+ */
+LineType ClassifyLine(const char* line, size_t length);
+
+/**
+ * \brief Длина строки без завершающего "\r" (строки файлов с переводами строк CRLF)
+ * \param line Начало строки
+ * \param length Длина строки
+ * \return Длина без "\r"
+ */
+inline size_t TrimLineLength(const char* line, size_t length)
+{
+    return length > 0 && line[length - 1] == '\r' ? length - 1 : length;
+}
+
+/**
+ * \brief Построить индекс строк содержимого .obj файла
+ *
+ * \details Содержимое делится на фрагменты, в каждом фрагменте переводы строк ищутся векторным ядром для
+ * ActiveInstructionSet() (AVX-512, AVX2, SSE4.2, SSE2 либо побайтно), затем строки классифицируются по началу.
+ * Векторизован только поиск переводов строк: тип строки определяется скалярно (ClassifyLine) по первым нескольким
+ * символам, параллельно по фрагментам
+ *
+ * \param data Содержимое файла
+ * \param size Размер содержимого
+ * \param pool Пул потоков
+ * \return Индекс
+ */
+LineIndex BuildLineIndex(const char* data, size_t size, ThreadPool& pool);
@@ -0,0 +1,194 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Общие структуры данных меша.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory_resource>
+
+/**
+ * \brief Разрядность индексов вершин (положение, UV, нормаль) в меше
+ */
+enum IndexWidth
+{
+    // 16 бит - небольшие модели, вдвое меньше памяти
+    eIndex16,
+    // 32 бита - исходный формат
+    eIndex32,
+    // 64 бита - индексы, не помещающиеся в 32 бита
+    eIndex64
+};
+
+/**
+ * \brief Формат вершин в строках полигонов ("f ...")
+ */
+enum FaceLayout
+{
+    // "v" - только положение
+    eFacePosition,
+    // "v/vt" - положение и текстурные координаты
+    eFacePositionUv,
+    // "v//vn" - положение и нормаль
+    eFacePositionNormal,
+    // "v/vt/vn" - все три индекса
+    eFacePositionUvNormal
+};
+
+/**
+ * \brief Разрядность типа индексов
+ */
+template<typename Index>
+constexpr IndexWidth IndexWidthOf()
+{
+    return sizeof(Index) <= sizeof(uint16_t) ? eIndex16 : sizeof(Index) <= sizeof(uint32_t) ? eIndex32 : eIndex64;
+}
+
+/**
+ * \brief Структура описывающая вершину
+ *
+ * \details Основной критений сравнения вершин - положение и текстурные координаты. Не обязательно хранить сами данные,
+ * достаточно значть что индексы положения и текстурных координат совпадают
+ *
+ * \tparam Index Тип индексов (uint16_t, uint32_t либо uint64_t)
+ */
+template<typename Index>
+struct BasicVertex
+{
+    Index posIdx = 0;
+    Index uvIdx = 0;
+    Index normalIdx = 0;
+
+    bool operator==(const BasicVertex& v) const{
+        return this->posIdx == v.posIdx && this->uvIdx == v.uvIdx;
+    }
+
+    struct Hash
+    {
+        size_t operator()(const BasicVertex& v) const{
+            return std::hash<std::string>()(std::to_string(v.posIdx) + std::to_string(v.uvIdx));
+        }
+    };
+};
+
+/**
+ * \brief Полигон - непрерывный диапазон вершин внутри меша
+ */
+template<typename Index>
+struct BasicPolygonView
+{
+    const BasicVertex<Index>* first = nullptr;
+    const BasicVertex<Index>* last = nullptr;
+
+    [[nodiscard]] const BasicVertex<Index>* begin() const { return first; }
+    [[nodiscard]] const BasicVertex<Index>* end() const { return last; }
+    [[nodiscard]] size_t size() const { return static_cast<size_t>(last - first); }
+    [[nodiscard]] bool empty() const { return first == last; }
+};
+
+/**
+ * \brief Меш - набор полигонов
+ *
+ * \details Вершины всех полигонов хранятся в одном массиве подряд (CSR), полигон задается смещением своей первой
+ * вершины. Это избавляет от отдельного вектора на каждый полигон. Смещения и номера полигонов 32-битные при любой
+ * разрядности индексов вершин
+ *
+ * \tparam Index Тип индексов вершин (uint16_t, uint32_t либо uint64_t)
+ */
+template<typename Index>
+struct BasicMesh
+{
+    using IndexType = Index;
+    using VertexType = BasicVertex<Index>;
+
+    /// Вершины всех полигонов
+    std::pmr::vector<VertexType> vertices;
+    /// Смещения начала полигонов (последний элемент - общее кол-во вершин, не больше 2^32 - 1: файлы с большим
+    /// кол-вом вершин полигонов обрабатываются во внешней памяти)
+    std::pmr::vector<unsigned> faceOffsets;
+    /// Формат вершин исходных строк полигонов (отсутствующие индексы равны 0, при выводе сохраняется тот же формат)
+    FaceLayout faceLayout = eFacePositionUvNormal;
+
+    BasicMesh() : BasicMesh(std::pmr::get_default_resource())
+    {}
+
+    /**
+     * \brief Создать пустой меш, память которого выделяется из заданного источника (например, Arena)
+     * \param resource Источник памяти
+     */
+    explicit BasicMesh(std::pmr::memory_resource* resource) : vertices(resource), faceOffsets(1, 0, resource)
+    {}
+
+    /**
+     * \brief Источник памяти меша (результаты обработки меша выделяются из него же)
+     */
+    [[nodiscard]] std::pmr::memory_resource* resource() const
+    {
+        return vertices.get_allocator().resource();
+    }
+
+    [[nodiscard]] unsigned faceCount() const
+    {
+        return static_cast<unsigned>(faceOffsets.size() - 1);
+    }
+
+    [[nodiscard]] BasicPolygonView<Index> polygon(const unsigned faceIdx) const
+    {
+        return {vertices.data() + faceOffsets[faceIdx], vertices.data() + faceOffsets[faceIdx + 1]};
+    }
+
+    void addVertex(const VertexType& v)
+    {
+        vertices.push_back(v);
+    }
+
+    void closePolygon()
+    {
+        faceOffsets.push_back(static_cast<unsigned>(vertices.size()));
+    }
+
+    void clear()
+    {
+        vertices.clear();
+        faceOffsets.assign(1, 0);
+    }
+};
+
+using Vertex = BasicVertex<uint32_t>;
+using PolygonView = BasicPolygonView<uint32_t>;
+using Mesh = BasicMesh<uint32_t>;
+using Mesh16 = BasicMesh<uint16_t>;
+using Mesh32 = BasicMesh<uint32_t>;
+using Mesh64 = BasicMesh<uint64_t>;
+
+/**
+ * \brief Перевести меш в другую разрядность индексов (индексы должны помещаться в новый тип)
+ * \param mesh Исходный меш
+ * \return Меш с индексами типа To (память из источника исходного меша)
+ */
+template<typename To, typename From>
+BasicMesh<To> ConvertMesh(const BasicMesh<From>& mesh)
+{
+    BasicMesh<To> result(mesh.resource());
+    result.faceLayout = mesh.faceLayout;
+    result.faceOffsets.assign(mesh.faceOffsets.begin(), mesh.faceOffsets.end());
+    result.vertices.resize(mesh.vertices.size());
+    for(size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        result.vertices[i].posIdx = static_cast<To>(mesh.vertices[i].posIdx);
+        result.vertices[i].uvIdx = static_cast<To>(mesh.vertices[i].uvIdx);
+        result.vertices[i].normalIdx = static_cast<To>(mesh.vertices[i].normalIdx);
+    }
+    return result;
+}
+
+/**
+ * \brief Строки текста (например, основная информация .obj файла)
+ *
+ * \details Строки выделяются из того же источника памяти, что и сам массив
+ */
+using TextLines = std::pmr::vector<std::pmr::string>;
@@ -0,0 +1,371 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Разделение групп по углу между нормалями.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "NormalSplit.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace
+{
+    /// Признак полигона, еще не вошедшего ни в одну часть
+    const unsigned NO_PART = ~0u;
+
+    /// Наибольшее кол-во попарных сравнений нормалей при проверке правила для одной группы
+    const size_t PAIR_CHECK_LIMIT = size_t(1) << 24u;
+
+    /// Допуск при сравнении косинусов и углов (погрешность нормалей)
+    const float COS_EPSILON = 1e-5f;
+    const float ANGLE_EPSILON = 1e-4f;
+
+    /// Минимальное кол-во групп в диапазоне при параллельной обработке
+    const size_t MIN_CHUNK_GROUPS = 256;
+
+    /**
+     * \brief Ось области (единичный вектор)
+     */
+    struct Axis
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+        /// Задана ли ось (для вырожденных полигонов оси нет)
+        bool valid = false;
+    };
+
+    /**
+     * \brief Конус, содержащий нормали полигонов области
+     */
+    struct Cone
+    {
+        Axis axis;
+        /// Половина раствора (радиан)
+        float angle = 0.0f;
+    };
+
+    inline bool IsZero(const Coordinates& normals, unsigned f)
+    {
+        return normals.x[f] == 0.0f && normals.y[f] == 0.0f && normals.z[f] == 0.0f;
+    }
+
+    inline float Dot(const Coordinates& normals, unsigned f, const Axis& axis)
+    {
+        return normals.x[f] * axis.x + normals.y[f] * axis.y + normals.z[f] * axis.z;
+    }
+
+    inline Axis FaceAxis(const Coordinates& normals, unsigned f)
+    {
+        if(IsZero(normals, f)) return {};
+        return {normals.x[f], normals.y[f], normals.z[f], true};
+    }
+
+    /**
+     * \brief Угол между нормалью полигона и осью (через atan2 - без потери точности acos у близких векторов)
+     * \param normals Нормали полигонов
+     * \param f Полигон
+     * \param axis Ось
+     * \return Угол (радиан)
+     */
+    inline float AngleTo(const Coordinates& normals, unsigned f, const Axis& axis)
+    {
+        const float cx = normals.y[f] * axis.z - normals.z[f] * axis.y;
+        const float cy = normals.z[f] * axis.x - normals.x[f] * axis.z;
+        const float cz = normals.x[f] * axis.y - normals.y[f] * axis.x;
+        return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), Dot(normals, f, axis));
+    }
+
+    /**
+     * \brief Средняя нормаль полигонов (ось не задана, если сумма нулевая)
+     * \param normals Нормали полигонов
+     * \param faces Полигоны
+     * \param count Кол-во полигонов
+     * \return Ось
+     */
+    Axis MeanAxis(const Coordinates& normals, const unsigned* faces, size_t count)
+    {
+        Axis axis;
+        for(size_t i = 0; i < count; i++)
+        {
+            const unsigned f = faces[i];
+            axis.x += normals.x[f];
+            axis.y += normals.y[f];
+            axis.z += normals.z[f];
+        }
+
+        const float length = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+        if(length <= 0.0f) return {};
+        return {axis.x / length, axis.y / length, axis.z / length, true};
+    }
+
+    /**
+     * \brief Итог проверки правила
+     */
+    enum RuleCheck
+    {
+        eRuleMet,
+        eRuleBroken,
+        eRuleUnchecked
+    };
+
+    /**
+     * \brief Удовлетворяет ли группа правилу (нормали не расходятся больше чем на угол)
+     *
+     * \details Если нормали попадают в конус половинного угла вокруг средней, правило выполнено. Иначе сравниваются
+     * пары различных нормалей, упорядоченных по убыванию угла до средней: пара, сумма углов которой до средней не
+     * больше угла, правилу не противоречит, поэтому сравнение идет только до такой пары. Если сравнений нужно больше
+     * PAIR_CHECK_LIMIT, группа считается непроверенной
+     *
+     * \param normals Нормали полигонов
+     * \param faces Полигоны группы
+     * \param count Кол-во полигонов
+     * \param cosHalf Косинус половинного угла
+     * \param cosFull Косинус угла
+     * \param radians Угол (радиан)
+     * \return Итог проверки
+     */
+    RuleCheck SatisfiesRule(const Coordinates& normals, const unsigned* faces, unsigned count, float cosHalf, float cosFull,
+                            float radians)
+    {
+        if(count <= 1) return eRuleMet;
+
+        Axis axis = MeanAxis(normals, faces, count);
+        bool inCone = true;
+        for(unsigned i = 0; i < count && inCone; i++)
+        {
+            if(IsZero(normals, faces[i])) continue;
+            inCone = axis.valid && Dot(normals, faces[i], axis) >= cosHalf - COS_EPSILON;
+        }
+        if(inCone) return eRuleMet;
+
+        // Различные нормали (полигоны с одинаковой нормалью сравниваются один раз)
+        std::vector<unsigned> distinct;
+        distinct.reserve(count);
+        for(unsigned i = 0; i < count; i++)
+        {
+            if(!IsZero(normals, faces[i])) distinct.push_back(faces[i]);
+        }
+        std::sort(distinct.begin(), distinct.end(), [&](unsigned a, unsigned b){
+            if(normals.x[a] != normals.x[b]) return normals.x[a] < normals.x[b];
+            if(normals.y[a] != normals.y[b]) return normals.y[a] < normals.y[b];
+            return normals.z[a] < normals.z[b];
+        });
+        distinct.erase(std::unique(distinct.begin(), distinct.end(), [&](unsigned a, unsigned b){
+            return normals.x[a] == normals.x[b] && normals.y[a] == normals.y[b] && normals.z[a] == normals.z[b];
+        }), distinct.end());
+
+        // Угол между нормалями не больше суммы их углов до любой оси (если средней нет - до первой нормали)
+        if(!axis.valid) axis = FaceAxis(normals, distinct.front());
+        std::vector<std::pair<float, unsigned>> byAngle(distinct.size());
+        for(size_t i = 0; i < distinct.size(); i++) byAngle[i] = {AngleTo(normals, distinct[i], axis), distinct[i]};
+        std::sort(byAngle.begin(), byAngle.end(), std::greater<>());
+
+        size_t checks = 0;
+        for(size_t i = 0; i + 1 < byAngle.size() && byAngle[i].first + byAngle[i + 1].first > radians; i++)
+        {
+            const Axis a = FaceAxis(normals, byAngle[i].second);
+            for(size_t j = i + 1; j < byAngle.size() && byAngle[i].first + byAngle[j].first > radians; j++)
+            {
+                if(Dot(normals, byAngle[j].second, a) < cosFull - COS_EPSILON) return eRuleBroken;
+                if(++checks > PAIR_CHECK_LIMIT) return eRuleUnchecked;
+            }
+        }
+        return eRuleMet;
+    }
+
+    /**
+     * \brief Расширить конус области до нормали полигона (наименьший конус, содержащий прежний и нормаль)
+     * \param cone Конус (меняется, только если нормаль помещается)
+     * \param normals Нормали полигонов
+     * \param f Полигон
+     * \param maxAngle Предельная половина раствора (радиан)
+     * \return Помещается ли нормаль в конус с предельным раствором
+     */
+    bool ExtendCone(Cone& cone, const Coordinates& normals, unsigned f, float maxAngle)
+    {
+        // Вырожденный полигон подходит к любой области, первый невырожденный задает ось
+        if(IsZero(normals, f)) return true;
+        if(!cone.axis.valid){
+            cone.axis = FaceAxis(normals, f);
+            cone.angle = 0.0f;
+            return true;
+        }
+
+        const float dot = Dot(normals, f, cone.axis);
+        const float distance = AngleTo(normals, f, cone.axis);
+        if(distance <= cone.angle) return true;
+
+        const float angle = (cone.angle + distance) * 0.5f;
+        if(angle > maxAngle + ANGLE_EPSILON) return false;
+
+        // Ось поворачивается к нормали на разницу растворов
+        Axis side{normals.x[f] - dot * cone.axis.x, normals.y[f] - dot * cone.axis.y, normals.z[f] - dot * cone.axis.z, true};
+        const float length = std::sqrt(side.x * side.x + side.y * side.y + side.z * side.z);
+        if(length <= 0.0f) return false;
+
+        const float c = std::cos(angle - cone.angle);
+        const float s = std::sin(angle - cone.angle) / length;
+        cone.axis = {cone.axis.x * c + side.x * s, cone.axis.y * c + side.y * s, cone.axis.z * c + side.z * s, true};
+        cone.angle = angle;
+        return true;
+    }
+
+    /**
+     * \brief Разделить группу на связные части наращиванием областей
+     * \param mesh Меш
+     * \param faces Полигоны группы
+     * \param count Кол-во полигонов
+     * \param normals Нормали полигонов
+     * \param halfAngle Половина угла (радиан)
+     * \param parts Номер части каждого полигона группы (в порядке появления первого полигона части)
+     * \return Кол-во частей
+     */
+    template<typename Index>
+    unsigned SplitGroup(const BasicMesh<Index>& mesh, const unsigned* faces, unsigned count, const Coordinates& normals,
+                        float halfAngle, unsigned* parts)
+    {
+        // Вершины группы, упорядоченные по ключу (положение + UV) - полигоны с общим ключом соседствуют
+        struct Entry
+        {
+            Index pos;
+            Index uv;
+            unsigned face;
+        };
+        std::vector<Entry> entries;
+        std::vector<unsigned> faceEntries(count + 1, 0);
+        for(unsigned f = 0; f < count; f++)
+        {
+            for(const auto& v : mesh.polygon(faces[f])) entries.push_back({v.posIdx, v.uvIdx, f});
+            faceEntries[f + 1] = static_cast<unsigned>(entries.size());
+        }
+
+        std::vector<unsigned> order(entries.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b){
+            return entries[a].pos != entries[b].pos ? entries[a].pos < entries[b].pos : entries[a].uv < entries[b].uv;
+        });
+
+        // Ключ каждой вершины и начало каждого ключа в упорядоченном списке
+        std::vector<unsigned> keyOf(entries.size()), keyStart;
+        for(size_t i = 0; i < order.size(); i++)
+        {
+            const Entry& e = entries[order[i]];
+            if(i == 0 || e.pos != entries[order[i - 1]].pos || e.uv != entries[order[i - 1]].uv) keyStart.push_back(static_cast<unsigned>(i));
+            keyOf[order[i]] = static_cast<unsigned>(keyStart.size() - 1);
+        }
+        keyStart.push_back(static_cast<unsigned>(order.size()));
+
+        std::fill(parts, parts + count, NO_PART);
+
+        // Область от seed по соседям, не вошедшим в другие части, пока нормали помещаются в конус с половиной угла
+        unsigned partCount = 0;
+        std::vector<unsigned> region;
+        for(unsigned seed = 0; seed < count; seed++)
+        {
+            if(parts[seed] != NO_PART) continue;
+
+            Cone cone;
+            ExtendCone(cone, normals, faces[seed], halfAngle);
+            parts[seed] = partCount;
+            region.assign(1, seed);
+
+            for(size_t head = 0; head < region.size(); head++)
+            {
+                const unsigned f = region[head];
+                for(unsigned e = faceEntries[f]; e < faceEntries[f + 1]; e++)
+                {
+                    const unsigned key = keyOf[e];
+                    for(unsigned k = keyStart[key]; k < keyStart[key + 1]; k++)
+                    {
+                        const unsigned n = entries[order[k]].face;
+                        if(parts[n] != NO_PART || !ExtendCone(cone, normals, faces[n], halfAngle)) continue;
+                        parts[n] = partCount;
+                        region.push_back(n);
+                    }
+                }
+            }
+
+            partCount++;
+        }
+
+        return partCount;
+    }
+}
+
+template<typename Index>
+NormalSplit SplitGroupsByNormals(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& faceNormals,
+                                 float maxAngle, ThreadPool& pool)
+{
+    const unsigned groupCount = groups.groupCount();
+    const float radians = maxAngle * 3.14159265f / 180.0f;
+    const float cosHalf = std::cos(radians * 0.5f);
+    const float cosFull = std::cos(radians);
+
+    NormalSplit split{GroupMembers(mesh.resource()), {}, 0};
+    split.groups.polygons.resize(groups.polygons.size());
+    split.firstPart.assign(groupCount + 1, 0);
+
+    // Размеры частей группы пишутся на место ее полигонов (частей не больше, чем полигонов)
+    std::vector<unsigned> partSizes(groups.polygons.size(), 0);
+
+    std::atomic<unsigned> uncheckedGroups{0};
+    pool.parallelFor(groupCount, [&](size_t groupBegin, size_t groupEnd){
+        std::vector<unsigned> parts, cursors;
+        unsigned unchecked = 0;
+        for(size_t g = groupBegin; g < groupEnd; g++)
+        {
+            const unsigned begin = groups.offsets[g];
+            const unsigned count = groups.offsets[g + 1] - begin;
+            const unsigned* faces = groups.polygons.data() + begin;
+            unsigned* out = split.groups.polygons.data() + begin;
+            unsigned* sizes = partSizes.data() + begin;
+
+            // Угол от 180 градусов допускает любые нормали
+            const RuleCheck check = maxAngle >= 180.0f ? eRuleMet : SatisfiesRule(faceNormals, faces, count, cosHalf, cosFull, radians);
+            if(check == eRuleMet){
+                std::copy(faces, faces + count, out);
+                sizes[0] = count;
+                split.firstPart[g + 1] = 1;
+                continue;
+            }
+
+            parts.resize(count);
+            const unsigned partCount = SplitGroup(mesh, faces, count, faceNormals, radians * 0.5f, parts.data());
+            if(check == eRuleUnchecked && partCount > 1) unchecked++;
+
+            // Раскладка полигонов по частям (устойчивая - порядок полигонов сохраняется)
+            for(unsigned f = 0; f < count; f++) sizes[parts[f]]++;
+            cursors.assign(partCount, 0);
+            for(unsigned p = 1; p < partCount; p++) cursors[p] = cursors[p - 1] + sizes[p - 1];
+            for(unsigned f = 0; f < count; f++) out[cursors[parts[f]]++] = faces[f];
+
+            split.firstPart[g + 1] = partCount;
+        }
+        uncheckedGroups += unchecked;
+    }, MIN_CHUNK_GROUPS);
+    split.uncheckedGroups = uncheckedGroups;
+
+    for(unsigned g = 0; g < groupCount; g++) split.firstPart[g + 1] += split.firstPart[g];
+
+    split.groups.offsets.resize(split.firstPart.back() + 1);
+    split.groups.offsets[0] = 0;
+    for(unsigned g = 0; g < groupCount; g++)
+    {
+        unsigned offset = groups.offsets[g];
+        for(unsigned p = 0; p < split.partCount(g); p++)
+        {
+            offset += partSizes[groups.offsets[g] + p];
+            split.groups.offsets[split.firstPart[g] + p + 1] = offset;
+        }
+    }
+
+    return split;
+}
+
+template NormalSplit SplitGroupsByNormals(const Mesh16&, const GroupMembers&, const Coordinates&, float, ThreadPool&);
+template NormalSplit SplitGroupsByNormals(const Mesh32&, const GroupMembers&, const Coordinates&, float, ThreadPool&);
+template NormalSplit SplitGroupsByNormals(const Mesh64&, const GroupMembers&, const Coordinates&, float, ThreadPool&);
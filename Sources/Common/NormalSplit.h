@@ -0,0 +1,53 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Разделение групп по углу между нормалями.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "Mesh.h"
+#include "Geometry.h"
+#include "Grouping.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Результат разделения групп по нормалям
+ */
+struct NormalSplit
+{
+    /// Новые группы (части каждой исходной группы идут подряд)
+    GroupMembers groups;
+    /// Первая часть каждой исходной группы (последний элемент - общее кол-во частей)
+    std::vector<unsigned> firstPart;
+    /// Кол-во групп, разделенных без полной проверки правила (слишком много различных нормалей)
+    unsigned uncheckedGroups = 0;
+
+    /**
+     * \brief Кол-во частей исходной группы (больше 1 - группа разделена)
+     */
+    [[nodiscard]] unsigned partCount(unsigned g) const { return firstPart[g + 1] - firstPart[g]; }
+};
+
+/**
+ * \brief Разделить группы так, чтобы угол между нормалями любых двух полигонов группы не превышал заданный
+ *
+ * \details Группа, удовлетворяющая правилу, не меняется. Правило проверяется точно (попарно по различным нормалям,
+ * далеким от средней), кроме групп, которым нужно больше 2^24 сравнений, - такие делятся без проверки. Иначе группа
+ * делится на связные (по общим вершинам) части наращиванием областей: нормали области содержатся в конусе, который
+ * расширяется при присоединении полигона, пока половина раствора не превышает половины угла (тогда любые два
+ * полигона области расходятся не более чем на угол).
+ * Вырожденные полигоны (нулевая нормаль) подходят к любой области. Группы обрабатываются параллельно. Определена
+ * для uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param groups Группы
+ * \param faceNormals Нормали полигонов (ComputeFaceNormals)
+ * \param maxAngle Наибольший угол между нормалями полигонов группы (в градусах)
+ * \param pool Пул потоков
+ * \return Новые группы (выделяются из источника памяти меша)
+ */
+template<typename Index>
+NormalSplit SplitGroupsByNormals(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& faceNormals,
+                                 float maxAngle, ThreadPool& pool);
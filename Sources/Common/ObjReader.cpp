@@ -0,0 +1,620 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Чтение .obj файлов.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "ObjReader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace
+{
+    /**
+     * \brief Пробельный ли символ (как для потоков ввода)
+     */
+    inline bool IsSpace(const char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    /**
+     * \brief Считать модуль и знак числа (без ограничения разрядности индекса)
+     * \param p Текущая позиция (сдвигается)
+     * \param end Конец строки
+     * \param magnitude Модуль числа
+     * \param negative Отрицательное ли число
+     * \param limit Наибольший допустимый модуль
+     * \return Удалось ли считать (модуль не превышает limit)
+     */
+    inline bool ReadMagnitude(const char*& p, const char* end, uint64_t& magnitude, bool& negative, uint64_t limit)
+    {
+        while(p < end && IsSpace(*p)) p++;
+
+        negative = false;
+        if(p < end && (*p == '+' || *p == '-')){
+            negative = *p == '-';
+            p++;
+        }
+
+        if(p >= end || *p < '0' || *p > '9') return false;
+
+        magnitude = 0;
+        while(p < end && *p >= '0' && *p <= '9')
+        {
+            const auto digit = static_cast<uint64_t>(*p - '0');
+            if(magnitude > (limit - digit) / 10) return false;
+            magnitude = magnitude * 10 + digit;
+            p++;
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Перевести индекс в абсолютный
+     *
+     * \details Отрицательный индекс -k ссылается на k-й с конца элемент из прочитанных к этой строке (-1 - последний).
+     * Ссылка за начало файла некорректна. "-0" (некорректный индекс) читается как 0
+     *
+     * \param value Модуль индекса
+     * \param negative Отрицательный ли индекс
+     * \param count Кол-во элементов этого типа, прочитанных до строки полигона
+     * \param out Абсолютный индекс
+     * \return Корректен ли индекс
+     */
+    inline bool ResolveIndex(uint64_t value, bool negative, uint64_t count, uint64_t& out)
+    {
+        if(!negative || value == 0){
+            out = value;
+            return true;
+        }
+
+        if(value > count) return false;
+        out = count - value + 1;
+        return true;
+    }
+
+    /**
+     * \brief Считать индекс типа Index (относительные индексы переводятся в абсолютные)
+     * \param p Текущая позиция (сдвигается)
+     * \param end Конец строки
+     * \param out Индекс
+     * \param count Кол-во элементов этого типа, прочитанных до строки полигона
+     * \return Удалось ли считать (индекс корректен и помещается в Index)
+     */
+    template<typename Index>
+    inline bool ReadIndex(const char*& p, const char* end, Index& out, uint64_t count)
+    {
+        uint64_t value = 0, resolved = 0;
+        bool negative = false;
+        if(!ReadMagnitude(p, end, value, negative, std::numeric_limits<uint64_t>::max())) return false;
+        if(!ResolveIndex(value, negative, count, resolved) || resolved > std::numeric_limits<Index>::max()) return false;
+
+        out = static_cast<Index>(resolved);
+        return true;
+    }
+
+    /**
+     * \brief Считать разделитель индексов вершины ("/")
+     */
+    inline bool SkipSlash(const char*& p, const char* end)
+    {
+        if(p >= end || *p != '/') return false;
+        p++;
+        return true;
+    }
+
+    /**
+     * \brief Считать одну вершину строки полигона в формате Layout
+     * \param p Текущая позиция (сдвигается)
+     * \param end Конец строки
+     * \param counts Кол-во элементов, прочитанных до строки полигона (для относительных индексов)
+     * \param pos Индекс положения
+     * \param uv Индекс текстурных координат (не меняется, если его нет в формате)
+     * \param normal Индекс нормали (не меняется, если его нет в формате)
+     * \param read Чтение одного индекса (позиция, конец, результат, кол-во элементов) -> удалось ли считать
+     * \return Удалось ли считать вершину целиком
+     */
+    template<FaceLayout Layout, typename Component, typename Read>
+    inline bool ReadFaceVertex(const char*& p, const char* end, const ElementCounts& counts, Component& pos, Component& uv,
+                               Component& normal, Read&& read)
+    {
+        if(!read(p, end, pos, counts.positions)) return false;
+
+        if constexpr(Layout == eFacePositionUv || Layout == eFacePositionUvNormal){
+            if(!SkipSlash(p, end) || !read(p, end, uv, counts.texCoords)) return false;
+        }
+        if constexpr(Layout == eFacePositionNormal){
+            if(!SkipSlash(p, end) || !SkipSlash(p, end) || !read(p, end, normal, counts.normals)) return false;
+        }
+        if constexpr(Layout == eFacePositionUvNormal){
+            if(!SkipSlash(p, end) || !read(p, end, normal, counts.normals)) return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Учесть строку элемента (вершины, текстурных координат, нормали) в подсчетах
+     */
+    inline void CountElement(LineType type, ElementCounts& counts)
+    {
+        if(type == eLinePosition) counts.positions++;
+        else if(type == eLineTexCoord) counts.texCoords++;
+        else if(type == eLineNormal) counts.normals++;
+    }
+
+    /**
+     * \brief Кол-во элементов, прочитанных до начала каждого фрагмента индекса строк
+     *
+     * \details Фрагменты считают свои строки параллельно (по типам строк индекса, без разбора текста), затем
+     * префиксная сумма дает начальные значения для разбора относительных индексов в каждом фрагменте
+     *
+     * \param lines Индекс строк
+     * \param pool Пул потоков
+     * \return Подсчеты (на один элемент больше кол-ва фрагментов, последний - итог по файлу)
+     */
+    std::vector<ElementCounts> CountChunkElements(const LineIndex& lines, ThreadPool& pool)
+    {
+        const size_t chunkCount = lines.chunkCount();
+        std::vector<ElementCounts> bases(chunkCount + 1);
+        pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+            for(size_t i = lines.chunkLines[c]; i < lines.chunkLines[c + 1]; i++) CountElement(lines.types[i], bases[c + 1]);
+        });
+
+        for(size_t c = 0; c < chunkCount; c++)
+        {
+            bases[c + 1].positions += bases[c].positions;
+            bases[c + 1].texCoords += bases[c].texCoords;
+            bases[c + 1].normals += bases[c].normals;
+        }
+        return bases;
+    }
+
+    /**
+     * \brief Вызвать fn с форматом вершин в виде константы времени компиляции (для специализированных циклов)
+     */
+    template<typename Fn>
+    inline void WithFaceLayout(FaceLayout layout, Fn&& fn)
+    {
+        switch(layout)
+        {
+            case eFacePosition:
+                fn(std::integral_constant<FaceLayout, eFacePosition>());
+                break;
+            case eFacePositionUv:
+                fn(std::integral_constant<FaceLayout, eFacePositionUv>());
+                break;
+            case eFacePositionNormal:
+                fn(std::integral_constant<FaceLayout, eFacePositionNormal>());
+                break;
+            default:
+                fn(std::integral_constant<FaceLayout, eFacePositionUvNormal>());
+                break;
+        }
+    }
+
+    /**
+     * \brief Есть ли в строке полигона хоть что-то после "f" (по строке без вершин формат не определить)
+     * \param line Начало строки
+     * \param lineEnd Конец строки
+     * \return Да или нет
+     */
+    inline bool HasFaceVertices(const char* line, const char* lineEnd)
+    {
+        const char* p = line + 1;
+        while(p < lineEnd && IsSpace(*p)) p++;
+        return p < lineEnd;
+    }
+
+    /**
+     * \brief Формат вершин первой строки полигона с вершинами в индексе строк
+     * \param data Содержимое файла
+     * \param lines Индекс строк
+     * \return Формат (v/vt/vn, если полигонов нет)
+     */
+    FaceLayout FindFaceLayout(const char* data, const LineIndex& lines)
+    {
+        for(size_t i = 0; i < lines.lineCount(); i++)
+        {
+            const char* line = data + lines.lineBegin(i);
+            const char* lineEnd = data + lines.lineEnd(i);
+            if(lines.types[i] == eLineFace && HasFaceVertices(line, lineEnd)) return DetectFaceLayout(line, lineEnd);
+        }
+        return eFacePositionUvNormal;
+    }
+
+    /**
+     * \brief Относится ли строка к основной информации
+     *
+     * \details Основная информация - все строки файла, где бы они ни находились, кроме полигонов и материалов
+     * (переписываются заново), а также "#" и "mtllib". Строки "o", "g" и "s" относятся к следующим за ними полигонам,
+     * в заголовке они собрали бы все полигоны в последний объект, поэтому тоже не учитываются (при разбиении по
+     * объектам строка "o" пишется перед группами своего объекта)
+     *
+     * \param type Тип строки
+     * \return Да или нет
+     */
+    inline bool IsBaseLine(LineType type)
+    {
+        return type != eLineFace && type != eLineSkippedFace && type != eLineUseMtl && type != eLineMtlLib &&
+               type != eLineComment && type != eLineObject && type != eLineSmoothing;
+    }
+
+    /**
+     * \brief Подсчеты одного фрагмента при предварительном проходе
+     */
+    struct ChunkScan
+    {
+        size_t faces = 0;
+        size_t skippedFaces = 0;
+        size_t faceVertices = 0;
+        size_t baseLines = 0;
+        uint64_t maxIndex = 0;
+    };
+
+    /**
+     * \brief Подсчитать строки полигонов фрагмента и их вершины
+     *
+     * \details Строки "f ..." разбираются так же, как в ReadFaceLine (в формате Layout), но без ограничения разрядности
+     * индексов, поэтому при достаточной разрядности кол-во вершин совпадает с результатом разбора. Строки, в которых
+     * не прочитано ни одной вершины, отмечаются в индексе как eLineSkippedFace
+     *
+     * \param data Содержимое файла
+     * \param lines Индекс строк (типы строк фрагмента могут меняться)
+     * \param chunk Номер фрагмента
+     * \param counts Кол-во элементов, прочитанных до начала фрагмента
+     * \return Подсчеты
+     */
+    template<FaceLayout Layout>
+    ChunkScan ScanChunk(const char* data, LineIndex& lines, size_t chunk, ElementCounts counts)
+    {
+        ChunkScan scan;
+
+        // Абсолютный индекс (наибольший определяет разрядность)
+        auto read = [&](const char*& p, const char* end, uint64_t& value, uint64_t count){
+            uint64_t magnitude = 0;
+            bool negative = false;
+            if(!ReadMagnitude(p, end, magnitude, negative, std::numeric_limits<uint64_t>::max())) return false;
+            if(!ResolveIndex(magnitude, negative, count, value)) return false;
+            scan.maxIndex = std::max(scan.maxIndex, value);
+            return true;
+        };
+
+        for(size_t i = lines.chunkLines[chunk]; i < lines.chunkLines[chunk + 1]; i++)
+        {
+            const LineType type = lines.types[i];
+            if(type == eLineFace)
+            {
+                const char* cursor = data + lines.lineBegin(i) + 1;
+                const char* lineEnd = data + lines.lineEnd(i);
+                uint64_t pos = 0, uv = 0, normal = 0;
+                size_t vertices = 0;
+                while(ReadFaceVertex<Layout>(cursor, lineEnd, counts, pos, uv, normal, read)) vertices++;
+
+                // Пустой полигон (другой формат вершин либо строка без вершин) не создается
+                if(vertices == 0){
+                    lines.types[i] = eLineSkippedFace;
+                    scan.skippedFaces++;
+                }else{
+                    scan.faces++;
+                    scan.faceVertices += vertices;
+                }
+            }
+            else
+            {
+                CountElement(type, counts);
+            }
+
+            if(IsBaseLine(type)) scan.baseLines++;
+        }
+
+        return scan;
+    }
+
+    /**
+     * \brief Пройти по строкам основной информации .obj файла (IsBaseLine)
+     * \param data Содержимое файла
+     * \param size Размер содержимого
+     * \param onLine Обработчик строки (начало, длина)
+     */
+    template<typename Fn>
+    void VisitBaseObjData(const char* data, size_t size, Fn&& onLine)
+    {
+        const char* p = data;
+        const char* end = data + size;
+
+        // Строки разделяются символом перевода строки, последняя строка (даже пустая) тоже учитывается
+        while(true)
+        {
+            const char* lineEnd = p < end ? static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p))) : nullptr;
+            if(!lineEnd) lineEnd = end;
+
+            const size_t length = static_cast<size_t>(lineEnd - p);
+
+            // Передать обработчику строки всего файла, кроме полигонов, материалов и комментариев
+            if(IsBaseLine(ClassifyLine(p, length))) onLine(p, TrimLineLength(p, length));
+
+            if(lineEnd == end) break;
+            p = lineEnd + 1;
+        }
+    }
+
+    /**
+     * \brief Разобрать строку "f ..." в формате Layout
+     * \param line Начало строки
+     * \param lineEnd Конец строки
+     * \param counts Кол-во элементов, прочитанных до строки (для относительных индексов)
+     * \param onVertex Обработчик вершины
+     * \return Является ли строка строкой полигона
+     */
+    template<typename Index, FaceLayout Layout, typename Fn>
+    inline bool ParseFaceLine(const char* line, const char* lineEnd, const ElementCounts& counts, Fn&& onVertex)
+    {
+        // Если строка не начинается с подстроки "f "
+        if(lineEnd - line < 2 || line[0] != 'f' || line[1] != ' ') return false;
+
+        // Читать вершины пока строка не закончится (либо пока вершина соответствует формату)
+        const char* cursor = line + 1;
+        BasicVertex<Index> v;
+        while(ReadFaceVertex<Layout>(cursor, lineEnd, counts, v.posIdx, v.uvIdx, v.normalIdx, ReadIndex<Index>))
+        {
+            onVertex(v);
+        }
+
+        return true;
+    }
+}
+
+FaceLayout DetectFaceLayout(const char* line, const char* lineEnd)
+{
+    // Первая вершина: число, затем "/" (v/vt...), "//" (v//vn) либо ничего (v)
+    const char* p = line + 1;
+    while(p < lineEnd && IsSpace(*p)) p++;
+    if(p < lineEnd && (*p == '+' || *p == '-')) p++;
+    while(p < lineEnd && *p >= '0' && *p <= '9') p++;
+
+    if(!SkipSlash(p, lineEnd)) return eFacePosition;
+    if(SkipSlash(p, lineEnd)) return eFacePositionNormal;
+
+    if(p < lineEnd && (*p == '+' || *p == '-')) p++;
+    while(p < lineEnd && *p >= '0' && *p <= '9') p++;
+    return SkipSlash(p, lineEnd) ? eFacePositionUvNormal : eFacePositionUv;
+}
+
+FaceLayout DetectFaceLayout(const char* data, size_t size)
+{
+    const char* p = data;
+    const char* end = data + size;
+
+    while(p < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if(!lineEnd) lineEnd = end;
+
+        if(ClassifyLine(p, static_cast<size_t>(lineEnd - p)) == eLineFace && HasFaceVertices(p, lineEnd)){
+            return DetectFaceLayout(p, lineEnd);
+        }
+        p = lineEnd + 1;
+    }
+
+    return eFacePositionUvNormal;
+}
+
+template<typename Index>
+bool ReadFaceLine(const char* line, const char* lineEnd, FaceLayout layout, const ElementCounts& counts, BasicMesh<Index>& mesh)
+{
+    bool face = false;
+    const size_t vertexCount = mesh.vertices.size();
+    WithFaceLayout(layout, [&](auto tag){
+        face = ParseFaceLine<Index, decltype(tag)::value>(line, lineEnd, counts, [&](const BasicVertex<Index>& v){ mesh.addVertex(v); });
+    });
+    if(!face || mesh.vertices.size() == vertexCount) return false;
+
+    mesh.closePolygon();
+    return true;
+}
+
+template bool ReadFaceLine(const char*, const char*, FaceLayout, const ElementCounts&, Mesh16&);
+template bool ReadFaceLine(const char*, const char*, FaceLayout, const ElementCounts&, Mesh32&);
+template bool ReadFaceLine(const char*, const char*, FaceLayout, const ElementCounts&, Mesh64&);
+
+IndexWidth ObjScan::indexWidth() const
+{
+    // Относительные индексы учтены уже в абсолютном виде
+    if(maxIndex > std::numeric_limits<uint32_t>::max()) return eIndex64;
+    if(maxIndex > std::numeric_limits<uint16_t>::max()) return eIndex32;
+    return eIndex16;
+}
+
+ObjScan ScanObjFile(const char* data, size_t size, ThreadPool& pool)
+{
+    ObjScan scan;
+    scan.lines = BuildLineIndex(data, size, pool);
+    const size_t chunkCount = scan.lines.chunkCount();
+
+    // Формат вершин определяется по первой строке полигона, остальные строки разбираются в том же формате
+    scan.faceLayout = FindFaceLayout(data, scan.lines);
+
+    // Кол-во элементов до каждого фрагмента (для относительных индексов)
+    scan.chunkElements = CountChunkElements(scan.lines, pool);
+    scan.positions = scan.chunkElements.back().positions;
+    scan.texCoords = scan.chunkElements.back().texCoords;
+    scan.normals = scan.chunkElements.back().normals;
+
+    std::vector<ChunkScan> chunks(chunkCount);
+    WithFaceLayout(scan.faceLayout, [&](auto tag){
+        pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+            chunks[c] = ScanChunk<decltype(tag)::value>(data, scan.lines, c, scan.chunkElements[c]);
+        });
+    });
+
+    scan.chunkFaces.resize(chunkCount);
+    scan.chunkFaceVertices.resize(chunkCount);
+    for(size_t c = 0; c < chunkCount; c++)
+    {
+        const ChunkScan& chunk = chunks[c];
+        scan.chunkFaces[c] = chunk.faces;
+        scan.chunkFaceVertices[c] = chunk.faceVertices;
+        scan.faces += chunk.faces;
+        scan.skippedFaces += chunk.skippedFaces;
+        scan.faceVertices += chunk.faceVertices;
+        scan.baseLines += chunk.baseLines;
+        scan.maxIndex = std::max(scan.maxIndex, chunk.maxIndex);
+    }
+
+    return scan;
+}
+
+template<typename Index>
+void ReadPolygons(const char* data, size_t size, BasicMesh<Index>& mesh, ThreadPool& pool)
+{
+    mesh.clear();
+    if(size == 0) return;
+
+    const LineIndex lines = BuildLineIndex(data, size, pool);
+    const size_t chunkCount = lines.chunkCount();
+
+    mesh.faceLayout = FindFaceLayout(data, lines);
+    const std::vector<ElementCounts> bases = CountChunkElements(lines, pool);
+
+    // Строки полигонов фрагмента (цикл специализирован для формата вершин)
+    auto parseChunk = [&](size_t c, BasicMesh<Index>& target){
+        WithFaceLayout(mesh.faceLayout, [&](auto tag){
+            ElementCounts counts = bases[c];
+            for(size_t i = lines.chunkLines[c]; i < lines.chunkLines[c + 1]; i++)
+            {
+                if(lines.types[i] != eLineFace){
+                    CountElement(lines.types[i], counts);
+                    continue;
+                }
+                const size_t vertexCount = target.vertices.size();
+                ParseFaceLine<Index, decltype(tag)::value>(data + lines.lineBegin(i), data + lines.lineEnd(i), counts,
+                                                           [&](const BasicVertex<Index>& v){ target.addVertex(v); });
+                if(target.vertices.size() > vertexCount) target.closePolygon();
+            }
+        });
+    };
+
+    // Единственный фрагмент разбирается сразу в результирующий меш
+    if(chunkCount == 1){
+        parseChunk(0, mesh);
+        return;
+    }
+
+    // Разбор фрагментов
+    std::vector<BasicMesh<Index>> parts(chunkCount);
+    pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+        parseChunk(c, parts[c]);
+    });
+
+    // Смещения фрагментов в результирующем меше (смещения полигонов 32-битные)
+    std::vector<size_t> vertexBase(chunkCount + 1, 0), faceBase(chunkCount + 1, 0);
+    for(size_t c = 0; c < chunkCount; c++){
+        vertexBase[c + 1] = vertexBase[c] + parts[c].vertices.size();
+        faceBase[c + 1] = faceBase[c] + parts[c].faceCount();
+    }
+    if(vertexBase[chunkCount] > std::numeric_limits<unsigned>::max()){
+        throw std::length_error("Too many polygon vertices for 32-bit polygon offsets.");
+    }
+
+    // Склейка фрагментов
+    mesh.vertices.resize(vertexBase[chunkCount]);
+    mesh.faceOffsets.resize(faceBase[chunkCount] + 1);
+    mesh.faceOffsets[0] = 0;
+    pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+        const BasicMesh<Index>& part = parts[c];
+        std::copy(part.vertices.begin(), part.vertices.end(), mesh.vertices.begin() + vertexBase[c]);
+        for(unsigned f = 0; f < part.faceCount(); f++){
+            mesh.faceOffsets[faceBase[c] + f + 1] = static_cast<unsigned>(vertexBase[c] + part.faceOffsets[f + 1]);
+        }
+    });
+}
+
+template void ReadPolygons(const char*, size_t, Mesh16&, ThreadPool&);
+template void ReadPolygons(const char*, size_t, Mesh32&, ThreadPool&);
+template void ReadPolygons(const char*, size_t, Mesh64&, ThreadPool&);
+
+template<typename Index>
+void ReadPolygons(const char* data, size_t size, const ObjScan& scan, BasicMesh<Index>& mesh, ThreadPool& pool)
+{
+    // Индексы не помещаются в тип - разбор остановится раньше, чем предполагают подсчеты
+    if(IndexWidthOf<Index>() < scan.indexWidth()){
+        ReadPolygons(data, size, mesh, pool);
+        return;
+    }
+
+    // Смещения фрагментов известны заранее, каждый фрагмент пишет сразу в свой участок меша
+    const LineIndex& lines = scan.lines;
+    const size_t chunkCount = lines.chunkCount();
+    std::vector<size_t> vertexBase(chunkCount + 1, 0), faceBase(chunkCount + 1, 0);
+    for(size_t c = 0; c < chunkCount; c++){
+        vertexBase[c + 1] = vertexBase[c] + scan.chunkFaceVertices[c];
+        faceBase[c + 1] = faceBase[c] + scan.chunkFaces[c];
+    }
+
+    if(scan.faceVertices > std::numeric_limits<unsigned>::max()){
+        throw std::length_error("Too many polygon vertices for 32-bit polygon offsets.");
+    }
+    mesh.vertices.resize(scan.faceVertices);
+    mesh.faceOffsets.resize(scan.faces + 1);
+    mesh.faceOffsets[0] = 0;
+
+    mesh.faceLayout = scan.faceLayout;
+
+    WithFaceLayout(scan.faceLayout, [&](auto tag){
+        pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+            BasicVertex<Index>* vertex = mesh.vertices.data() + vertexBase[c];
+            unsigned* offset = mesh.faceOffsets.data() + faceBase[c] + 1;
+            ElementCounts counts = scan.chunkElements[c];
+
+            for(size_t i = lines.chunkLines[c]; i < lines.chunkLines[c + 1]; i++)
+            {
+                if(lines.types[i] != eLineFace){
+                    CountElement(lines.types[i], counts);
+                    continue;
+                }
+                ParseFaceLine<Index, decltype(tag)::value>(data + lines.lineBegin(i), data + lines.lineEnd(i), counts,
+                                                           [&](const BasicVertex<Index>& v){ *vertex++ = v; });
+                *offset++ = static_cast<unsigned>(vertex - mesh.vertices.data());
+            }
+        });
+    });
+}
+
+template void ReadPolygons(const char*, size_t, const ObjScan&, Mesh16&, ThreadPool&);
+template void ReadPolygons(const char*, size_t, const ObjScan&, Mesh32&, ThreadPool&);
+template void ReadPolygons(const char*, size_t, const ObjScan&, Mesh64&, ThreadPool&);
+
+void ReadBaseObjData(const char* data, size_t size, TextLines& lines)
+{
+    // Очистить массив строк
+    lines.clear();
+
+    VisitBaseObjData(data, size, [&](const char* line, size_t length){
+        lines.emplace_back(line, length);
+    });
+}
+
+void ReadBaseObjData(const char* data, const LineIndex& index, TextLines& lines)
+{
+    // Очистить массив строк
+    lines.clear();
+
+    // Строки уже классифицированы, повторный просмотр содержимого не нужен
+    for(size_t i = 0; i < index.lineCount(); i++)
+    {
+        if(!IsBaseLine(index.types[i])) continue;
+        lines.emplace_back(data + index.lineBegin(i), TrimLineLength(data + index.lineBegin(i), index.lineEnd(i) - index.lineBegin(i)));
+    }
+}
+
+void ForEachBaseObjLine(const char* data, size_t size, const std::function<void(const char*, size_t)>& onLine)
+{
+    VisitBaseObjData(data, size, onLine);
+}
@@ -0,0 +1,179 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Чтение .obj файлов.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "LineIndex.h"
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Кол-во элементов (строк "v ", "vt ", "vn "), прочитанных к некоторой строке файла
+ *
+ * \details Нужно для перевода относительных (отрицательных) индексов полигонов в абсолютные
+ */
+struct ElementCounts
+{
+    uint64_t positions = 0;
+    uint64_t texCoords = 0;
+    uint64_t normals = 0;
+};
+
+/**
+ * \brief Считать данные о полигонах (строки "f ...") из содержимого .obj файла
+ *
+ * \details Строится индекс строк, строки полигонов фрагментов индекса разбираются параллельно и затем
+ * склеиваются в исходном порядке. Формат вершин (v, v/vt, v//vn, v/vt/vn) определяется по первой строке полигона,
+ * для остальных строк используется цикл, специализированный для этого формата (строки, в которых в этом формате не
+ * прочитано ни одной вершины, пропускаются, как в ScanObjFile). Относительные (отрицательные) индексы
+ * переводятся в абсолютные: кол-во элементов до каждого фрагмента дает префиксная сумма подсчетов фрагментов.
+ * Смещения полигонов 32-битные: если вершин полигонов больше 2^32 - 1, бросается std::length_error. Определена для
+ * uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param data Содержимое файла
+ * \param size Размер содержимого
+ * \param mesh Меш для записи полигонов (очищается, память выделяется из его источника)
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void ReadPolygons(const char* data, size_t size, BasicMesh<Index>& mesh, ThreadPool& pool);
+
+/**
+ * \brief Определить формат вершин строки "f ..." по ее первой вершине
+ * \param line Начало строки
+ * \param lineEnd Конец строки
+ * \return Формат
+ */
+FaceLayout DetectFaceLayout(const char* line, const char* lineEnd);
+
+/**
+ * \brief Определить формат вершин полигонов содержимого .obj файла (по первой строке "f ..." с вершинами)
+ * \param data Содержимое файла
+ * \param size Размер содержимого
+ * \return Формат (v/vt/vn, если полигонов нет)
+ */
+FaceLayout DetectFaceLayout(const char* data, size_t size);
+
+/**
+ * \brief Считать одну строку "f ..." (вершины добавляются в меш, полигон закрывается)
+ *
+ * \details Вершины читаются, пока соответствуют формату layout. Отсутствующие в формате индексы равны 0, относительные
+ * индексы переводятся в абсолютные (ссылка за начало файла обрывает строку). Если не прочитано ни одной вершины
+ * (строка в другом формате либо без вершин), полигон не создается
+ *
+ * \param line Начало строки
+ * \param lineEnd Конец строки (без символа перевода строки)
+ * \param layout Формат вершин (DetectFaceLayout)
+ * \param counts Кол-во элементов, прочитанных до строки
+ * \param mesh Меш для записи полигона
+ * \return Прочитан ли полигон
+ */
+template<typename Index>
+bool ReadFaceLine(const char* line, const char* lineEnd, FaceLayout layout, const ElementCounts& counts, BasicMesh<Index>& mesh);
+
+/**
+ * \brief Итоги предварительного прохода по .obj файлу
+ */
+struct ObjScan
+{
+    /// Индекс строк (фрагменты индекса - единицы параллельной обработки)
+    LineIndex lines;
+    /// Кол-во полигонов в каждом фрагменте
+    std::vector<unsigned> chunkFaces;
+    /// Кол-во вершин полигонов в каждом фрагменте
+    std::vector<size_t> chunkFaceVertices;
+    /// Кол-во элементов, прочитанных до начала каждого фрагмента (последний - итог по файлу)
+    std::vector<ElementCounts> chunkElements;
+
+    /// Кол-во строк "v ", "vt ", "vn " и "f "
+    size_t positions = 0;
+    size_t texCoords = 0;
+    size_t normals = 0;
+    size_t faces = 0;
+    /// Кол-во пропущенных строк "f " без вершин в формате файла (eLineSkippedFace)
+    size_t skippedFaces = 0;
+    /// Кол-во вершин всех полигонов
+    size_t faceVertices = 0;
+    /// Кол-во строк основной информации (как в ReadBaseObjData)
+    size_t baseLines = 0;
+
+    /// Формат вершин полигонов (по первой строке "f ..." с вершинами)
+    FaceLayout faceLayout = eFacePositionUvNormal;
+
+    /// Наибольший индекс вершины полигона (относительные - в абсолютном виде)
+    uint64_t maxIndex = 0;
+
+    /**
+     * \brief Наименьшая разрядность индексов, достаточная для строк "f ..."
+     *
+     * \details Индексы больше 2^32 - 1 (ранее обрывавшие строку) требуют 64 бит и читаются корректно
+     */
+    [[nodiscard]] IndexWidth indexWidth() const;
+};
+
+/**
+ * \brief Предварительный проход по содержимому .obj файла - классификация строк и подсчет вершин полигонов
+ *
+ * \details Строится индекс строк (BuildLineIndex), фрагменты индекса просматриваются параллельно, индексы полигонов
+ * разбираются так же, как при чтении. Подсчеты позволяют заранее выделить точный объем памяти под меш и основную информацию, выбрать
+ * разрядность индексов и способ обработки (в памяти или во внешней памяти)
+ *
+ * \param data Содержимое файла
+ * \param size Размер содержимого
+ * \param pool Пул потоков
+ * \return Итоги прохода
+ */
+ObjScan ScanObjFile(const char* data, size_t size, ThreadPool& pool);
+
+/**
+ * \brief Считать данные о полигонах по итогам предварительного прохода
+ *
+ * \details Память меша выделяется один раз точного размера, каждый фрагмент индекса строк пишет полигоны сразу на
+ * свое место (без склейки и без повторного поиска строк). Если индексы не помещаются в Index, используется обычное чтение.
+ * Как и при обычном чтении, больше 2^32 - 1 вершин полигонов не поддерживается (std::length_error)
+ *
+ * \param data Содержимое файла (то же, что и при проходе)
+ * \param size Размер содержимого
+ * \param scan Итоги ScanObjFile
+ * \param mesh Меш для записи полигонов (память выделяется из его источника)
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void ReadPolygons(const char* data, size_t size, const ObjScan& scan, BasicMesh<Index>& mesh, ThreadPool& pool);
+
+/**
+ * \brief Считать основную информацию .obj файла (вершины, нормали, uv-координаты, не включая данные о полигонах)
+ *
+ * \details Сохраняются все строки файла, где бы они ни находились (в том числе вершины после "usemtl" в файлах из
+ * нескольких объектов), кроме строк полигонов и материалов, которые переписываются, а также "#", "mtllib" и строк
+ * объектов и сглаживания ("o", "g", "s"), относящихся к полигонам
+ *
+ * \param data Содержимое файла
+ * \param size Размер содержимого
+ * \param lines Массив строк для записи (очищается)
+ */
+void ReadBaseObjData(const char* data, size_t size, TextLines& lines);
+
+/**
+ * \brief Считать основную информацию .obj файла по индексу строк (те же строки, что и в ReadBaseObjData)
+ * \param data Содержимое файла
+ * \param index Индекс строк содержимого
+ * \param lines Массив строк для записи (очищается)
+ */
+void ReadBaseObjData(const char* data, const LineIndex& index, TextLines& lines);
+
+/**
+ * \brief Пройти по строкам основной информации .obj файла без их копирования (те же строки, что и в ReadBaseObjData)
+ * \param data Содержимое файла
+ * \param size Размер содержимого
+ * \param onLine Обработчик строки (начало, длина)
+ */
+void ForEachBaseObjLine(const char* data, size_t size, const std::function<void(const char*, size_t)>& onLine);
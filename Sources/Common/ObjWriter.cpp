@@ -0,0 +1,93 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Формирование результирующих файлов.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "ObjWriter.h"
+
+#include <algorithm>
+
+namespace
+{
+    /// Минимальное кол-во полигонов во фрагменте при параллельном форматировании
+    const size_t MIN_CHUNK_POLYGONS = 16384;
+}
+
+template<typename Index>
+std::pmr::string FormatObjText(const std::string& mtlFileName, const TextLines& baseData,
+                               const BasicMesh<Index>& mesh, const GroupMembers& groups, ThreadPool& pool,
+                               const ObjectMaterials* materials)
+{
+    std::pmr::string text(mesh.resource());
+    AppendObjHeader(text, mtlFileName);
+
+    // Размер заранее известен, лишних перевыделений (и мусора в арене) нет
+    size_t baseSize = text.size();
+    for(const auto& line : baseData) baseSize += line.size() + 1;
+    text.reserve(baseSize);
+
+    for(const auto& line : baseData){
+        text += line;
+        text += '\n';
+    }
+
+    const size_t polygonCount = groups.polygons.size();
+    if(polygonCount == 0) return text;
+
+    // Фрагменты списка полигонов (заголовок группы пишет фрагмент, в котором группа начинается)
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(pool.threadCount() * 4, polygonCount / MIN_CHUNK_POLYGONS));
+    const size_t chunkSize = (polygonCount + chunkCount - 1) / chunkCount;
+    std::vector<std::string> chunks(chunkCount);
+
+    pool.run(static_cast<unsigned>(chunkCount), [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(polygonCount, begin + chunkSize);
+        if(begin >= end) return;
+
+        std::string& out = chunks[c];
+        out.reserve((end - begin) * 64);
+
+        // Группа, в которой находится первый полигон фрагмента
+        unsigned g = static_cast<unsigned>(std::upper_bound(groups.offsets.begin(), groups.offsets.end(), begin) - groups.offsets.begin()) - 1;
+
+        for(size_t i = begin; i < end; i++)
+        {
+            while(groups.offsets[g + 1] <= i) g++;
+            if(groups.offsets[g] == i) AppendGroupHeader(out, g, materials);
+            AppendPolygon(out, mesh.polygon(groups.polygons[i]), mesh.faceLayout);
+        }
+    });
+
+    size_t total = text.size();
+    for(const auto& chunk : chunks) total += chunk.size();
+    text.reserve(total);
+    for(const auto& chunk : chunks) text += chunk;
+
+    return text;
+}
+
+template std::pmr::string FormatObjText(const std::string&, const TextLines&, const Mesh16&, const GroupMembers&, ThreadPool&, const ObjectMaterials*);
+template std::pmr::string FormatObjText(const std::string&, const TextLines&, const Mesh32&, const GroupMembers&, ThreadPool&, const ObjectMaterials*);
+template std::pmr::string FormatObjText(const std::string&, const TextLines&, const Mesh64&, const GroupMembers&, ThreadPool&, const ObjectMaterials*);
+
+std::string FormatMtlText(unsigned groupCount, const ObjectMaterials* materials)
+{
+    std::string text = "# SED Auto Materials v1.0 MTL File\n# Material Count: " + std::to_string(groupCount) + "\n";
+
+    for(unsigned g = 0; g < groupCount; g++)
+    {
+        text += "\nnewmtl ";
+        AppendMaterialName(text, g, materials);
+        text += "\n"
+                "Ns 225.000000\n"
+                "Ka 1.000000 1.000000 1.000000\n"
+                "Kd 0.800000 0.800000 0.800000\n"
+                "Ks 0.500000 0.500000 0.500000\n"
+                "Ke 0.000000 0.000000 0.000000\n"
+                "Ni 1.450000\n"
+                "d 1.000000\n"
+                "illum 2\n";
+    }
+
+    return text;
+}
@@ -0,0 +1,126 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Формирование результирующих файлов.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <charconv>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "Grouping.h"
+#include "Objects.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Дописать число в строку
+ */
+template<typename String, typename Number>
+inline void AppendNumber(String& out, const Number value)
+{
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+/**
+ * \brief Дописать заголовок .obj файла (до основной информации)
+ */
+template<typename String>
+inline void AppendObjHeader(String& out, const std::string& mtlFileName)
+{
+    out += "# SED Auto Materials v1.0 OBJ File\nmtllib ";
+    out += mtlFileName;
+    out += '\n';
+}
+
+/**
+ * \brief Дописать имя материала группы ("Material.N" либо "<объект>.Material.N" при разбиении по объектам)
+ */
+template<typename String>
+inline void AppendMaterialName(String& out, unsigned g, const ObjectMaterials* materials)
+{
+    if(materials){
+        const unsigned object = materials->objectOf(g);
+        out += materials->names[object];
+        out += '.';
+        g -= materials->firstGroup[object];
+    }
+    out += "Material.";
+    AppendNumber(out, g);
+}
+
+/**
+ * \brief Дописать заголовок группы (материал, перед первой группой объекта - строка объекта "o")
+ */
+template<typename String>
+inline void AppendGroupHeader(String& out, const unsigned g, const ObjectMaterials* materials = nullptr)
+{
+    if(materials){
+        const unsigned object = materials->objectOf(g);
+        if(materials->firstGroup[object] == g){
+            out += "o ";
+            out += materials->names[object];
+            out += '\n';
+        }
+    }
+    out += "usemtl ";
+    AppendMaterialName(out, g, materials);
+    out += "\ns off\n";
+}
+
+/**
+ * \brief Дописать строку полигона (вершины в формате layout)
+ */
+template<typename String, typename Index>
+inline void AppendPolygon(String& out, const BasicPolygonView<Index>& polygon, FaceLayout layout)
+{
+    out += 'f';
+    for(const auto& v : polygon)
+    {
+        out += ' ';
+        AppendNumber(out, v.posIdx);
+        if(layout == eFacePositionUv || layout == eFacePositionUvNormal){
+            out += '/';
+            AppendNumber(out, v.uvIdx);
+        }
+        if(layout == eFacePositionNormal){
+            out += "//";
+            AppendNumber(out, v.normalIdx);
+        }
+        if(layout == eFacePositionUvNormal){
+            out += '/';
+            AppendNumber(out, v.normalIdx);
+        }
+    }
+    out += '\n';
+}
+
+/**
+ * \brief Сформировать содержимое результирующего .obj файла
+ *
+ * \details Строки полигонов форматируются параллельно (фрагментами) и склеиваются в исходном порядке. Определена
+ * для uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mtlFileName Имя .mtl файла (для строки mtllib)
+ * \param baseData Основная информация исходного .obj (вершины, нормали, uv-координаты)
+ * \param mesh Меш
+ * \param groups Группы полигонов (каждая группа - отдельный материал)
+ * \param pool Пул потоков
+ * \param materials Материалы групп при разбиении по объектам (nullptr - "Material.N")
+ * \return Содержимое файла (выделяется из источника памяти меша)
+ */
+template<typename Index>
+std::pmr::string FormatObjText(const std::string& mtlFileName, const TextLines& baseData,
+                               const BasicMesh<Index>& mesh, const GroupMembers& groups, ThreadPool& pool,
+                               const ObjectMaterials* materials = nullptr);
+
+/**
+ * \brief Сформировать содержимое результирующего .mtl файла
+ * \param groupCount Кол-во групп (материалов)
+ * \param materials Материалы групп при разбиении по объектам (nullptr - "Material.N")
+ * \return Содержимое файла
+ */
+std::string FormatMtlText(unsigned groupCount, const ObjectMaterials* materials = nullptr);
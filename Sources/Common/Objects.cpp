@@ -0,0 +1,153 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Обработка по объектам ("o"/"g").
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Objects.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+    /// Имя объекта для полигонов до первого блока "o"/"g" (и для блоков без имени)
+    const char* const DEFAULT_OBJECT_NAME = "Object";
+
+    /// Объект еще не встречался
+    const unsigned NO_OBJECT = ~0u;
+
+    /**
+     * \brief Имя объекта из строки "o ..." либо "g ..." (пробелы внутри имени заменяются на "_")
+     * \param line Начало строки
+     * \param lineEnd Конец строки
+     * \return Имя
+     */
+    std::string ObjectName(const char* line, const char* lineEnd)
+    {
+        auto isSpace = [](char c){ return c == ' ' || c == '\t' || c == '\r'; };
+
+        const char* p = line + 1;
+        while(p < lineEnd && isSpace(*p)) p++;
+        while(lineEnd > p && isSpace(*(lineEnd - 1))) lineEnd--;
+        if(p == lineEnd) return DEFAULT_OBJECT_NAME;
+
+        std::string name(p, lineEnd);
+        std::replace_if(name.begin(), name.end(), isSpace, '_');
+        return name;
+    }
+}
+
+unsigned ObjectMaterials::objectOf(unsigned g) const
+{
+    return static_cast<unsigned>(std::upper_bound(firstGroup.begin(), firstGroup.end(), g) - firstGroup.begin()) - 1;
+}
+
+ObjectFaces CollectObjectFaces(const char* data, const LineIndex& lines, std::pmr::memory_resource* resource)
+{
+    // Объект каждого полигона (номер по имени, в порядке появления имен)
+    std::vector<std::string> names;
+    std::unordered_map<std::string, unsigned> found;
+    std::vector<unsigned> faceObjects;
+    unsigned current = NO_OBJECT;
+
+    auto findObject = [&](std::string name){
+        auto it = found.emplace(std::move(name), static_cast<unsigned>(names.size()));
+        if(it.second) names.push_back(it.first->first);
+        return it.first->second;
+    };
+
+    for(size_t i = 0; i < lines.lineCount(); i++)
+    {
+        if(lines.types[i] == eLineObject){
+            current = findObject(ObjectName(data + lines.lineBegin(i), data + lines.lineEnd(i)));
+        }else if(lines.types[i] == eLineFace){
+            if(current == NO_OBJECT) current = findObject(DEFAULT_OBJECT_NAME);
+            faceObjects.push_back(current);
+        }
+    }
+
+    // Размеры объектов, объекты без полигонов отбрасываются
+    std::vector<unsigned> sizes(names.size(), 0);
+    for(unsigned object : faceObjects) sizes[object]++;
+
+    ObjectFaces objects(resource);
+    std::vector<unsigned> remap(names.size(), NO_OBJECT);
+    objects.offsets.push_back(0);
+    for(unsigned o = 0; o < names.size(); o++)
+    {
+        if(sizes[o] == 0) continue;
+        remap[o] = objects.objectCount();
+        objects.names.push_back(names[o]);
+        objects.offsets.push_back(objects.offsets.back() + sizes[o]);
+    }
+
+    // Раскладка полигонов по объектам (устойчивая - порядок полигонов сохраняется)
+    objects.polygons.resize(faceObjects.size());
+    std::vector<unsigned> cursors(objects.offsets.begin(), objects.offsets.end() - 1);
+    for(unsigned p = 0; p < faceObjects.size(); p++){
+        objects.polygons[cursors[remap[faceObjects[p]]]++] = p;
+    }
+
+    return objects;
+}
+
+template<typename Index>
+GroupMembers GroupObjects(const BasicMesh<Index>& mesh, const ObjectFaces& objects, const GroupingEngine& engine,
+                          ThreadPool& pool, ObjectMaterials& materials)
+{
+    const unsigned objectCount = objects.objectCount();
+
+    // Крупные объекты берутся первыми, мелкие выравнивают нагрузку в конце
+    std::vector<unsigned> order(objectCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b){
+        return objects.offsets[a + 1] - objects.offsets[a] > objects.offsets[b + 1] - objects.offsets[b];
+    });
+
+    // Группы каждого объекта (номера полигонов - внутри объекта)
+    std::vector<GroupMembers> local(objectCount);
+    pool.run(objectCount, [&](unsigned task){
+        const unsigned o = order[task];
+        const unsigned begin = objects.offsets[o];
+        const unsigned end = objects.offsets[o + 1];
+
+        // Компактная копия полигонов объекта (временная, не в источнике памяти меша)
+        BasicMesh<Index> part;
+        part.faceLayout = mesh.faceLayout;
+        size_t vertexCount = 0;
+        for(unsigned i = begin; i < end; i++) vertexCount += mesh.polygon(objects.polygons[i]).size();
+        part.vertices.reserve(vertexCount);
+        part.faceOffsets.reserve(end - begin + 1);
+        for(unsigned i = begin; i < end; i++)
+        {
+            for(const auto& v : mesh.polygon(objects.polygons[i])) part.addVertex(v);
+            part.closePolygon();
+        }
+
+        local[o] = CollectGroupMembers(engine.divide(part, pool));
+    });
+
+    // Группы объектов идут подряд
+    materials.names = objects.names;
+    materials.firstGroup.assign(objectCount + 1, 0);
+    for(unsigned o = 0; o < objectCount; o++) materials.firstGroup[o + 1] = materials.firstGroup[o] + local[o].groupCount();
+
+    GroupMembers groups(mesh.resource());
+    groups.offsets.resize(materials.firstGroup.back() + 1);
+    groups.offsets[0] = 0;
+    groups.polygons.resize(objects.polygons.size());
+    pool.run(objectCount, [&](unsigned o){
+        const GroupMembers& members = local[o];
+        const unsigned first = materials.firstGroup[o];
+        const unsigned base = objects.offsets[o];
+        for(unsigned g = 0; g < members.groupCount(); g++) groups.offsets[first + g + 1] = base + members.offsets[g + 1];
+        for(unsigned i = 0; i < members.polygons.size(); i++) groups.polygons[base + i] = objects.polygons[base + members.polygons[i]];
+    });
+
+    return groups;
+}
+
+template GroupMembers GroupObjects(const Mesh16&, const ObjectFaces&, const GroupingEngine&, ThreadPool&, ObjectMaterials&);
+template GroupMembers GroupObjects(const Mesh32&, const ObjectFaces&, const GroupingEngine&, ThreadPool&, ObjectMaterials&);
+template GroupMembers GroupObjects(const Mesh64&, const ObjectFaces&, const GroupingEngine&, ThreadPool&, ObjectMaterials&);
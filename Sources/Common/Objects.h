@@ -0,0 +1,87 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Обработка по объектам ("o"/"g").
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "Grouping.h"
+#include "LineIndex.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Полигоны каждого объекта .obj файла (CSR)
+ *
+ * \details Объект - блок строк, начинающийся с "o" либо "g". Блоки с одинаковым именем относятся к одному объекту,
+ * полигоны до первого блока - к объекту "Object". Объекты без полигонов не учитываются
+ */
+struct ObjectFaces
+{
+    /// Имена объектов в порядке появления (пробелы заменены на "_")
+    std::vector<std::string> names;
+    /// Смещения начала объектов (последний элемент - общее кол-во полигонов)
+    std::pmr::vector<unsigned> offsets;
+    /// Индексы полигонов, упорядоченные по объектам (внутри объекта - в исходном порядке)
+    std::pmr::vector<unsigned> polygons;
+
+    ObjectFaces() = default;
+
+    explicit ObjectFaces(std::pmr::memory_resource* resource) : offsets(resource), polygons(resource)
+    {}
+
+    [[nodiscard]] unsigned objectCount() const
+    {
+        return offsets.empty() ? 0 : static_cast<unsigned>(offsets.size() - 1);
+    }
+};
+
+/**
+ * \brief Материалы групп, полученных по объектам ("<объект>.Material.N", N - номер группы внутри объекта)
+ */
+struct ObjectMaterials
+{
+    /// Имена объектов
+    std::vector<std::string> names;
+    /// Первая группа каждого объекта (последний элемент - общее кол-во групп)
+    std::vector<unsigned> firstGroup;
+
+    /**
+     * \brief Объект, которому принадлежит группа
+     * \param g Номер группы
+     * \return Номер объекта
+     */
+    [[nodiscard]] unsigned objectOf(unsigned g) const;
+};
+
+/**
+ * \brief Разложить полигоны по объектам (по индексу строк, i-й полигон меша - i-я строка "f ...")
+ * \param data Содержимое файла
+ * \param lines Индекс строк
+ * \param resource Источник памяти для списков полигонов
+ * \return Полигоны объектов
+ */
+ObjectFaces CollectObjectFaces(const char* data, const LineIndex& lines, std::pmr::memory_resource* resource);
+
+/**
+ * \brief Разбить полигоны на группы отдельно внутри каждого объекта
+ *
+ * \details Каждый объект - отдельная задача пула (крупные объекты раньше, остальные разбираются освободившимися
+ * потоками): полигоны объекта копируются в свой компактный меш, разбиваются выбранным алгоритмом (вложенные вызовы
+ * пула выполняются последовательно в потоке задачи). Группы нумеруются по объектам, внутри объекта - в порядке
+ * появления первого полигона. Определена для uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param objects Полигоны объектов
+ * \param engine Алгоритм разбиения
+ * \param pool Пул потоков
+ * \param materials Материалы групп (заполняется)
+ * \return Списки полигонов групп (выделяются из источника памяти меша)
+ */
+template<typename Index>
+GroupMembers GroupObjects(const BasicMesh<Index>& mesh, const ObjectFaces& objects, const GroupingEngine& engine,
+                          ThreadPool& pool, ObjectMaterials& materials);
@@ -0,0 +1,274 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Наложения островов в развертке.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Overlap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    /// Минимальное кол-во островов в диапазоне при параллельной обработке
+    const size_t MIN_CHUNK_ISLANDS = 256;
+
+    /// Минимальное кол-во пар в диапазоне при параллельной проверке
+    const size_t MIN_CHUNK_PAIRS = 64;
+
+    /// Наибольшее кол-во пар-кандидатов (развертки, повторяющие всю текстуру, дают квадратичное кол-во пар)
+    const size_t MAX_CANDIDATES = size_t(1) << 22;
+
+    /// Наименьшая глубина наложения (доля текстуры), меньшее считается касанием
+    const float OVERLAP_EPSILON = 1e-6f;
+
+    /**
+     * \brief Габариты в развертке
+     */
+    struct Box
+    {
+        float minU = std::numeric_limits<float>::max();
+        float minV = std::numeric_limits<float>::max();
+        float maxU = std::numeric_limits<float>::lowest();
+        float maxV = std::numeric_limits<float>::lowest();
+
+        [[nodiscard]] bool empty() const { return minU > maxU; }
+
+        void add(float u, float v)
+        {
+            minU = std::min(minU, u);
+            minV = std::min(minV, v);
+            maxU = std::max(maxU, u);
+            maxV = std::max(maxV, v);
+        }
+
+        [[nodiscard]] bool overlaps(const Box& b) const
+        {
+            return minU < b.maxU && b.minU < maxU && minV < b.maxV && b.minV < maxV;
+        }
+    };
+
+    /**
+     * \brief Треугольник развертки
+     */
+    struct Triangle
+    {
+        float u[3];
+        float v[3];
+        Box box;
+    };
+
+    /**
+     * \brief Разделяет ли ось, перпендикулярная ребру первого треугольника, треугольники
+     * \param a Первый треугольник
+     * \param i Начало ребра
+     * \param b Второй треугольник
+     * \return Разделяет ли (с учетом допуска касания)
+     */
+    bool Separates(const Triangle& a, unsigned i, const Triangle& b)
+    {
+        const unsigned j = (i + 1) % 3;
+        const float axisU = a.v[i] - a.v[j];
+        const float axisV = a.u[j] - a.u[i];
+        const float length = std::sqrt(axisU * axisU + axisV * axisV);
+        if(length <= 0.0f) return false;
+
+        float minA = std::numeric_limits<float>::max(), maxA = std::numeric_limits<float>::lowest();
+        float minB = minA, maxB = maxA;
+        for(unsigned k = 0; k < 3; k++)
+        {
+            const float pa = a.u[k] * axisU + a.v[k] * axisV;
+            const float pb = b.u[k] * axisU + b.v[k] * axisV;
+            minA = std::min(minA, pa);
+            maxA = std::max(maxA, pa);
+            minB = std::min(minB, pb);
+            maxB = std::max(maxB, pb);
+        }
+        const float epsilon = OVERLAP_EPSILON * length;
+        return maxA <= minB + epsilon || maxB <= minA + epsilon;
+    }
+
+    /**
+     * \brief Накладываются ли треугольники (нет разделяющей оси среди перпендикуляров к ребрам)
+     */
+    bool TrianglesOverlap(const Triangle& a, const Triangle& b)
+    {
+        for(unsigned i = 0; i < 3; i++)
+        {
+            if(Separates(a, i, b) || Separates(b, i, a)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * \brief Накладываются ли острова (развертка по оси u треугольников, попавших в пересечение габаритов)
+     * \param a Треугольники первого острова
+     * \param aCount Кол-во треугольников первого острова
+     * \param b Треугольники второго острова
+     * \param bCount Кол-во треугольников второго острова
+     * \param region Пересечение габаритов островов
+     * \param items Рабочий массив (треугольник и остров)
+     * \return Накладываются ли
+     */
+    bool IslandsOverlap(const Triangle* a, unsigned aCount, const Triangle* b, unsigned bCount, const Box& region,
+                        std::vector<std::pair<const Triangle*, unsigned>>& items)
+    {
+        items.clear();
+        for(unsigned i = 0; i < aCount; i++) if(a[i].box.overlaps(region)) items.emplace_back(a + i, 0u);
+        for(unsigned i = 0; i < bCount; i++) if(b[i].box.overlaps(region)) items.emplace_back(b + i, 1u);
+        std::sort(items.begin(), items.end(), [](const auto& x, const auto& y){ return x.first->box.minU < y.first->box.minU; });
+
+        // Активные треугольники каждого острова (правая граница еще не пройдена)
+        std::vector<const Triangle*> active[2];
+        for(const auto& item : items)
+        {
+            const Triangle& t = *item.first;
+            std::vector<const Triangle*>& other = active[1 - item.second];
+            other.erase(std::remove_if(other.begin(), other.end(), [&](const Triangle* o){ return o->box.maxU <= t.box.minU; }), other.end());
+            for(const Triangle* o : other)
+            {
+                if(o->box.overlaps(t.box) && TrianglesOverlap(*o, t)) return true;
+            }
+            active[item.second].push_back(&t);
+        }
+        return false;
+    }
+}
+
+template<typename Index>
+UvOverlaps FindUvOverlaps(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& texCoords, ThreadPool& pool)
+{
+    const unsigned islandCount = groups.groupCount();
+    auto textured = [&](const auto& polygon){
+        return polygon.size() >= 3 && std::all_of(polygon.begin(), polygon.end(), [&](const auto& v){
+            return v.uvIdx != 0 && v.uvIdx <= texCoords.count();
+        });
+    };
+
+    // Кол-во треугольников каждого острова (веерная триангуляция полигонов с текстурными координатами)
+    std::vector<size_t> triangleOffsets(islandCount + 1, 0);
+    pool.parallelFor(islandCount, [&](size_t begin, size_t end){
+        for(size_t g = begin; g < end; g++)
+        {
+            size_t count = 0;
+            for(unsigned i = groups.offsets[g]; i < groups.offsets[g + 1]; i++)
+            {
+                const auto polygon = mesh.polygon(groups.polygons[i]);
+                if(textured(polygon)) count += polygon.size() - 2;
+            }
+            triangleOffsets[g + 1] = count;
+        }
+    }, MIN_CHUNK_ISLANDS);
+    for(unsigned g = 1; g <= islandCount; g++) triangleOffsets[g] += triangleOffsets[g - 1];
+
+    // Треугольники и габариты островов
+    std::vector<Triangle> triangles(triangleOffsets.back());
+    std::vector<Box> boxes(islandCount);
+    pool.parallelFor(islandCount, [&](size_t begin, size_t end){
+        for(size_t g = begin; g < end; g++)
+        {
+            Triangle* out = triangles.data() + triangleOffsets[g];
+            for(unsigned i = groups.offsets[g]; i < groups.offsets[g + 1]; i++)
+            {
+                const auto polygon = mesh.polygon(groups.polygons[i]);
+                if(!textured(polygon)) continue;
+                for(size_t k = 2; k < polygon.size(); k++, out++)
+                {
+                    const size_t corners[3] = {0, k - 1, k};
+                    out->box = Box();
+                    for(unsigned c = 0; c < 3; c++)
+                    {
+                        const uint64_t uv = polygon.first[corners[c]].uvIdx;
+                        out->u[c] = texCoords.x[uv - 1];
+                        out->v[c] = texCoords.y[uv - 1];
+                        out->box.add(out->u[c], out->v[c]);
+                    }
+
+                    // Вырожденный треугольник ничего не накрывает (пустые габариты исключают его из проверок)
+                    const float doubled = (out->u[1] - out->u[0]) * (out->v[2] - out->v[0]) - (out->u[2] - out->u[0]) * (out->v[1] - out->v[0]);
+                    if(std::abs(doubled) <= OVERLAP_EPSILON * OVERLAP_EPSILON){
+                        out->box = Box();
+                        continue;
+                    }
+                    boxes[g].add(out->box.minU, out->box.minV);
+                    boxes[g].add(out->box.maxU, out->box.maxV);
+                }
+            }
+        }
+    }, MIN_CHUNK_ISLANDS);
+
+    // Острова с разверткой, упорядоченные по левой границе
+    std::vector<unsigned> order;
+    order.reserve(islandCount);
+    for(unsigned g = 0; g < islandCount; g++) if(!boxes[g].empty()) order.push_back(g);
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b){
+        return boxes[a].minU != boxes[b].minU ? boxes[a].minU < boxes[b].minU : a < b;
+    });
+
+    // Кандидаты - фрагменты упорядоченного списка параллельно
+    const size_t count = order.size();
+    const unsigned chunkCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(pool.threadCount() * 4, count / MIN_CHUNK_ISLANDS)));
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    const size_t chunkLimit = MAX_CANDIDATES / chunkCount;
+    std::vector<std::vector<std::pair<unsigned, unsigned>>> chunkCandidates(chunkCount);
+    std::vector<uint8_t> chunkTruncated(chunkCount, 0);
+    pool.run(chunkCount, [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        for(size_t i = begin; i < end && !chunkTruncated[c]; i++)
+        {
+            const Box& box = boxes[order[i]];
+            for(size_t j = i + 1; j < count && boxes[order[j]].minU < box.maxU; j++)
+            {
+                if(!box.overlaps(boxes[order[j]])) continue;
+                if(chunkCandidates[c].size() == chunkLimit){
+                    chunkTruncated[c] = 1;
+                    break;
+                }
+                chunkCandidates[c].emplace_back(std::min(order[i], order[j]), std::max(order[i], order[j]));
+            }
+        }
+    });
+    std::vector<std::pair<unsigned, unsigned>> candidates;
+    for(const auto& chunk : chunkCandidates) candidates.insert(candidates.end(), chunk.begin(), chunk.end());
+
+    // Проверка пар по треугольникам
+    std::vector<uint8_t> confirmed(candidates.size(), 0);
+    pool.parallelFor(candidates.size(), [&](size_t begin, size_t end){
+        std::vector<std::pair<const Triangle*, unsigned>> items;
+        for(size_t i = begin; i < end; i++)
+        {
+            const unsigned a = candidates[i].first;
+            const unsigned b = candidates[i].second;
+            Box region;
+            region.minU = std::max(boxes[a].minU, boxes[b].minU);
+            region.minV = std::max(boxes[a].minV, boxes[b].minV);
+            region.maxU = std::min(boxes[a].maxU, boxes[b].maxU);
+            region.maxV = std::min(boxes[a].maxV, boxes[b].maxV);
+            confirmed[i] = IslandsOverlap(triangles.data() + triangleOffsets[a], static_cast<unsigned>(triangleOffsets[a + 1] - triangleOffsets[a]),
+                                          triangles.data() + triangleOffsets[b], static_cast<unsigned>(triangleOffsets[b + 1] - triangleOffsets[b]),
+                                          region, items);
+        }
+    }, MIN_CHUNK_PAIRS);
+
+    UvOverlaps overlaps;
+    overlaps.candidateCount = candidates.size();
+    overlaps.truncated = std::find(chunkTruncated.begin(), chunkTruncated.end(), 1) != chunkTruncated.end();
+    std::vector<uint8_t> overlapping(islandCount, 0);
+    for(size_t i = 0; i < candidates.size(); i++)
+    {
+        if(!confirmed[i]) continue;
+        overlaps.pairs.push_back(candidates[i]);
+        overlapping[candidates[i].first] = overlapping[candidates[i].second] = 1;
+    }
+    std::sort(overlaps.pairs.begin(), overlaps.pairs.end());
+    overlaps.overlappingIslands = static_cast<unsigned>(std::count(overlapping.begin(), overlapping.end(), 1));
+    return overlaps;
+}
+
+template UvOverlaps FindUvOverlaps(const Mesh16&, const GroupMembers&, const Coordinates&, ThreadPool&);
+template UvOverlaps FindUvOverlaps(const Mesh32&, const GroupMembers&, const Coordinates&, ThreadPool&);
+template UvOverlaps FindUvOverlaps(const Mesh64&, const GroupMembers&, const Coordinates&, ThreadPool&);
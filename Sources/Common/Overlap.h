@@ -0,0 +1,50 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Наложения островов в развертке.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Mesh.h"
+#include "Geometry.h"
+#include "Grouping.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Наложения островов в развертке
+ */
+struct UvOverlaps
+{
+    /// Пары накладывающихся островов (меньший номер первым, по возрастанию)
+    std::vector<std::pair<unsigned, unsigned>> pairs;
+    /// Кол-во пар с пересекающимися габаритами (кандидаты, проверенные по треугольникам)
+    size_t candidateCount = 0;
+    /// Кол-во островов, накладывающихся хотя бы на один другой
+    unsigned overlappingIslands = 0;
+    /// Поиск кандидатов остановлен по ограничению их кол-ва (найдены не все наложения)
+    bool truncated = false;
+};
+
+/**
+ * \brief Найти острова, накладывающиеся друг на друга в развертке
+ *
+ * \details Габариты островов в развертке считаются параллельно. Пары-кандидаты ищутся разверткой по оси u (острова
+ * упорядочены по левой границе, каждый сравнивается с последующими, пока они начинаются левее его правой границы;
+ * фрагменты упорядоченного списка обрабатываются параллельно). Каждая пара проверяется параллельно: треугольники
+ * (веерная триангуляция полигонов), попавшие в пересечение габаритов, так же разворачиваются по оси u и сравниваются
+ * по разделяющим осям. Кол-во кандидатов ограничено (около 4 млн. пар), при достижении ограничения поиск
+ * останавливается. Касание по ребру или вершине наложением не считается. Полигоны без текстурных координат не
+ * учитываются. Определена для uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param groups Острова
+ * \param texCoords Текстурные координаты
+ * \param pool Пул потоков
+ * \return Наложения
+ */
+template<typename Index>
+UvOverlaps FindUvOverlaps(const BasicMesh<Index>& mesh, const GroupMembers& groups, const Coordinates& texCoords, ThreadPool& pool);
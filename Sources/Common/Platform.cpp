@@ -0,0 +1,209 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Платформо-зависимые функции.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+#ifdef _WIN32
+
+size_t PeakResidentMemory()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+}
+
+bool ResetPeakResidentMemory()
+{
+    return false;
+}
+
+size_t PhysicalMemory()
+{
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if(!GlobalMemoryStatusEx(&status)) return 0;
+    return static_cast<size_t>(status.ullTotalPhys);
+}
+
+void* AllocatePages(size_t size, bool)
+{
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void FreePages(void* pointer, size_t)
+{
+    if(pointer) VirtualFree(pointer, 0, MEM_RELEASE);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file_ == INVALID_HANDLE_VALUE){
+        file_ = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file_, &fileSize)){
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+
+    // Пустой файл отобразить нельзя, но он корректен
+    if(size_ == 0) return true;
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mapping_){
+        close();
+        return false;
+    }
+
+    data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if(!data_){
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(data_) UnmapViewOfFile(data_);
+    if(mapping_) CloseHandle(mapping_);
+    if(file_) CloseHandle(file_);
+
+    data_ = nullptr;
+    mapping_ = nullptr;
+    file_ = nullptr;
+    size_ = 0;
+}
+
+#else
+
+size_t PeakResidentMemory()
+{
+    // VmHWM в /proc/self/status (в отличие от getrusage его можно сбросить)
+    FILE* status = std::fopen("/proc/self/status", "r");
+    if(!status) return 0;
+
+    char line[256];
+    size_t peak = 0;
+    while(std::fgets(line, sizeof(line), status))
+    {
+        unsigned long kb = 0;
+        if(std::sscanf(line, "VmHWM: %lu kB", &kb) == 1){
+            peak = static_cast<size_t>(kb) * 1024;
+            break;
+        }
+    }
+
+    std::fclose(status);
+    return peak;
+}
+
+bool ResetPeakResidentMemory()
+{
+    FILE* clearRefs = std::fopen("/proc/self/clear_refs", "w");
+    if(!clearRefs) return false;
+
+    const bool ok = std::fputs("5", clearRefs) >= 0;
+    return std::fclose(clearRefs) == 0 && ok;
+}
+
+size_t PhysicalMemory()
+{
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+    if(pages <= 0 || pageSize <= 0) return 0;
+    return static_cast<size_t>(pages) * static_cast<size_t>(pageSize);
+}
+
+void* AllocatePages(size_t size, bool hugePages)
+{
+    void* pointer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(pointer == MAP_FAILED) return nullptr;
+
+#ifdef MADV_HUGEPAGE
+    if(hugePages) madvise(pointer, size, MADV_HUGEPAGE);
+#else
+    (void)hugePages;
+#endif
+
+    return pointer;
+}
+
+void FreePages(void* pointer, size_t size)
+{
+    if(pointer) munmap(pointer, size);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat info = {};
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(info.st_size);
+
+    // Пустой файл отобразить нельзя, но он корректен
+    if(size_ > 0)
+    {
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapped == MAP_FAILED){
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+
+        // Файл читается последовательно
+        madvise(mapped, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapped);
+    }
+
+    // Отображение остается действительным и после закрытия дескриптора
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(data_) munmap(const_cast<char*>(data_), size_);
+
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
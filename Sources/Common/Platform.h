@@ -0,0 +1,86 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Платформо-зависимые функции.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * \brief Пиковый объем резидентной памяти процесса (байт)
+ * \return Объем либо 0, если неизвестен
+ */
+size_t PeakResidentMemory();
+
+/**
+ * \brief Сбросить пиковый объем резидентной памяти до текущего
+ *
+ * \details Поддерживается только в Linux (через /proc/self/clear_refs). На других платформах пиковое значение
+ * монотонно растет в течение всей работы процесса
+ *
+ * \return Удалось ли сбросить
+ */
+bool ResetPeakResidentMemory();
+
+/**
+ * \brief Объем физической памяти (байт)
+ * \return Объем либо 0, если неизвестен
+ */
+size_t PhysicalMemory();
+
+/**
+ * \brief Выделить память страницами напрямую у системы
+ *
+ * \details При hugePages в Linux памяти назначается MADV_HUGEPAGE (прозрачные огромные страницы, если они
+ * включены в системе). В Windows огромные страницы требуют отдельных привилегий, поэтому флаг игнорируется
+ *
+ * \param size Размер (байт)
+ * \param hugePages Использовать огромные страницы
+ * \return Указатель (выровнен по границе страницы) либо nullptr
+ */
+void* AllocatePages(size_t size, bool hugePages);
+
+/**
+ * \brief Освободить память, выделенную AllocatePages
+ * \param pointer Указатель
+ * \param size Размер, переданный при выделении
+ */
+void FreePages(void* pointer, size_t size);
+
+/**
+ * \brief Файл, отображенный в память (только чтение)
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * \brief Открыть и отобразить файл
+     * \param path Путь к файлу
+     * \return Удалось ли открыть
+     */
+    bool open(const std::string& path);
+
+    /**
+     * \brief Закрыть файл
+     */
+    void close();
+
+    [[nodiscard]] const char* data() const { return data_; }
+    [[nodiscard]] size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
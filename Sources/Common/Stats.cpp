@@ -0,0 +1,218 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Статистика этапов обработки.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Stats.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <new>
+
+namespace
+{
+    /// Максимальное кол-во этапов
+    const unsigned MAX_PHASES = 32;
+
+    /**
+     * \brief Накопленная статистика этапа
+     *
+     * \details Все поля - атомарные счетчики с constexpr-конструкторами, поэтому таблица этапов инициализируется
+     * статически и доступна даже для выделений памяти до входа в main()
+     */
+    struct PhaseRecord
+    {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> nanoseconds{0};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> allocatedBytes{0};
+        std::atomic<int64_t> peakLiveBytes{0};
+    };
+
+    /// Таблица этапов (нулевой - выделения вне каких-либо этапов)
+    PhaseRecord g_phases[MAX_PHASES];
+    /// Кол-во зарегистрированных этапов
+    unsigned g_phaseCount = 1;
+    /// Мьютекс регистрации этапов
+    std::mutex g_phasesMutex;
+    /// Текущий (самый внутренний) этап
+    std::atomic<unsigned> g_activePhase{0};
+    /// Текущий объем занятой кучи
+    std::atomic<int64_t> g_liveBytes{0};
+
+    /**
+     * \brief Атомарно поднять значение до заданного
+     */
+    void AtomicMax(std::atomic<int64_t>& target, int64_t value)
+    {
+        int64_t current = target.load(std::memory_order_relaxed);
+        while(current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)){}
+    }
+
+    /**
+     * \brief Найти либо зарегистрировать этап
+     * \param name Имя этапа
+     * \return Индекс этапа
+     */
+    unsigned FindPhase(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(g_phasesMutex);
+
+        for(unsigned i = 1; i < g_phaseCount; i++){
+            if(std::strcmp(g_phases[i].name.load(), name) == 0) return i;
+        }
+
+        // Переполнение таблицы - выделения приписываются нулевому этапу
+        if(g_phaseCount == MAX_PHASES) return 0;
+
+        g_phases[g_phaseCount].name = name;
+        return g_phaseCount++;
+    }
+}
+
+#ifdef SED_TRACK_ALLOCATIONS
+
+namespace
+{
+    /// Размер заголовка выделенного блока (размер блока и указатель на начало выделения)
+    const size_t HEADER_SIZE = 2 * sizeof(void*) > 16 ? 2 * sizeof(void*) : 16;
+
+    /**
+     * \brief Выделить память с учетом в статистике текущего этапа
+     * \param size Размер
+     * \param alignment Выравнивание
+     * \return Указатель либо nullptr
+     */
+    void* TrackedAllocate(size_t size, size_t alignment)
+    {
+        if(alignment < HEADER_SIZE) alignment = HEADER_SIZE;
+
+        auto* base = static_cast<unsigned char*>(std::malloc(size + alignment + HEADER_SIZE));
+        if(!base) return nullptr;
+
+        // Пользовательский блок выравнивается, перед ним хранятся размер и указатель на начало выделения
+        const auto address = reinterpret_cast<uintptr_t>(base) + HEADER_SIZE;
+        auto* user = reinterpret_cast<unsigned char*>((address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+        reinterpret_cast<size_t*>(user)[-2] = size;
+        reinterpret_cast<void**>(user)[-1] = base;
+
+        PhaseRecord& phase = g_phases[g_activePhase.load(std::memory_order_relaxed)];
+        phase.allocations.fetch_add(1, std::memory_order_relaxed);
+        phase.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        const int64_t live = g_liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+        AtomicMax(phase.peakLiveBytes, live);
+
+        return user;
+    }
+
+    /**
+     * \brief Освободить память, выделенную TrackedAllocate
+     * \param pointer Указатель
+     */
+    void TrackedFree(void* pointer)
+    {
+        if(!pointer) return;
+
+        const size_t size = static_cast<size_t*>(pointer)[-2];
+        g_liveBytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        std::free(static_cast<void**>(pointer)[-1]);
+    }
+
+    /**
+     * \brief Выделить память или бросить std::bad_alloc
+     */
+    void* TrackedAllocateOrThrow(size_t size, size_t alignment)
+    {
+        void* pointer = TrackedAllocate(size, alignment);
+        if(!pointer) throw std::bad_alloc();
+        return pointer;
+    }
+}
+
+void* operator new(size_t size) { return TrackedAllocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return TrackedAllocateOrThrow(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return TrackedAllocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return TrackedAllocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return TrackedAllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return TrackedAllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return TrackedAllocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return TrackedAllocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { TrackedFree(pointer); }
+
+#endif
+
+StatsPhase::StatsPhase(const char* name)
+    : phase_(FindPhase(name))
+    , previousPhase_(g_activePhase.exchange(phase_))
+    , start_(std::chrono::steady_clock::now())
+{
+    // Пиковый объем кучи этапа не может быть меньше объема на момент его начала
+    AtomicMax(g_phases[phase_].peakLiveBytes, g_liveBytes.load(std::memory_order_relaxed));
+}
+
+StatsPhase::~StatsPhase()
+{
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+    g_phases[phase_].nanoseconds.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    g_activePhase.store(previousPhase_);
+}
+
+bool AllocationTrackingEnabled()
+{
+#ifdef SED_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PrintStats(std::ostream& out)
+{
+    const double MB = 1024.0 * 1024.0;
+    const bool tracking = AllocationTrackingEnabled();
+
+    out << std::left << std::setw(14) << "phase" << std::right << std::setw(12) << "time, ms";
+    if(tracking) out << std::setw(14) << "allocations" << std::setw(14) << "allocated, MB" << std::setw(14) << "peak heap, MB";
+    out << std::endl;
+
+    unsigned phaseCount;
+    {
+        std::lock_guard<std::mutex> lock(g_phasesMutex);
+        phaseCount = g_phaseCount;
+    }
+
+    for(unsigned i = 0; i < phaseCount; i++)
+    {
+        const PhaseRecord& phase = g_phases[i];
+
+        // Выделения вне этапов выводятся только если они есть
+        if(i == 0 && phase.allocations == 0) continue;
+
+        out << std::left << std::setw(14) << (i == 0 ? "(other)" : phase.name.load()) << std::right << std::fixed
+            << std::setw(12) << std::setprecision(2) << static_cast<double>(phase.nanoseconds) / 1e6;
+        if(tracking){
+            out << std::setw(14) << phase.allocations
+                << std::setw(14) << std::setprecision(2) << static_cast<double>(phase.allocatedBytes) / MB
+                << std::setw(14) << std::setprecision(2) << static_cast<double>(phase.peakLiveBytes) / MB;
+        }
+        out << std::endl;
+    }
+
+    if(!tracking) out << "(allocation tracking is disabled, configure with -DSED_TRACK_ALLOCATIONS=ON)" << std::endl;
+}
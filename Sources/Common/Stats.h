@@ -0,0 +1,48 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Статистика этапов обработки.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <chrono>
+#include <ostream>
+
+/**
+ * \brief Этап обработки (RAII)
+ *
+ * \details Пока объект существует, этап считается активным: время его работы накапливается, а при сборке с
+ * SED_TRACK_ALLOCATIONS все выделения памяти (из любого потока) приписываются ему - кол-во, объем и пиковый
+ * объем занятой кучи. Этапы могут быть вложенными, время учитывается включительно, выделения - самому
+ * внутреннему этапу
+ */
+class StatsPhase
+{
+public:
+    /**
+     * \brief Начать этап
+     * \param name Имя этапа (строковый литерал, этапы с одним именем суммируются)
+     */
+    explicit StatsPhase(const char* name);
+
+    ~StatsPhase();
+
+    StatsPhase(const StatsPhase&) = delete;
+    StatsPhase& operator=(const StatsPhase&) = delete;
+
+private:
+    unsigned phase_;
+    unsigned previousPhase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * \brief Включен ли подсчет выделений памяти (сборка с SED_TRACK_ALLOCATIONS)
+ */
+bool AllocationTrackingEnabled();
+
+/**
+ * \brief Вывести статистику этапов в виде таблицы
+ * \param out Поток вывода
+ */
+void PrintStats(std::ostream& out);
@@ -0,0 +1,148 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Пул потоков.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    /// Выполняется ли текущий поток внутри задачи пула
+    thread_local bool t_insidePool = false;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if(threadCount == 0) threadCount = hardwareThreads();
+
+    for(unsigned i = 1; i < threadCount; i++){
+        workers_.emplace_back([this](){ workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+
+    for(auto& worker : workers_) worker.join();
+}
+
+void ThreadPool::run(unsigned taskCount, const std::function<void(unsigned)>& task)
+{
+    if(taskCount == 0) return;
+
+    // Без рабочих потоков, одна задача либо вложенный вызов - все последовательно
+    if(workers_.empty() || taskCount == 1 || t_insidePool)
+    {
+        for(unsigned i = 0; i < taskCount; i++) task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        taskCount_ = taskCount;
+        nextTask_ = 0;
+        pendingTasks_ = taskCount;
+        failed_ = false;
+        error_ = nullptr;
+        generation_++;
+    }
+    wake_.notify_all();
+
+    // Вызывающий поток тоже выполняет задачи
+    drain();
+
+    // Дождаться завершения всех задач и выхода всех рабочих потоков из текущей работы
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this](){ return pendingTasks_ == 0 && activeWorkers_ == 0; });
+    task_ = nullptr;
+
+    // Первое исключение задач передается вызывающему
+    if(error_){
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& body, size_t minChunk)
+{
+    if(count == 0) return;
+
+    // Несколько диапазонов на поток - для выравнивания нагрузки
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount() * 4, count / std::max<size_t>(1, minChunk)));
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    run(static_cast<unsigned>(chunkCount), [&](unsigned chunk){
+        const size_t begin = chunk * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        if(begin < end) body(begin, end);
+    });
+}
+
+unsigned ThreadPool::hardwareThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::drain()
+{
+    const bool wasInside = t_insidePool;
+    t_insidePool = true;
+
+    unsigned i;
+    while((i = nextTask_.fetch_add(1)) < taskCount_)
+    {
+        // После исключения оставшиеся задачи только отмечаются выполненными
+        if(!failed_){
+            try{
+                (*task_)(i);
+            }catch(...){
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(!error_) error_ = std::current_exception();
+                failed_ = true;
+            }
+        }
+
+        if(pendingTasks_.fetch_sub(1) == 1){
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.notify_all();
+        }
+    }
+
+    t_insidePool = wasInside;
+}
+
+void ThreadPool::workerLoop()
+{
+    unsigned seenGeneration = 0;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&](){ return stop_ || generation_ != seenGeneration; });
+            if(stop_) return;
+            seenGeneration = generation_;
+
+            // Работа уже завершена другими потоками
+            if(!task_) continue;
+            activeWorkers_++;
+        }
+
+        drain();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            activeWorkers_--;
+        }
+        done_.notify_all();
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Пул потоков.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Пул потоков
+ *
+ * \details Вызывающий поток тоже участвует в работе, поэтому пул из одного потока не создает ни одного рабочего
+ * потока и выполняет все последовательно. Вложенные вызовы (из задачи пула) выполняются последовательно
+ */
+class ThreadPool
+{
+public:
+    /**
+     * \brief Создать пул
+     * \param threadCount Кол-во потоков (включая вызывающий), 0 - по кол-ву аппаратных потоков
+     */
+    explicit ThreadPool(unsigned threadCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * \brief Кол-во потоков (включая вызывающий)
+     */
+    [[nodiscard]] unsigned threadCount() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    /**
+     * \brief Выполнить задачи task(0) ... task(taskCount - 1) и дождаться их завершения
+     *
+     * \details Если задача бросает исключение, еще не начатые задачи пропускаются, а первое исключение бросается
+     * из run после завершения уже начатых
+     *
+     * \param taskCount Кол-во задач
+     * \param task Задача
+     */
+    void run(unsigned taskCount, const std::function<void(unsigned)>& task);
+
+    /**
+     * \brief Выполнить body(begin, end) для диапазонов, покрывающих [0, count)
+     * \param count Кол-во элементов
+     * \param body Обработчик диапазона
+     * \param minChunk Минимальный размер диапазона
+     */
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body, size_t minChunk = 4096);
+
+    /**
+     * \brief Кол-во аппаратных потоков
+     */
+    static unsigned hardwareThreads();
+
+private:
+    /**
+     * \brief Выполнять задачи текущей работы, пока они не закончатся
+     */
+    void drain();
+
+    /**
+     * \brief Цикл рабочего потока
+     */
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    /// Текущая работа
+    const std::function<void(unsigned)>* task_ = nullptr;
+    unsigned taskCount_ = 0;
+    std::atomic<unsigned> nextTask_{0};
+    std::atomic<unsigned> pendingTasks_{0};
+    /// Первое исключение задач текущей работы
+    std::exception_ptr error_;
+    std::atomic<bool> failed_{false};
+    /// Кол-во рабочих потоков, участвующих в текущей работе
+    unsigned activeWorkers_ = 0;
+    /// Номер работы (рабочие потоки просыпаются при его изменении)
+    unsigned generation_ = 0;
+    bool stop_ = false;
+};
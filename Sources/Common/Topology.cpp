@@ -0,0 +1,221 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Смежность полигонов (полуребра).
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Topology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include "Stats.h"
+
+namespace
+{
+    /// Минимальное кол-во элементов в диапазоне при параллельной обработке
+    const size_t MIN_CHUNK_ELEMENTS = 16384;
+
+    /**
+     * \brief Ключ ребра с 64-битными индексами (упорядоченная пара индексов положений)
+     */
+    struct WideEdgeKey
+    {
+        uint64_t first;
+        uint64_t second;
+
+        bool operator==(const WideEdgeKey& k) const
+        {
+            return first == k.first && second == k.second;
+        }
+
+        bool operator<(const WideEdgeKey& k) const
+        {
+            return first < k.first || (first == k.first && second < k.second);
+        }
+    };
+
+    /**
+     * \brief Ключ ребра (индексы до 32 бит упаковываются в одно 64-битное число)
+     * \param a Индекс положения начала ребра
+     * \param b Индекс положения конца ребра
+     * \return Ключ
+     */
+    template<typename Index>
+    auto EdgeKey(Index a, Index b)
+    {
+        if(b < a) std::swap(a, b);
+        if constexpr(sizeof(Index) <= sizeof(uint32_t)){
+            return (static_cast<uint64_t>(a) << 32u) | static_cast<uint64_t>(b);
+        }else{
+            return WideEdgeKey{a, b};
+        }
+    }
+
+    /// Тип ключа ребра
+    template<typename Index>
+    using EdgeKeyType = decltype(EdgeKey<Index>(0, 0));
+
+    /**
+     * \brief Перемешивание битов ключа (splitmix64)
+     * \param key Ключ
+     * \return Хеш
+     */
+    uint64_t MixKey(uint64_t key)
+    {
+        key = (key ^ (key >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27u)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31u);
+    }
+
+    uint64_t MixKey(const WideEdgeKey& key)
+    {
+        return MixKey(key.first ^ MixKey(key.second));
+    }
+
+    /**
+     * \brief Полуребро, разложенное в корзину
+     */
+    template<typename Key>
+    struct KeyedHalfEdge
+    {
+        Key key;
+        unsigned halfEdge;
+
+        bool operator<(const KeyedHalfEdge& item) const
+        {
+            return key < item.key || (key == item.key && halfEdge < item.halfEdge);
+        }
+    };
+}
+
+template<typename Index>
+MeshTopology<Index>::MeshTopology(const BasicMesh<Index>& mesh, ThreadPool& pool) : mesh_(mesh), pool_(pool)
+{}
+
+template<typename Index>
+const HalfEdges& MeshTopology<Index>::halfEdges()
+{
+    if(built_) return halfEdges_;
+    built_ = true;
+
+    using Key = EdgeKeyType<Index>;
+    StatsPhase phase("topology");
+
+    const unsigned faceCount = mesh_.faceCount();
+    const size_t count = mesh_.vertices.size();
+    halfEdges_.faces.resize(count);
+    halfEdges_.mates.resize(count);
+
+    // Полигон каждого полуребра
+    pool_.parallelFor(faceCount, [&](size_t begin, size_t end){
+        for(size_t f = begin; f < end; f++)
+        {
+            for(unsigned h = mesh_.faceOffsets[f]; h < mesh_.faceOffsets[f + 1]; h++) halfEdges_.faces[h] = static_cast<unsigned>(f);
+        }
+    });
+
+    auto keyOf = [&](unsigned h){
+        return EdgeKey<Index>(mesh_.vertices[h].posIdx, mesh_.vertices[next(h)].posIdx);
+    };
+
+    // Фрагменты полуребер раскладывают их по корзинам (по старшим битам хеша ключа). Первый проход считает размеры
+    // корзин каждого фрагмента, поэтому все корзины лежат в одном массиве точного размера
+    const unsigned bucketCount = pool_.threadCount() * 4;
+    const unsigned chunkCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(bucketCount, count / MIN_CHUNK_ELEMENTS)));
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    auto bucketOf = [&](const Key& key){ return static_cast<unsigned>((MixKey(key) >> 32u) % bucketCount); };
+
+    std::vector<size_t> offsets(static_cast<size_t>(bucketCount) * chunkCount + 1, 0);
+    pool_.run(chunkCount, [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        std::vector<size_t> counts(bucketCount, 0);
+        for(size_t h = begin; h < end; h++) counts[bucketOf(keyOf(static_cast<unsigned>(h)))]++;
+        for(unsigned b = 0; b < bucketCount; b++) offsets[static_cast<size_t>(b) * chunkCount + c + 1] = counts[b];
+    });
+    for(size_t i = 1; i < offsets.size(); i++) offsets[i] += offsets[i - 1];
+
+    std::vector<KeyedHalfEdge<Key>> items(count);
+    pool_.run(chunkCount, [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        std::vector<size_t> cursors(bucketCount);
+        for(unsigned b = 0; b < bucketCount; b++) cursors[b] = offsets[static_cast<size_t>(b) * chunkCount + c];
+        for(size_t h = begin; h < end; h++)
+        {
+            const Key key = keyOf(static_cast<unsigned>(h));
+            items[cursors[bucketOf(key)]++] = {key, static_cast<unsigned>(h)};
+        }
+    });
+
+    // Корзины сортируются параллельно, полуребра одного ребра (идут подряд) связываются в цикл
+    pool_.run(bucketCount, [&](unsigned b){
+        const size_t first = offsets[static_cast<size_t>(b) * chunkCount];
+        const size_t last = offsets[static_cast<size_t>(b + 1) * chunkCount];
+        std::sort(items.begin() + static_cast<ptrdiff_t>(first), items.begin() + static_cast<ptrdiff_t>(last));
+
+        for(size_t run = first; run < last;)
+        {
+            size_t runEnd = run + 1;
+            while(runEnd < last && items[runEnd].key == items[run].key) runEnd++;
+            for(size_t i = run; i < runEnd; i++)
+            {
+                halfEdges_.mates[items[i].halfEdge] = items[i + 1 < runEnd ? i + 1 : run].halfEdge;
+            }
+            run = runEnd;
+        }
+    });
+
+    return halfEdges_;
+}
+
+template<typename Index>
+bool MeshTopology<Index>::sameUvEdge(unsigned h, unsigned mate) const
+{
+    const auto& a0 = mesh_.vertices[h];
+    const auto& a1 = mesh_.vertices[next(h)];
+    const auto& b0 = mesh_.vertices[mate];
+    const auto& b1 = mesh_.vertices[next(mate)];
+    return (a0 == b0 && a1 == b1) || (a0 == b1 && a1 == b0);
+}
+
+template<typename Index>
+EdgeCounts MeshTopology<Index>::countEdges()
+{
+    const HalfEdges& halfEdges = this->halfEdges();
+
+    // Ребро считается в наименьшем полуребре своего цикла
+    std::atomic<size_t> edges{0}, boundary{0}, nonManifold{0}, seams{0};
+    pool_.parallelFor(halfEdges.count(), [&](size_t begin, size_t end){
+        EdgeCounts local;
+        for(size_t i = begin; i < end; i++)
+        {
+            const unsigned h = static_cast<unsigned>(i);
+            unsigned size = 1;
+            bool smallest = true;
+            for(unsigned m = halfEdges.mates[h]; m != h && smallest; m = halfEdges.mates[m], size++) smallest = m > h;
+            if(!smallest) continue;
+
+            local.edges++;
+            if(size == 1) local.boundary++;
+            else if(size > 2) local.nonManifold++;
+            else if(!sameUvEdge(h, halfEdges.mates[h])) local.seams++;
+        }
+        edges += local.edges;
+        boundary += local.boundary;
+        nonManifold += local.nonManifold;
+        seams += local.seams;
+    }, MIN_CHUNK_ELEMENTS);
+
+    EdgeCounts counts;
+    counts.edges = edges;
+    counts.boundary = boundary;
+    counts.nonManifold = nonManifold;
+    counts.seams = seams;
+    return counts;
+}
+
+template class MeshTopology<uint16_t>;
+template class MeshTopology<uint32_t>;
+template class MeshTopology<uint64_t>;
@@ -0,0 +1,117 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Смежность полигонов (полуребра).
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Полуребра меша
+ *
+ * \details Полуребро h - вершина h массива вершин меша и ребро от нее к следующей вершине того же полигона, поэтому
+ * отдельно хранятся только полигон полуребра и следующее полуребро того же ребра (по положениям вершин, независимо
+ * от UV и направления обхода). Полуребра одного ребра образуют цикл: у граничного ребра - из одного полуребра, у
+ * обычного - из двух, у неманифолдного - из трех и более. Память: 8 байт на вершину полигона (24 байта на
+ * треугольник, 32 - на четырехугольник), при построении временно еще 16-24 байта на вершину
+ */
+struct HalfEdges
+{
+    /// Полигон каждого полуребра
+    std::vector<unsigned> faces;
+    /// Следующее полуребро того же ребра (равно самому полуребру - ребро граничное)
+    std::vector<unsigned> mates;
+
+    [[nodiscard]] size_t count() const { return faces.size(); }
+
+    /**
+     * \brief Граничное ли ребро (принадлежит одному полигону)
+     */
+    [[nodiscard]] bool boundary(unsigned h) const { return mates[h] == h; }
+
+    /**
+     * \brief Обычное ли ребро (принадлежит ровно двум полигонам)
+     */
+    [[nodiscard]] bool manifold(unsigned h) const { return mates[h] != h && mates[mates[h]] == h; }
+};
+
+/**
+ * \brief Кол-во ребер меша по видам
+ */
+struct EdgeCounts
+{
+    /// Всего ребер
+    size_t edges = 0;
+    /// Граничных (один полигон)
+    size_t boundary = 0;
+    /// Неманифолдных (три полигона и более)
+    size_t nonManifold = 0;
+    /// Швов развертки (обычное ребро, у полигонов которого разные UV-индексы на концах ребра)
+    size_t seams = 0;
+};
+
+/**
+ * \brief Смежность полигонов меша, строится при первом обращении
+ *
+ * \details Меш должен оставаться неизменным до последнего обращения. Обращения - только из одного потока. Определен
+ * для uint16_t, uint32_t и uint64_t индексов
+ */
+template<typename Index>
+class MeshTopology
+{
+public:
+    /**
+     * \brief Создать (без построения)
+     * \param mesh Меш
+     * \param pool Пул потоков
+     */
+    MeshTopology(const BasicMesh<Index>& mesh, ThreadPool& pool);
+
+    /**
+     * \brief Полуребра
+     *
+     * \details Полуребра раскладываются по корзинам по хешу ключа ребра (упорядоченная пара индексов положений),
+     * корзины сортируются параллельно, подряд идущие полуребра с одним ключом связываются в цикл
+     */
+    const HalfEdges& halfEdges();
+
+    /**
+     * \brief Построена ли смежность
+     */
+    [[nodiscard]] bool built() const { return built_; }
+
+    /**
+     * \brief Следующее полуребро того же полигона
+     */
+    [[nodiscard]] unsigned next(unsigned h) const
+    {
+        const unsigned f = halfEdges_.faces[h];
+        return h + 1 < mesh_.faceOffsets[f + 1] ? h + 1 : mesh_.faceOffsets[f];
+    }
+
+    /**
+     * \brief Совпадают ли у смежных полуребер и UV-индексы (ребро не является швом развертки)
+     * \param h Полуребро
+     * \param mate Полуребро того же ребра
+     * \return Совпадают ли концы ребер по положению и UV
+     */
+    [[nodiscard]] bool sameUvEdge(unsigned h, unsigned mate) const;
+
+    /**
+     * \brief Посчитать ребра по видам (строит смежность, если она еще не построена)
+     * \return Кол-во ребер
+     */
+    EdgeCounts countEdges();
+
+private:
+    const BasicMesh<Index>& mesh_;
+    ThreadPool& pool_;
+
+    HalfEdges halfEdges_;
+    bool built_ = false;
+};
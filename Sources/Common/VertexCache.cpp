@@ -0,0 +1,313 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Порядок полигонов для кеша вершин.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "VertexCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    /// Минимальное кол-во групп в диапазоне при параллельной обработке
+    const size_t MIN_CHUNK_GROUPS = 16;
+
+    /// Размер моделируемого LRU кеша вершин
+    const unsigned CACHE_SIZE = 32;
+
+    /// Размер FIFO кеша, по которому считается ACMR
+    const size_t FIFO_CACHE_SIZE = 16;
+
+    /// Степень убывания оценки вершины с удалением от начала кеша
+    const float CACHE_DECAY_POWER = 1.5f;
+
+    /// Оценка вершин последнего выведенного полигона
+    const float LAST_FACE_SCORE = 0.75f;
+
+    /// Множитель и степень прибавки к оценке вершины с малым кол-вом оставшихся полигонов
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    /// Кол-во заранее посчитанных прибавок (по кол-ву оставшихся полигонов)
+    const unsigned VALENCE_TABLE_SIZE = 64;
+
+    /// Нет полигона
+    const unsigned NO_FACE = std::numeric_limits<unsigned>::max();
+
+    /**
+     * \brief Таблицы оценок вершин
+     */
+    struct ScoreTable
+    {
+        float cache[CACHE_SIZE] = {};
+        float valence[VALENCE_TABLE_SIZE] = {};
+
+        ScoreTable()
+        {
+            for(unsigned i = 0; i < CACHE_SIZE; i++)
+            {
+                cache[i] = i < 3 ? LAST_FACE_SCORE : std::pow(1.0f - static_cast<float>(i - 3) / static_cast<float>(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+            }
+            for(unsigned i = 1; i < VALENCE_TABLE_SIZE; i++)
+            {
+                valence[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+            }
+        }
+
+        /**
+         * \brief Оценка вершины
+         * \param position Место в кеше (-1 - не в кеше)
+         * \param remaining Кол-во оставшихся полигонов вершины
+         * \param lastFaceSize Кол-во вершин последнего выведенного полигона (они в начале кеша)
+         * \return Оценка
+         */
+        [[nodiscard]] float score(int position, unsigned remaining, unsigned lastFaceSize) const
+        {
+            if(remaining == 0) return 0.0f;
+            float result = 0.0f;
+            if(position >= 0) result = static_cast<unsigned>(position) < lastFaceSize ? LAST_FACE_SCORE : cache[position];
+            return result + (remaining < VALENCE_TABLE_SIZE ? valence[remaining]
+                                                            : VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER));
+        }
+    };
+
+    /**
+     * \brief Вершина угла полигона (для сопоставления одинаковых вершин группы)
+     */
+    template<typename Index>
+    struct CornerKey
+    {
+        Index posIdx;
+        Index uvIdx;
+        unsigned corner;
+    };
+
+    /**
+     * \brief Рабочие массивы (переиспользуются между группами одного диапазона)
+     */
+    struct Workspace
+    {
+        /// Смещения начала углов каждого полигона группы
+        std::vector<unsigned> cornerOffsets;
+        /// Вершина (номер внутри группы) каждого угла
+        std::vector<unsigned> cornerVertex;
+        /// Смещения начала полигонов каждой вершины
+        std::vector<unsigned> vertexOffsets;
+        /// Полигоны вершин (невыведенные идут первыми)
+        std::vector<unsigned> vertexFaces;
+        /// Кол-во невыведенных полигонов каждой вершины
+        std::vector<unsigned> remaining;
+        /// Оценки вершин и полигонов
+        std::vector<float> vertexScores;
+        std::vector<float> faceScores;
+        /// Выведен ли полигон
+        std::vector<uint8_t> emitted;
+        /// Метки вершин (шаг, на котором вершина попала в кеш, либо время попадания в FIFO кеш)
+        std::vector<size_t> marks;
+        /// Кеш до и после вывода полигона
+        std::vector<unsigned> cache;
+        std::vector<unsigned> nextCache;
+        /// Новый порядок полигонов группы
+        std::vector<unsigned> order;
+        /// Исходные полигоны группы
+        std::vector<unsigned> polygons;
+    };
+
+    /**
+     * \brief Кол-во промахов FIFO кеша при выводе полигонов группы в заданном порядке
+     * \param ws Рабочие массивы (углы и вершины группы)
+     * \param order Порядок полигонов (nullptr - исходный)
+     * \param faceCount Кол-во полигонов
+     * \param vertexCount Кол-во вершин группы
+     * \return Кол-во промахов
+     */
+    size_t CountMisses(Workspace& ws, const unsigned* order, unsigned faceCount, unsigned vertexCount)
+    {
+        ws.marks.assign(vertexCount, 0);
+        size_t time = FIFO_CACHE_SIZE + 1;
+        size_t misses = 0;
+        for(unsigned i = 0; i < faceCount; i++)
+        {
+            const unsigned f = order ? order[i] : i;
+            for(unsigned c = ws.cornerOffsets[f]; c < ws.cornerOffsets[f + 1]; c++)
+            {
+                const unsigned v = ws.cornerVertex[c];
+                if(time - ws.marks[v] > FIFO_CACHE_SIZE){
+                    ws.marks[v] = time++;
+                    misses++;
+                }
+            }
+        }
+        return misses;
+    }
+
+    /**
+     * \brief Порядок полигонов группы по алгоритму Forsyth (результат в ws.order)
+     * \param ws Рабочие массивы (углы и вершины группы)
+     * \param table Таблицы оценок
+     * \param faceCount Кол-во полигонов
+     * \param vertexCount Кол-во вершин группы
+     */
+    void ForsythOrder(Workspace& ws, const ScoreTable& table, unsigned faceCount, unsigned vertexCount)
+    {
+        // Полигоны каждой вершины
+        ws.vertexOffsets.assign(vertexCount + 1, 0);
+        for(unsigned c = 0; c < ws.cornerOffsets[faceCount]; c++) ws.vertexOffsets[ws.cornerVertex[c] + 1]++;
+        for(unsigned v = 0; v < vertexCount; v++) ws.vertexOffsets[v + 1] += ws.vertexOffsets[v];
+        ws.vertexFaces.resize(ws.cornerOffsets[faceCount]);
+        ws.remaining.assign(vertexCount, 0);
+        for(unsigned f = 0; f < faceCount; f++)
+        {
+            for(unsigned c = ws.cornerOffsets[f]; c < ws.cornerOffsets[f + 1]; c++)
+            {
+                const unsigned v = ws.cornerVertex[c];
+                ws.vertexFaces[ws.vertexOffsets[v] + ws.remaining[v]++] = f;
+            }
+        }
+
+        // Начальные оценки (кеш пуст)
+        ws.vertexScores.resize(vertexCount);
+        for(unsigned v = 0; v < vertexCount; v++) ws.vertexScores[v] = table.score(-1, ws.remaining[v], 0);
+        ws.faceScores.assign(faceCount, 0.0f);
+        unsigned best = 0;
+        for(unsigned f = 0; f < faceCount; f++)
+        {
+            for(unsigned c = ws.cornerOffsets[f]; c < ws.cornerOffsets[f + 1]; c++) ws.faceScores[f] += ws.vertexScores[ws.cornerVertex[c]];
+            if(ws.faceScores[f] > ws.faceScores[best]) best = f;
+        }
+
+        ws.emitted.assign(faceCount, 0);
+        ws.marks.assign(vertexCount, 0);
+        ws.cache.clear();
+        ws.order.clear();
+        unsigned cursor = 0;
+        for(unsigned step = 1; step <= faceCount; step++)
+        {
+            // Кандидатов в кеше нет - следующий полигон исходного порядка
+            if(best == NO_FACE){
+                while(ws.emitted[cursor]) cursor++;
+                best = cursor;
+            }
+            ws.emitted[best] = 1;
+            ws.order.push_back(best);
+
+            // Вершины полигона уходят в начало кеша, полигон исключается из их списков
+            ws.nextCache.clear();
+            for(unsigned c = ws.cornerOffsets[best]; c < ws.cornerOffsets[best + 1]; c++)
+            {
+                const unsigned v = ws.cornerVertex[c];
+                unsigned* faces = ws.vertexFaces.data() + ws.vertexOffsets[v];
+                const unsigned* last = faces + ws.remaining[v];
+                unsigned* found = std::find(faces, faces + ws.remaining[v], best);
+                if(found != last){
+                    *found = *(last - 1);
+                    ws.remaining[v]--;
+                }
+                if(ws.marks[v] != step){
+                    ws.marks[v] = step;
+                    ws.nextCache.push_back(v);
+                }
+            }
+            const auto lastFaceSize = static_cast<unsigned>(ws.nextCache.size());
+            for(unsigned v : ws.cache) if(ws.marks[v] != step) ws.nextCache.push_back(v);
+
+            // Новые оценки вершин кеша (и вытесненных) и их невыведенных полигонов
+            for(size_t i = 0; i < ws.nextCache.size(); i++)
+            {
+                const unsigned v = ws.nextCache[i];
+                const float score = table.score(i < CACHE_SIZE ? static_cast<int>(i) : -1, ws.remaining[v], lastFaceSize);
+                const float delta = score - ws.vertexScores[v];
+                ws.vertexScores[v] = score;
+                for(unsigned k = 0; k < ws.remaining[v]; k++) ws.faceScores[ws.vertexFaces[ws.vertexOffsets[v] + k]] += delta;
+            }
+            if(ws.nextCache.size() > CACHE_SIZE) ws.nextCache.resize(CACHE_SIZE);
+
+            // Лучший из полигонов вершин кеша
+            best = NO_FACE;
+            float bestScore = -1.0f;
+            for(unsigned v : ws.nextCache)
+            {
+                for(unsigned k = 0; k < ws.remaining[v]; k++)
+                {
+                    const unsigned f = ws.vertexFaces[ws.vertexOffsets[v] + k];
+                    if(ws.faceScores[f] > bestScore){
+                        bestScore = ws.faceScores[f];
+                        best = f;
+                    }
+                }
+            }
+            ws.cache.swap(ws.nextCache);
+        }
+    }
+}
+
+template<typename Index>
+FaceOrderStats OptimizeFaceOrder(const BasicMesh<Index>& mesh, GroupMembers& groups, ThreadPool& pool)
+{
+    const unsigned groupCount = groups.groupCount();
+    const ScoreTable table;
+    std::vector<size_t> triangles(groupCount, 0), missesBefore(groupCount, 0), missesAfter(groupCount, 0);
+    std::vector<uint8_t> reordered(groupCount, 0);
+
+    pool.parallelFor(groupCount, [&](size_t begin, size_t end){
+        Workspace ws;
+        std::vector<CornerKey<Index>> keys;
+        for(size_t g = begin; g < end; g++)
+        {
+            const unsigned first = groups.offsets[g];
+            const unsigned faceCount = groups.offsets[g + 1] - first;
+
+            // Углы полигонов и вершины группы (одинаковые пары положения и текстурных координат)
+            keys.clear();
+            ws.cornerOffsets.assign(1, 0);
+            for(unsigned f = 0; f < faceCount; f++)
+            {
+                const auto polygon = mesh.polygon(groups.polygons[first + f]);
+                for(const auto& v : polygon) keys.push_back({v.posIdx, v.uvIdx, static_cast<unsigned>(keys.size())});
+                ws.cornerOffsets.push_back(static_cast<unsigned>(keys.size()));
+                if(polygon.size() >= 3) triangles[g] += polygon.size() - 2;
+            }
+            std::sort(keys.begin(), keys.end(), [](const CornerKey<Index>& a, const CornerKey<Index>& b){
+                return a.posIdx != b.posIdx ? a.posIdx < b.posIdx : a.uvIdx < b.uvIdx;
+            });
+            ws.cornerVertex.resize(keys.size());
+            unsigned vertexCount = 0;
+            for(size_t k = 0; k < keys.size(); k++)
+            {
+                if(k > 0 && (keys[k].posIdx != keys[k - 1].posIdx || keys[k].uvIdx != keys[k - 1].uvIdx)) vertexCount++;
+                ws.cornerVertex[keys[k].corner] = vertexCount;
+            }
+            if(!keys.empty()) vertexCount++;
+
+            missesBefore[g] = missesAfter[g] = CountMisses(ws, nullptr, faceCount, vertexCount);
+            if(faceCount < 3) continue;
+
+            // Новый порядок сохраняется, только если промахов стало меньше
+            ForsythOrder(ws, table, faceCount, vertexCount);
+            const size_t misses = CountMisses(ws, ws.order.data(), faceCount, vertexCount);
+            if(misses >= missesBefore[g]) continue;
+            ws.polygons.assign(groups.polygons.begin() + first, groups.polygons.begin() + first + faceCount);
+            for(unsigned f = 0; f < faceCount; f++) groups.polygons[first + f] = ws.polygons[ws.order[f]];
+            missesAfter[g] = misses;
+            reordered[g] = 1;
+        }
+    }, MIN_CHUNK_GROUPS);
+
+    FaceOrderStats stats;
+    for(unsigned g = 0; g < groupCount; g++)
+    {
+        stats.triangleCount += triangles[g];
+        stats.missesBefore += missesBefore[g];
+        stats.missesAfter += missesAfter[g];
+        stats.reorderedGroups += reordered[g];
+    }
+    return stats;
+}
+
+template FaceOrderStats OptimizeFaceOrder(const Mesh16&, GroupMembers&, ThreadPool&);
+template FaceOrderStats OptimizeFaceOrder(const Mesh32&, GroupMembers&, ThreadPool&);
+template FaceOrderStats OptimizeFaceOrder(const Mesh64&, GroupMembers&, ThreadPool&);
@@ -0,0 +1,57 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Порядок полигонов для кеша вершин.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "Mesh.h"
+#include "Grouping.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Итоги упорядочивания полигонов
+ *
+ * \details ACMR (average cache miss ratio) - кол-во промахов кеша вершин на треугольник. Промахи считаются по
+ * FIFO кешу на 16 вершин, полигон из n вершин дает n - 2 треугольника
+ */
+struct FaceOrderStats
+{
+    /// Кол-во треугольников
+    size_t triangleCount = 0;
+    /// Промахи кеша при исходном порядке
+    size_t missesBefore = 0;
+    /// Промахи кеша при новом порядке
+    size_t missesAfter = 0;
+    /// Кол-во групп, порядок в которых изменен
+    unsigned reorderedGroups = 0;
+
+    [[nodiscard]] double acmrBefore() const
+    {
+        return triangleCount > 0 ? static_cast<double>(missesBefore) / static_cast<double>(triangleCount) : 0.0;
+    }
+
+    [[nodiscard]] double acmrAfter() const
+    {
+        return triangleCount > 0 ? static_cast<double>(missesAfter) / static_cast<double>(triangleCount) : 0.0;
+    }
+};
+
+/**
+ * \brief Упорядочить полигоны внутри каждой группы для кеша вершин (алгоритм Forsyth)
+ *
+ * \details Вершина - пара индексов положения и текстурных координат. Полигоны выбираются жадно по сумме оценок
+ * вершин: вершины в начале LRU кеша (32 вершины) и вершины с малым кол-вом оставшихся полигонов оцениваются выше.
+ * Кандидаты - полигоны вершин кеша, если таких нет - следующий невыведенный полигон исходного порядка. Полигоны
+ * не разбиваются и не переходят в другие группы. Если новый порядок группы дает больше промахов, исходный
+ * сохраняется. Группы обрабатываются параллельно. Определена для uint16_t, uint32_t и uint64_t индексов
+ *
+ * \param mesh Меш
+ * \param groups Группы (порядок полигонов внутри групп меняется)
+ * \param pool Пул потоков
+ * \return Итоги
+ */
+template<typename Index>
+FaceOrderStats OptimizeFaceOrder(const BasicMesh<Index>& mesh, GroupMembers& groups, ThreadPool& pool);
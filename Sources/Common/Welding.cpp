@@ -0,0 +1,369 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Слияние совпадающих вершин.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#include "Welding.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    /// Минимальное кол-во элементов в диапазоне при параллельной обработке
+    const size_t MIN_CHUNK_ELEMENTS = 16384;
+
+    /// Наибольший номер ячейки по модулю (сосед ячейки не переполняет 64 бита)
+    const double MAX_CELL = 4.0e18;
+
+    /// Признак отсутствующей ячейки
+    const size_t NO_ITEM = std::numeric_limits<size_t>::max();
+
+    /// Сторона ячейки хеш-сетки в допусках
+    const double CELL_SIZE = 8.0;
+
+    /**
+     * \brief Ячейка хеш-сетки (номера по каждой компоненте)
+     */
+    struct Cell
+    {
+        int64_t c[3] = {0, 0, 0};
+    };
+
+    /**
+     * \brief Элемент, разложенный в корзину
+     */
+    struct CellItem
+    {
+        uint64_t hash;
+        unsigned element;
+
+        bool operator<(const CellItem& item) const
+        {
+            return hash < item.hash || (hash == item.hash && element < item.element);
+        }
+    };
+
+    /**
+     * \brief Перемешивание битов (splitmix64)
+     * \param key Ключ
+     * \return Хеш
+     */
+    uint64_t MixKey(uint64_t key)
+    {
+        key = (key ^ (key >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27u)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31u);
+    }
+
+    /**
+     * \brief Хеш ячейки
+     */
+    uint64_t CellHash(const Cell& cell)
+    {
+        return MixKey(static_cast<uint64_t>(cell.c[0]) ^ MixKey(static_cast<uint64_t>(cell.c[1]) ^ MixKey(static_cast<uint64_t>(cell.c[2]))));
+    }
+
+    /**
+     * \brief Найти корень множества (атомарная версия, сжатие пути делением пополам)
+     * \param parents Массив родителей
+     * \param i Элемент
+     * \return Корень
+     */
+    unsigned FindRootAtomic(std::vector<std::atomic<unsigned>>& parents, unsigned i)
+    {
+        while(true)
+        {
+            unsigned parent = parents[i].load(std::memory_order_relaxed);
+            if(parent == i) return i;
+
+            const unsigned grandParent = parents[parent].load(std::memory_order_relaxed);
+            if(parent != grandParent){
+                parents[i].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+            }
+            i = grandParent;
+        }
+    }
+
+    /**
+     * \brief Объединить множества (атомарная версия, корнем становится меньший индекс)
+     * \param parents Массив родителей
+     * \param a Первый элемент
+     * \param b Второй элемент
+     */
+    void UniteSetsAtomic(std::vector<std::atomic<unsigned>>& parents, unsigned a, unsigned b)
+    {
+        while(true)
+        {
+            a = FindRootAtomic(parents, a);
+            b = FindRootAtomic(parents, b);
+            if(a == b) return;
+            if(a < b) std::swap(a, b);
+
+            unsigned expected = a;
+            if(parents[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+        }
+    }
+
+    /**
+     * \brief Хеш-сетка над сравниваемыми компонентами координат
+     *
+     * \details Близкие элементы лежат в той же ячейке либо в соседней, если элемент ближе допуска к ее границе. Сторона
+     * ячейки в несколько допусков, поэтому у большинства элементов соседей проверять не нужно (у остальных - не больше
+     * 2^d соседних ячеек, а не 3^d)
+     */
+    class WeldGrid
+    {
+    public:
+        WeldGrid(const Coordinates& coordinates, unsigned dimensions, float epsilon) : dimensions_(dimensions), epsilon_(epsilon)
+        {
+            components_[0] = coordinates.x.data();
+            components_[1] = coordinates.y.data();
+            components_[2] = coordinates.z.data();
+        }
+
+        /**
+         * \brief Ячейка элемента (при нулевом допуске - биты компонент, -0 и 0 в одной ячейке)
+         * \param i Элемент
+         * \param sides Сторона соседней ячейки по каждой компоненте (-1, 1, 0 - близких соседей нет)
+         * \return Ячейка
+         */
+        Cell cellOf(size_t i, int* sides = nullptr) const
+        {
+            Cell cell;
+            for(unsigned d = 0; d < 3; d++)
+            {
+                if(sides) sides[d] = 0;
+                if(d >= dimensions_) continue;
+
+                const float value = components_[d][i];
+                if(epsilon_ > 0.0f){
+                    const double scaled = static_cast<double>(value) / (CELL_SIZE * epsilon_);
+                    const double floor = std::floor(scaled);
+                    const double inside = (scaled - floor) * CELL_SIZE;
+                    cell.c[d] = static_cast<int64_t>(std::min(MAX_CELL, std::max(-MAX_CELL, floor)));
+                    if(sides) sides[d] = inside <= 1.0 ? -1 : inside >= CELL_SIZE - 1.0 ? 1 : 0;
+                }else{
+                    const float normalized = value == 0.0f ? 0.0f : value;
+                    uint32_t bits;
+                    std::memcpy(&bits, &normalized, sizeof(bits));
+                    cell.c[d] = bits;
+                }
+            }
+            return cell;
+        }
+
+        /**
+         * \brief Отличаются ли все компоненты элементов не больше допуска
+         */
+        [[nodiscard]] bool near(size_t a, size_t b) const
+        {
+            for(unsigned d = 0; d < dimensions_; d++)
+            {
+                if(!(std::fabs(components_[d][a] - components_[d][b]) <= epsilon_)) return false;
+            }
+            return true;
+        }
+
+        /**
+         * \brief Совпадают ли элементы точно
+         */
+        [[nodiscard]] bool equal(size_t a, size_t b) const
+        {
+            for(unsigned d = 0; d < dimensions_; d++)
+            {
+                if(components_[d][a] != components_[d][b]) return false;
+            }
+            return true;
+        }
+
+    private:
+        const float* components_[3] = {};
+        unsigned dimensions_;
+        float epsilon_;
+    };
+
+    /**
+     * \brief Хеш-таблица с открытой адресацией: хеш ячейки -> первый элемент ячейки в отсортированной корзине
+     */
+    class CellTable
+    {
+    public:
+        CellTable() = default;
+
+        explicit CellTable(size_t expected)
+        {
+            size_t capacity = 16;
+            while(capacity < expected * 2) capacity <<= 1u;
+            hashes_.resize(capacity);
+            firsts_.assign(capacity, NO_ITEM);
+            mask_ = capacity - 1;
+        }
+
+        void insert(uint64_t hash, size_t first)
+        {
+            size_t slot = hash & mask_;
+            while(firsts_[slot] != NO_ITEM) slot = (slot + 1) & mask_;
+            hashes_[slot] = hash;
+            firsts_[slot] = first;
+        }
+
+        [[nodiscard]] size_t find(uint64_t hash) const
+        {
+            for(size_t slot = hash & mask_; firsts_[slot] != NO_ITEM; slot = (slot + 1) & mask_)
+            {
+                if(hashes_[slot] == hash) return firsts_[slot];
+            }
+            return NO_ITEM;
+        }
+
+    private:
+        std::vector<uint64_t> hashes_;
+        std::vector<size_t> firsts_;
+        size_t mask_ = 0;
+    };
+}
+
+WeldMap WeldCoordinates(const Coordinates& coordinates, unsigned dimensions, float epsilon, ThreadPool& pool)
+{
+    WeldMap map;
+    const size_t count = coordinates.count();
+    if(count < 2 || count >= std::numeric_limits<unsigned>::max() || !(epsilon >= 0.0f)) return map;
+
+    dimensions = std::min(dimensions, 3u);
+    const WeldGrid grid(coordinates, dimensions, epsilon);
+
+    // Фрагменты элементов раскладывают их по корзинам (по старшим битам хеша ячейки). Первый проход считает размеры
+    // корзин каждого фрагмента, поэтому все корзины лежат в одном массиве точного размера
+    const unsigned bucketCount = pool.threadCount() * 4;
+    const unsigned chunkCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(bucketCount, count / MIN_CHUNK_ELEMENTS)));
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    auto bucketOf = [&](uint64_t hash){ return static_cast<unsigned>((hash >> 32u) % bucketCount); };
+
+    std::vector<size_t> offsets(static_cast<size_t>(bucketCount) * chunkCount + 1, 0);
+    pool.run(chunkCount, [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        std::vector<size_t> counts(bucketCount, 0);
+        for(size_t i = begin; i < end; i++) counts[bucketOf(CellHash(grid.cellOf(i)))]++;
+        for(unsigned b = 0; b < bucketCount; b++) offsets[static_cast<size_t>(b) * chunkCount + c + 1] = counts[b];
+    });
+    for(size_t i = 1; i < offsets.size(); i++) offsets[i] += offsets[i - 1];
+
+    std::vector<CellItem> items(count);
+    pool.run(chunkCount, [&](unsigned c){
+        const size_t begin = c * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        std::vector<size_t> cursors(bucketCount);
+        for(unsigned b = 0; b < bucketCount; b++) cursors[b] = offsets[static_cast<size_t>(b) * chunkCount + c];
+        for(size_t i = begin; i < end; i++)
+        {
+            const uint64_t hash = CellHash(grid.cellOf(i));
+            items[cursors[bucketOf(hash)]++] = {hash, static_cast<unsigned>(i)};
+        }
+    });
+
+    // Корзины сортируются параллельно (элементы одной ячейки идут подряд по возрастанию номера), затем каждая
+    // корзина строит таблицу начал своих ячеек
+    std::vector<CellTable> tables(bucketCount);
+    pool.run(bucketCount, [&](unsigned b){
+        const size_t first = offsets[static_cast<size_t>(b) * chunkCount];
+        const size_t last = offsets[static_cast<size_t>(b + 1) * chunkCount];
+        std::sort(items.begin() + static_cast<ptrdiff_t>(first), items.begin() + static_cast<ptrdiff_t>(last));
+
+        tables[b] = CellTable(last - first);
+        for(size_t i = first; i < last; i++)
+        {
+            if(i == first || items[i].hash != items[i - 1].hash) tables[b].insert(items[i].hash, i);
+        }
+    });
+
+    // Каждый элемент объединяется с близкими элементами своей и соседних ячеек с меньшими номерами (элементы других
+    // ячеек с тем же хешем отсеиваются сравнением координат)
+    std::vector<std::atomic<unsigned>> parents(count);
+    pool.parallelFor(count, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++) parents[i].store(static_cast<unsigned>(i), std::memory_order_relaxed);
+    }, MIN_CHUNK_ELEMENTS);
+
+    pool.parallelFor(count, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++)
+        {
+            const unsigned element = static_cast<unsigned>(i);
+            int sides[3];
+            const Cell cell = grid.cellOf(i, sides);
+
+            // Точная копия предыдущего элемента своей ячейки совпадает со всем, с чем совпадает он (множество точных
+            // копий не сравнивается попарно)
+            const uint64_t hash = CellHash(cell);
+            size_t self = tables[bucketOf(hash)].find(hash);
+            while(items[self].element != element) self++;
+            if(self > 0 && items[self - 1].hash == hash && grid.equal(items[self - 1].element, i)){
+                UniteSetsAtomic(parents, items[self - 1].element, element);
+                continue;
+            }
+
+            for(unsigned mask = 0; mask < 8u; mask++)
+            {
+                Cell neighbour = cell;
+                bool skip = false;
+                for(unsigned d = 0; d < 3; d++)
+                {
+                    if(!(mask & (1u << d))) continue;
+                    if(sides[d] == 0) skip = true;
+                    neighbour.c[d] += sides[d];
+                }
+                if(skip) continue;
+
+                const uint64_t neighbourHash = CellHash(neighbour);
+                const size_t first = tables[bucketOf(neighbourHash)].find(neighbourHash);
+                if(first == NO_ITEM) continue;
+                for(size_t k = first; k < count && items[k].hash == neighbourHash && items[k].element < element; k++)
+                {
+                    if(grid.near(items[k].element, i)) UniteSetsAtomic(parents, items[k].element, element);
+                }
+            }
+        }
+    }, MIN_CHUNK_ELEMENTS);
+    std::vector<CellItem>().swap(items);
+
+    // Канонический номер - корень множества (наименьший номер среди совпадающих)
+    map.canonical.resize(count);
+    std::atomic<size_t> welded{0};
+    pool.parallelFor(count, [&](size_t begin, size_t end){
+        size_t local = 0;
+        for(size_t i = begin; i < end; i++)
+        {
+            map.canonical[i] = FindRootAtomic(parents, static_cast<unsigned>(i));
+            if(map.canonical[i] != i) local++;
+        }
+        welded.fetch_add(local, std::memory_order_relaxed);
+    }, MIN_CHUNK_ELEMENTS);
+
+    map.weldedCount = welded.load();
+    if(map.weldedCount == 0) std::vector<unsigned>().swap(map.canonical);
+    return map;
+}
+
+template<typename Index>
+void RemapIndices(BasicMesh<Index>& mesh, const WeldMap& map, LineType type, ThreadPool& pool)
+{
+    if(map.canonical.empty()) return;
+
+    const size_t count = map.canonical.size();
+    pool.parallelFor(mesh.vertices.size(), [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++)
+        {
+            Index& index = type == eLinePosition ? mesh.vertices[i].posIdx : mesh.vertices[i].uvIdx;
+            if(index == 0 || index > count) continue;
+            index = static_cast<Index>(map.canonical[index - 1] + 1);
+        }
+    }, MIN_CHUNK_ELEMENTS);
+}
+
+template void RemapIndices(Mesh16&, const WeldMap&, LineType, ThreadPool&);
+template void RemapIndices(Mesh32&, const WeldMap&, LineType, ThreadPool&);
+template void RemapIndices(Mesh64&, const WeldMap&, LineType, ThreadPool&);
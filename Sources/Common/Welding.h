@@ -0,0 +1,53 @@
+/**
+ * Генератор материалов для импорта в Serious Modeller (Serious Engine 1). Слияние совпадающих вершин.
+ * Copyright (C) 2020 by Alex "DarkWolf" Nem - https://github.com/darkoffalex
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Mesh.h"
+#include "Geometry.h"
+#include "LineIndex.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief Канонические номера совпадающих координат
+ */
+struct WeldMap
+{
+    /// Канонический номер каждого элемента (наименьший номер среди совпадающих с ним, с 0). Пусто - слияния не было
+    std::vector<unsigned> canonical;
+    /// Кол-во элементов, замененных каноническими
+    size_t weldedCount = 0;
+};
+
+/**
+ * \brief Найти совпадающие (с допуском) координаты
+ *
+ * \details Координаты раскладываются по ячейкам пространственной хеш-сетки (сторона - несколько допусков), поэтому
+ * близкие координаты лежат в той же либо в соседней ячейке. Ячейки распределяются по корзинам (по старшим битам хеша),
+ * корзины сортируются и индексируются хеш-таблицами параллельно. Затем каждый элемент параллельно сравнивается с
+ * элементами своей и соседних ячеек и объединяется с теми, все компоненты которых отличаются не больше допуска.
+ * Совпадение транзитивно: цепочка близких элементов сливается в один. Нулевой допуск - только точные совпадения.
+ * Больше 2^32 - 1 элементов не обрабатывается
+ *
+ * \param coordinates Координаты
+ * \param dimensions Кол-во сравниваемых компонент (3 - x, y, z, 2 - x, y)
+ * \param epsilon Допуск
+ * \param pool Пул потоков
+ * \return Канонические номера
+ */
+WeldMap WeldCoordinates(const Coordinates& coordinates, unsigned dimensions, float epsilon, ThreadPool& pool);
+
+/**
+ * \brief Заменить индексы вершин меша каноническими
+ * \param mesh Меш
+ * \param map Канонические номера (WeldCoordinates)
+ * \param type Заменяемые индексы (eLinePosition - положения, eLineTexCoord - текстурные координаты)
+ * \param pool Пул потоков
+ */
+template<typename Index>
+void RemapIndices(BasicMesh<Index>& mesh, const WeldMap& map, LineType type, ThreadPool& pool);